@@ -24,47 +24,144 @@
 #define GCLK0_HZ 120000000
 #define TIMER_PRESCALER_DIV 1024
 
-void (*func0)();
-void (*func1)();
-void (*func2)();
-void (*func3)();
-void (*func4)();
-void (*func5)();
+static Tc * const tc_instances[TC_TIMER_COUNT] = {TC0, TC1, TC2, TC3, TC4, TC5};
+static const IRQn_Type tc_irqs[TC_TIMER_COUNT] = {TC0_IRQn, TC1_IRQn, TC2_IRQn,
+                                                  TC3_IRQn, TC4_IRQn, TC5_IRQn};
+static const int tc_gclk_ids[TC_TIMER_COUNT] = {TC0_GCLK_ID, TC1_GCLK_ID, TC2_GCLK_ID,
+                                                TC3_GCLK_ID, TC4_GCLK_ID, TC5_GCLK_ID};
+
+// Callbacks of the default handlers, set by TC_Timer::startTimer()
+static void (* volatile tc_callbacks[TC_TIMER_COUNT])();
+
+
+void tc_start(Tc *tc, int gclk_id, IRQn_Type irq, bool interrupt) {
+  // Enable the TC bus clock, use clock generator 0
+  GCLK->PCHCTRL[gclk_id].reg = GCLK_PCHCTRL_GEN_GCLK0_Val |
+                               (1 << GCLK_PCHCTRL_CHEN_Pos);
+  while (GCLK->SYNCBUSY.reg > 0);
+
+  tc->COUNT16.CTRLA.bit.ENABLE = 0;
+
+  // Use match mode so that the timer counter resets when the count matches the
+  // compare register
+  tc->COUNT16.WAVE.bit.WAVEGEN = TC_WAVE_WAVEGEN_MFRQ;
+  tc_wait_for_sync(tc);
+
+  // Enable the compare interrupt, unless the timer is only used to
+  // trigger other peripherals (e.g. DMA)
+  tc->COUNT16.INTENSET.reg = 0;
+  if (interrupt) {
+    tc->COUNT16.INTENSET.bit.MC0 = 1;
+
+    // Enable IRQ
+    NVIC_EnableIRQ(irq);
+  } else {
+    tc->COUNT16.INTENCLR.bit.MC0 = 1;
+  }
+}
 
-void TC_Timer::TC_wait_for_sync() {
-  switch (TC_num) {
-    case 0:
-      while (TC0->COUNT16.SYNCBUSY.reg != 0) {}
-      break;
-    case 1:
-      while (TC1->COUNT16.SYNCBUSY.reg != 0) {}
-      break;
-    case 2:
-      while (TC2->COUNT16.SYNCBUSY.reg != 0) {}
-      break;
-    case 3:
-      while (TC3->COUNT16.SYNCBUSY.reg != 0) {}
-      break;
-    case 4:
-      while (TC4->COUNT16.SYNCBUSY.reg != 0) {}
-      break;
-    case 5:
-      while (TC5->COUNT16.SYNCBUSY.reg != 0) {}
-      break;
+void tc_stop(Tc *tc) {
+  tc->COUNT16.CTRLA.bit.ENABLE = 0;
+}
+
+// Prescaler bits and compare value that give a period in 10s of ns
+static void tc_period_settings(unsigned long period, uint32_t *prescaler_bits, int *compare) {
+  int prescaler;
+  uint32_t TC_CTRLA_PRESCALER_DIVN;
+
+  if (period > 300000) {
+    TC_CTRLA_PRESCALER_DIVN = TC_CTRLA_PRESCALER_DIV1024;
+    prescaler = 1024;
+  } else if (80000 < period && period <= 300000) {
+    TC_CTRLA_PRESCALER_DIVN = TC_CTRLA_PRESCALER_DIV256;
+    prescaler = 256;
+  } else if (20000 < period && period <= 80000) {
+    TC_CTRLA_PRESCALER_DIVN = TC_CTRLA_PRESCALER_DIV64;
+    prescaler = 64;
+  } else if (10000 < period && period <= 20000) {
+    TC_CTRLA_PRESCALER_DIVN = TC_CTRLA_PRESCALER_DIV16;
+    prescaler = 16;
+  } else if (5000 < period && period <= 10000) {
+    TC_CTRLA_PRESCALER_DIVN = TC_CTRLA_PRESCALER_DIV8;
+    prescaler = 8;
+  } else if (2500 < period && period <= 5000) {
+    TC_CTRLA_PRESCALER_DIVN = TC_CTRLA_PRESCALER_DIV4;
+    prescaler = 4;
+  } else if (1000 < period && period <= 2500) {
+    TC_CTRLA_PRESCALER_DIVN = TC_CTRLA_PRESCALER_DIV2;
+    prescaler = 2;
+  } else {
+    TC_CTRLA_PRESCALER_DIVN = TC_CTRLA_PRESCALER_DIV1;
+    prescaler = 1;
+  }
+
+  // int compareValue = (int)(GCLK1_HZ / (prescaler/((float)period / 1000000))) - 1;
+  *compare = (int)(GCLK0_HZ / (prescaler/((float)period / 100000000))) - 1;
+  *prescaler_bits = TC_CTRLA_PRESCALER_DIVN;
+}
+
+void tc_set_period(Tc *tc, unsigned long period) {
+  uint32_t TC_CTRLA_PRESCALER_DIVN;
+  int compareValue;
+
+  tc_period_settings(period, &TC_CTRLA_PRESCALER_DIVN, &compareValue);
+
+  tc->COUNT16.CTRLA.reg &= ~TC_CTRLA_ENABLE;
+  tc_wait_for_sync(tc);
+  tc->COUNT16.CTRLA.reg &= ~TC_CTRLA_PRESCALER_Msk;
+  tc_wait_for_sync(tc);
+
+  tc->COUNT16.CTRLA.reg |= TC_CTRLA_PRESCALER_DIVN;
+  tc_wait_for_sync(tc);
+
+  // Make sure the count is in a proportional position to where it was
+  // to prevent any jitter or disconnect when changing the compare value.
+  tc->COUNT16.COUNT.reg = map(tc->COUNT16.COUNT.reg, 0,
+                              tc->COUNT16.CC[0].reg, 0, compareValue);
+  tc->COUNT16.CC[0].reg = compareValue;
+  tc_wait_for_sync(tc);
+
+  tc->COUNT16.CTRLA.bit.ENABLE = 1;
+  tc_wait_for_sync(tc);
+}
+
+// Change the period of a running timer without stopping it. When the
+// prescaler stays the same only the buffered compare register is written, and
+// the hardware switches to the new period at the next overflow. Otherwise
+// (or if the timer is stopped) this falls back to tc_set_period().
+void tc_retune(Tc *tc, unsigned long period) {
+  uint32_t prescaler_bits;
+  int compare;
+
+  tc_period_settings(period, &prescaler_bits, &compare);
+
+  if (tc->COUNT16.CTRLA.bit.ENABLE &&
+      (tc->COUNT16.CTRLA.reg & TC_CTRLA_PRESCALER_Msk) == prescaler_bits) {
+    tc->COUNT16.CCBUF[0].reg = compare;
+  } else {
+    tc_set_period(tc, period);
   }
 }
 
+
+void TC_Timer::TC_wait_for_sync() {
+  tc_wait_for_sync(tc_instances[TC_num]);
+}
+
 TC_Timer::TC_Timer() {
   this -> TC_num = 3;
 }
 
 TC_Timer::TC_Timer(int TC_num) {
   this -> TC_num = TC_num;
+  if (!(TC_num >= 0 && TC_num < TC_TIMER_COUNT)) {
+    this -> TC_num = 3;
+  }
 }
 
 void TC_Timer::setTCNumber(int n) {
   this -> TC_num = n;
-  if (!(n >= 0 && n <= 5)) {
+  if (!(n >= 0 && n < TC_TIMER_COUNT)) {
     Serial.println("**** WARNING: unsupported TC number (must be 0 - 5) ****");
     this -> TC_num = 3;
   }
@@ -74,603 +171,79 @@ int TC_Timer::getTCNumber() {
   return this -> TC_num;
 }
 
+// Pass f = NULL to run the timer without an interrupt, e.g. to pace DMA
 void TC_Timer::startTimer(unsigned long period, void (*f)()) {
-  // Enable the TC bus clock, use clock generator 1
-  // GCLK->PCHCTRL[TC3_GCLK_ID].reg = GCLK_PCHCTRL_GEN_GCLK1_Val |
-  //                                  (1 << GCLK_PCHCTRL_CHEN_Pos);
-  switch (this -> TC_num) {
-    case 0:
-      GCLK->PCHCTRL[TC0_GCLK_ID].reg = GCLK_PCHCTRL_GEN_GCLK0_Val |
-                                    (1 << GCLK_PCHCTRL_CHEN_Pos);
-      while (GCLK->SYNCBUSY.reg > 0);
-
-      TC0->COUNT16.CTRLA.bit.ENABLE = 0;
-      
-      // Use match mode so that the timer counter resets when the count matches the
-      // compare register
-      TC0->COUNT16.WAVE.bit.WAVEGEN = TC_WAVE_WAVEGEN_MFRQ;
-      TC_wait_for_sync();
-      
-      // Enable the compare interrupt
-      TC0->COUNT16.INTENSET.reg = 0;
-      TC0->COUNT16.INTENSET.bit.MC0 = 1;
-
-      // Enable IRQ
-      NVIC_EnableIRQ(TC0_IRQn);
-
-      func0 = f;
-
-      break;
-    
-    case 1:
-      GCLK->PCHCTRL[TC1_GCLK_ID].reg = GCLK_PCHCTRL_GEN_GCLK0_Val |
-                                    (1 << GCLK_PCHCTRL_CHEN_Pos);
-      while (GCLK->SYNCBUSY.reg > 0);
-
-      TC1->COUNT16.CTRLA.bit.ENABLE = 0;
-      
-      // Use match mode so that the timer counter resets when the count matches the
-      // compare register
-      TC1->COUNT16.WAVE.bit.WAVEGEN = TC_WAVE_WAVEGEN_MFRQ;
-      TC_wait_for_sync();
-      
-      // Enable the compare interrupt
-      TC1->COUNT16.INTENSET.reg = 0;
-      TC1->COUNT16.INTENSET.bit.MC0 = 1;
-
-      // Enable IRQ
-      NVIC_EnableIRQ(TC1_IRQn);
-
-      func1 = f;
-
-      break;
-
-    case 2:
-      GCLK->PCHCTRL[TC2_GCLK_ID].reg = GCLK_PCHCTRL_GEN_GCLK0_Val |
-                                    (1 << GCLK_PCHCTRL_CHEN_Pos);
-      while (GCLK->SYNCBUSY.reg > 0);
-
-      TC2->COUNT16.CTRLA.bit.ENABLE = 0;
-      
-      // Use match mode so that the timer counter resets when the count matches the
-      // compare register
-      TC2->COUNT16.WAVE.bit.WAVEGEN = TC_WAVE_WAVEGEN_MFRQ;
-      TC_wait_for_sync();
-      
-      // Enable the compare interrupt
-      TC2->COUNT16.INTENSET.reg = 0;
-      TC2->COUNT16.INTENSET.bit.MC0 = 1;
-
-      // Enable IRQ
-      NVIC_EnableIRQ(TC2_IRQn);
-
-      func2 = f;
-
-      break;
-    
-    case 3:
-      GCLK->PCHCTRL[TC3_GCLK_ID].reg = GCLK_PCHCTRL_GEN_GCLK0_Val |
-                                    (1 << GCLK_PCHCTRL_CHEN_Pos);
-      while (GCLK->SYNCBUSY.reg > 0);
-
-      TC3->COUNT16.CTRLA.bit.ENABLE = 0;
-      
-      // Use match mode so that the timer counter resets when the count matches the
-      // compare register
-      TC3->COUNT16.WAVE.bit.WAVEGEN = TC_WAVE_WAVEGEN_MFRQ;
-      TC_wait_for_sync();
-      
-      // Enable the compare interrupt
-      TC3->COUNT16.INTENSET.reg = 0;
-      TC3->COUNT16.INTENSET.bit.MC0 = 1;
-
-      // Enable IRQ
-      NVIC_EnableIRQ(TC3_IRQn);
-
-      func3 = f;
-
-      break;
-    
-    case 4:
-      GCLK->PCHCTRL[TC4_GCLK_ID].reg = GCLK_PCHCTRL_GEN_GCLK0_Val |
-                                    (1 << GCLK_PCHCTRL_CHEN_Pos);
-      while (GCLK->SYNCBUSY.reg > 0);
-
-      TC4->COUNT16.CTRLA.bit.ENABLE = 0;
-      
-      // Use match mode so that the timer counter resets when the count matches the
-      // compare register
-      TC4->COUNT16.WAVE.bit.WAVEGEN = TC_WAVE_WAVEGEN_MFRQ;
-      TC_wait_for_sync();
-      
-      // Enable the compare interrupt
-      TC4->COUNT16.INTENSET.reg = 0;
-      TC4->COUNT16.INTENSET.bit.MC0 = 1;
-
-      // Enable IRQ
-      NVIC_EnableIRQ(TC4_IRQn);
-
-      func4 = f;
-
-      break;
-
-    case 5:
-      GCLK->PCHCTRL[TC5_GCLK_ID].reg = GCLK_PCHCTRL_GEN_GCLK0_Val |
-                                    (1 << GCLK_PCHCTRL_CHEN_Pos);
-      while (GCLK->SYNCBUSY.reg > 0);
-
-      TC5->COUNT16.CTRLA.bit.ENABLE = 0;
-      
-      // Use match mode so that the timer counter resets when the count matches the
-      // compare register
-      TC5->COUNT16.WAVE.bit.WAVEGEN = TC_WAVE_WAVEGEN_MFRQ;
-      TC_wait_for_sync();
-      
-      // Enable the compare interrupt
-      TC5->COUNT16.INTENSET.reg = 0;
-      TC5->COUNT16.INTENSET.bit.MC0 = 1;
-
-      // Enable IRQ
-      NVIC_EnableIRQ(TC5_IRQn);
-
-      func5 = f;
-
-      break;
-  }
-
+  tc_callbacks[TC_num] = f;
+  tc_start(tc_instances[TC_num], tc_gclk_ids[TC_num], tc_irqs[TC_num], f != NULL);
   setPeriod(period);
 }
 
 void TC_Timer::stopTimer() {
-  switch (TC_num) {
-    case 0:
-      TC0->COUNT16.CTRLA.bit.ENABLE = 0;
-    case 1:
-      TC1->COUNT16.CTRLA.bit.ENABLE = 0;
-      break;
-    case 2:
-      TC2->COUNT16.CTRLA.bit.ENABLE = 0;
-      break;
-    case 3:
-      TC3->COUNT16.CTRLA.bit.ENABLE = 0;
-      break;
-    case 4:
-      TC4->COUNT16.CTRLA.bit.ENABLE = 0;
-      break;
-    case 5:
-      TC5->COUNT16.CTRLA.bit.ENABLE = 0;
-      break;
-  }
+  tc_stop(tc_instances[TC_num]);
 }
 
 void TC_Timer::restartTimer(unsigned long period) {
-  // Enable the TC bus clock, use clock generator 1
-  // GCLK->PCHCTRL[TC3_GCLK_ID].reg = GCLK_PCHCTRL_GEN_GCLK1_Val |
-  //                                  (1 << GCLK_PCHCTRL_CHEN_Pos);
-  switch (TC_num) {
-    case 0:
-      GCLK->PCHCTRL[TC0_GCLK_ID].reg = GCLK_PCHCTRL_GEN_GCLK0_Val |
-                                      (1 << GCLK_PCHCTRL_CHEN_Pos);
-      while (GCLK->SYNCBUSY.reg > 0);
-
-      TC0->COUNT16.CTRLA.bit.ENABLE = 0;
-      
-      // Use match mode so that the timer counter resets when the count matches the
-      // compare register
-      TC0->COUNT16.WAVE.bit.WAVEGEN = TC_WAVE_WAVEGEN_MFRQ;
-      TC_wait_for_sync();
-      
-      // Enable the compare interrupt
-      TC0->COUNT16.INTENSET.reg = 0;
-      TC0->COUNT16.INTENSET.bit.MC0 = 1;
-
-      // Enable IRQ
-      NVIC_EnableIRQ(TC0_IRQn);
-
-      break;
-    
-    case 1:
-      GCLK->PCHCTRL[TC1_GCLK_ID].reg = GCLK_PCHCTRL_GEN_GCLK0_Val |
-                                      (1 << GCLK_PCHCTRL_CHEN_Pos);
-      while (GCLK->SYNCBUSY.reg > 0);
-
-      TC1->COUNT16.CTRLA.bit.ENABLE = 0;
-      
-      // Use match mode so that the timer counter resets when the count matches the
-      // compare register
-      TC1->COUNT16.WAVE.bit.WAVEGEN = TC_WAVE_WAVEGEN_MFRQ;
-      TC_wait_for_sync();
-      
-      // Enable the compare interrupt
-      TC1->COUNT16.INTENSET.reg = 0;
-      TC1->COUNT16.INTENSET.bit.MC0 = 1;
-
-      // Enable IRQ
-      NVIC_EnableIRQ(TC1_IRQn);
-
-      break;
-      
-    case 2:
-      GCLK->PCHCTRL[TC2_GCLK_ID].reg = GCLK_PCHCTRL_GEN_GCLK0_Val |
-                                      (1 << GCLK_PCHCTRL_CHEN_Pos);
-      while (GCLK->SYNCBUSY.reg > 0);
-
-      TC2->COUNT16.CTRLA.bit.ENABLE = 0;
-      
-      // Use match mode so that the timer counter resets when the count matches the
-      // compare register
-      TC2->COUNT16.WAVE.bit.WAVEGEN = TC_WAVE_WAVEGEN_MFRQ;
-      TC_wait_for_sync();
-      
-      // Enable the compare interrupt
-      TC2->COUNT16.INTENSET.reg = 0;
-      TC2->COUNT16.INTENSET.bit.MC0 = 1;
-
-      // Enable IRQ
-      NVIC_EnableIRQ(TC2_IRQn);
-
-      break;
-    
-    case 3:
-      GCLK->PCHCTRL[TC3_GCLK_ID].reg = GCLK_PCHCTRL_GEN_GCLK0_Val |
-                                      (1 << GCLK_PCHCTRL_CHEN_Pos);
-      while (GCLK->SYNCBUSY.reg > 0);
-
-      TC3->COUNT16.CTRLA.bit.ENABLE = 0;
-      
-      // Use match mode so that the timer counter resets when the count matches the
-      // compare register
-      TC3->COUNT16.WAVE.bit.WAVEGEN = TC_WAVE_WAVEGEN_MFRQ;
-      TC_wait_for_sync();
-      
-      // Enable the compare interrupt
-      TC3->COUNT16.INTENSET.reg = 0;
-      TC3->COUNT16.INTENSET.bit.MC0 = 1;
-
-      // Enable IRQ
-      NVIC_EnableIRQ(TC3_IRQn);
-
-      break;
-    
-    case 4:
-      GCLK->PCHCTRL[TC4_GCLK_ID].reg = GCLK_PCHCTRL_GEN_GCLK0_Val |
-                                      (1 << GCLK_PCHCTRL_CHEN_Pos);
-      while (GCLK->SYNCBUSY.reg > 0);
-
-      TC4->COUNT16.CTRLA.bit.ENABLE = 0;
-      
-      // Use match mode so that the timer counter resets when the count matches the
-      // compare register
-      TC4->COUNT16.WAVE.bit.WAVEGEN = TC_WAVE_WAVEGEN_MFRQ;
-      TC_wait_for_sync();
-      
-      // Enable the compare interrupt
-      TC4->COUNT16.INTENSET.reg = 0;
-      TC4->COUNT16.INTENSET.bit.MC0 = 1;
-
-      // Enable IRQ
-      NVIC_EnableIRQ(TC4_IRQn);
-
-      break;
-    
-    case 5:
-      GCLK->PCHCTRL[TC5_GCLK_ID].reg = GCLK_PCHCTRL_GEN_GCLK0_Val |
-                                      (1 << GCLK_PCHCTRL_CHEN_Pos);
-      while (GCLK->SYNCBUSY.reg > 0);
-
-      TC5->COUNT16.CTRLA.bit.ENABLE = 0;
-      
-      // Use match mode so that the timer counter resets when the count matches the
-      // compare register
-      TC5->COUNT16.WAVE.bit.WAVEGEN = TC_WAVE_WAVEGEN_MFRQ;
-      TC_wait_for_sync();
-      
-      // Enable the compare interrupt
-      TC5->COUNT16.INTENSET.reg = 0;
-      TC5->COUNT16.INTENSET.bit.MC0 = 1;
-
-      // Enable IRQ
-      NVIC_EnableIRQ(TC5_IRQn);
-
-      break;
-  }  
-
+  tc_start(tc_instances[TC_num], tc_gclk_ids[TC_num], tc_irqs[TC_num], tc_callbacks[TC_num] != NULL);
   setPeriod(period);
 }
 
 void TC_Timer::setPeriod(unsigned long period) {
-  int prescaler;
-  uint32_t TC_CTRLA_PRESCALER_DIVN;
+  tc_set_period(tc_instances[TC_num], period);
+}
 
-  switch (TC_num) {
-    case 0:
-      TC0->COUNT16.CTRLA.reg &= ~TC_CTRLA_ENABLE;
-      TC_wait_for_sync();
-      TC0->COUNT16.CTRLA.reg &= ~TC_CTRLA_PRESCALER_DIV1024;
-      TC_wait_for_sync();
-      TC0->COUNT16.CTRLA.reg &= ~TC_CTRLA_PRESCALER_DIV256;
-      TC_wait_for_sync();
-      TC0->COUNT16.CTRLA.reg &= ~TC_CTRLA_PRESCALER_DIV64;
-      TC_wait_for_sync();
-      TC0->COUNT16.CTRLA.reg &= ~TC_CTRLA_PRESCALER_DIV16;
-      TC_wait_for_sync();
-      TC0->COUNT16.CTRLA.reg &= ~TC_CTRLA_PRESCALER_DIV4;
-      TC_wait_for_sync();
-      TC0->COUNT16.CTRLA.reg &= ~TC_CTRLA_PRESCALER_DIV2;
-      TC_wait_for_sync();
-      TC0->COUNT16.CTRLA.reg &= ~TC_CTRLA_PRESCALER_DIV1;
-      TC_wait_for_sync();
-      break;
-    
-    case 1:
-      TC1->COUNT16.CTRLA.reg &= ~TC_CTRLA_ENABLE;
-      TC_wait_for_sync();
-      TC1->COUNT16.CTRLA.reg &= ~TC_CTRLA_PRESCALER_DIV1024;
-      TC_wait_for_sync();
-      TC1->COUNT16.CTRLA.reg &= ~TC_CTRLA_PRESCALER_DIV256;
-      TC_wait_for_sync();
-      TC1->COUNT16.CTRLA.reg &= ~TC_CTRLA_PRESCALER_DIV64;
-      TC_wait_for_sync();
-      TC1->COUNT16.CTRLA.reg &= ~TC_CTRLA_PRESCALER_DIV16;
-      TC_wait_for_sync();
-      TC1->COUNT16.CTRLA.reg &= ~TC_CTRLA_PRESCALER_DIV4;
-      TC_wait_for_sync();
-      TC1->COUNT16.CTRLA.reg &= ~TC_CTRLA_PRESCALER_DIV2;
-      TC_wait_for_sync();
-      TC1->COUNT16.CTRLA.reg &= ~TC_CTRLA_PRESCALER_DIV1;
-      TC_wait_for_sync();
-      break;
-    
-    case 2:
-      TC2->COUNT16.CTRLA.reg &= ~TC_CTRLA_ENABLE;
-      TC_wait_for_sync();
-      TC2->COUNT16.CTRLA.reg &= ~TC_CTRLA_PRESCALER_DIV1024;
-      TC_wait_for_sync();
-      TC2->COUNT16.CTRLA.reg &= ~TC_CTRLA_PRESCALER_DIV256;
-      TC_wait_for_sync();
-      TC2->COUNT16.CTRLA.reg &= ~TC_CTRLA_PRESCALER_DIV64;
-      TC_wait_for_sync();
-      TC2->COUNT16.CTRLA.reg &= ~TC_CTRLA_PRESCALER_DIV16;
-      TC_wait_for_sync();
-      TC2->COUNT16.CTRLA.reg &= ~TC_CTRLA_PRESCALER_DIV4;
-      TC_wait_for_sync();
-      TC2->COUNT16.CTRLA.reg &= ~TC_CTRLA_PRESCALER_DIV2;
-      TC_wait_for_sync();
-      TC2->COUNT16.CTRLA.reg &= ~TC_CTRLA_PRESCALER_DIV1;
-      TC_wait_for_sync();
-      break;
-    
-    case 3:
-      TC3->COUNT16.CTRLA.reg &= ~TC_CTRLA_ENABLE;
-      TC_wait_for_sync();
-      TC3->COUNT16.CTRLA.reg &= ~TC_CTRLA_PRESCALER_DIV1024;
-      TC_wait_for_sync();
-      TC3->COUNT16.CTRLA.reg &= ~TC_CTRLA_PRESCALER_DIV256;
-      TC_wait_for_sync();
-      TC3->COUNT16.CTRLA.reg &= ~TC_CTRLA_PRESCALER_DIV64;
-      TC_wait_for_sync();
-      TC3->COUNT16.CTRLA.reg &= ~TC_CTRLA_PRESCALER_DIV16;
-      TC_wait_for_sync();
-      TC3->COUNT16.CTRLA.reg &= ~TC_CTRLA_PRESCALER_DIV4;
-      TC_wait_for_sync();
-      TC3->COUNT16.CTRLA.reg &= ~TC_CTRLA_PRESCALER_DIV2;
-      TC_wait_for_sync();
-      TC3->COUNT16.CTRLA.reg &= ~TC_CTRLA_PRESCALER_DIV1;
-      TC_wait_for_sync();
-      break;
-    
-    case 4:
-      TC4->COUNT16.CTRLA.reg &= ~TC_CTRLA_ENABLE;
-      TC_wait_for_sync();
-      TC4->COUNT16.CTRLA.reg &= ~TC_CTRLA_PRESCALER_DIV1024;
-      TC_wait_for_sync();
-      TC4->COUNT16.CTRLA.reg &= ~TC_CTRLA_PRESCALER_DIV256;
-      TC_wait_for_sync();
-      TC4->COUNT16.CTRLA.reg &= ~TC_CTRLA_PRESCALER_DIV64;
-      TC_wait_for_sync();
-      TC4->COUNT16.CTRLA.reg &= ~TC_CTRLA_PRESCALER_DIV16;
-      TC_wait_for_sync();
-      TC4->COUNT16.CTRLA.reg &= ~TC_CTRLA_PRESCALER_DIV4;
-      TC_wait_for_sync();
-      TC4->COUNT16.CTRLA.reg &= ~TC_CTRLA_PRESCALER_DIV2;
-      TC_wait_for_sync();
-      TC4->COUNT16.CTRLA.reg &= ~TC_CTRLA_PRESCALER_DIV1;
-      TC_wait_for_sync();
-      break;
-    
-    case 5:
-      TC5->COUNT16.CTRLA.reg &= ~TC_CTRLA_ENABLE;
-      TC_wait_for_sync();
-      TC5->COUNT16.CTRLA.reg &= ~TC_CTRLA_PRESCALER_DIV1024;
-      TC_wait_for_sync();
-      TC5->COUNT16.CTRLA.reg &= ~TC_CTRLA_PRESCALER_DIV256;
-      TC_wait_for_sync();
-      TC5->COUNT16.CTRLA.reg &= ~TC_CTRLA_PRESCALER_DIV64;
-      TC_wait_for_sync();
-      TC5->COUNT16.CTRLA.reg &= ~TC_CTRLA_PRESCALER_DIV16;
-      TC_wait_for_sync();
-      TC5->COUNT16.CTRLA.reg &= ~TC_CTRLA_PRESCALER_DIV4;
-      TC_wait_for_sync();
-      TC5->COUNT16.CTRLA.reg &= ~TC_CTRLA_PRESCALER_DIV2;
-      TC_wait_for_sync();
-      TC5->COUNT16.CTRLA.reg &= ~TC_CTRLA_PRESCALER_DIV1;
-      TC_wait_for_sync();
-      break;
-  }      
+void TC_Timer::retune(unsigned long period) {
+  tc_retune(tc_instances[TC_num], period);
+}
 
-  if (period > 300000) {
-    TC_CTRLA_PRESCALER_DIVN = TC_CTRLA_PRESCALER_DIV1024;
-    prescaler = 1024;
-  } else if (80000 < period && period <= 300000) {
-    TC_CTRLA_PRESCALER_DIVN = TC_CTRLA_PRESCALER_DIV256;
-    prescaler = 256;
-  } else if (20000 < period && period <= 80000) {
-    TC_CTRLA_PRESCALER_DIVN = TC_CTRLA_PRESCALER_DIV64;
-    prescaler = 64;
-  } else if (10000 < period && period <= 20000) {
-    TC_CTRLA_PRESCALER_DIVN = TC_CTRLA_PRESCALER_DIV16;
-    prescaler = 16;
-  } else if (5000 < period && period <= 10000) {
-    TC_CTRLA_PRESCALER_DIVN = TC_CTRLA_PRESCALER_DIV8;
-    prescaler = 8;
-  } else if (2500 < period && period <= 5000) {
-    TC_CTRLA_PRESCALER_DIVN = TC_CTRLA_PRESCALER_DIV4;
-    prescaler = 4;
-  } else if (1000 < period && period <= 2500) {
-    TC_CTRLA_PRESCALER_DIVN = TC_CTRLA_PRESCALER_DIV2;
-    prescaler = 2;
-  } else if (period <= 1000) {
-    TC_CTRLA_PRESCALER_DIVN = TC_CTRLA_PRESCALER_DIV1;
-    prescaler = 1;
-  }
 
-  // int compareValue = (int)(GCLK1_HZ / (prescaler/((float)period / 1000000))) - 1;
-  int compareValue = (int)(GCLK0_HZ / (prescaler/((float)period / 100000000))) - 1;
-
-  switch (TC_num) {
-    case 0:
-      TC0->COUNT16.CTRLA.reg |= TC_CTRLA_PRESCALER_DIVN;
-      TC_wait_for_sync();
-
-      // Make sure the count is in a proportional position to where it was
-      // to prevent any jitter or disconnect when changing the compare value.
-      TC0->COUNT16.COUNT.reg = map(TC0->COUNT16.COUNT.reg, 0,
-                                  TC0->COUNT16.CC[0].reg, 0, compareValue);
-      TC0->COUNT16.CC[0].reg = compareValue;
-      TC_wait_for_sync();
-
-      TC0->COUNT16.CTRLA.bit.ENABLE = 1;
-      TC_wait_for_sync();
-
-      break;
-    
-    case 1:
-      TC1->COUNT16.CTRLA.reg |= TC_CTRLA_PRESCALER_DIVN;
-      TC_wait_for_sync();
-
-      // Make sure the count is in a proportional position to where it was
-      // to prevent any jitter or disconnect when changing the compare value.
-      TC1->COUNT16.COUNT.reg = map(TC1->COUNT16.COUNT.reg, 0,
-                                  TC1->COUNT16.CC[0].reg, 0, compareValue);
-      TC1->COUNT16.CC[0].reg = compareValue;
-      TC_wait_for_sync();
-
-      TC1->COUNT16.CTRLA.bit.ENABLE = 1;
-      TC_wait_for_sync();
-
-      break;
-    
-    case 2:
-      TC2->COUNT16.CTRLA.reg |= TC_CTRLA_PRESCALER_DIVN;
-      TC_wait_for_sync();
-
-      // Make sure the count is in a proportional position to where it was
-      // to prevent any jitter or disconnect when changing the compare value.
-      TC2->COUNT16.COUNT.reg = map(TC2->COUNT16.COUNT.reg, 0,
-                                  TC2->COUNT16.CC[0].reg, 0, compareValue);
-      TC2->COUNT16.CC[0].reg = compareValue;
-      TC_wait_for_sync();
-
-      TC2->COUNT16.CTRLA.bit.ENABLE = 1;
-      TC_wait_for_sync();
-
-      break;
-    
-    case 3:
-      TC3->COUNT16.CTRLA.reg |= TC_CTRLA_PRESCALER_DIVN;
-      TC_wait_for_sync();
-
-      // Make sure the count is in a proportional position to where it was
-      // to prevent any jitter or disconnect when changing the compare value.
-      TC3->COUNT16.COUNT.reg = map(TC3->COUNT16.COUNT.reg, 0,
-                                  TC3->COUNT16.CC[0].reg, 0, compareValue);
-      TC3->COUNT16.CC[0].reg = compareValue;
-      TC_wait_for_sync();
-
-      TC3->COUNT16.CTRLA.bit.ENABLE = 1;
-      TC_wait_for_sync();
-
-      break;
-    
-    case 4:
-      TC4->COUNT16.CTRLA.reg |= TC_CTRLA_PRESCALER_DIVN;
-      TC_wait_for_sync();
-
-      // Make sure the count is in a proportional position to where it was
-      // to prevent any jitter or disconnect when changing the compare value.
-      TC4->COUNT16.COUNT.reg = map(TC4->COUNT16.COUNT.reg, 0,
-                                  TC4->COUNT16.CC[0].reg, 0, compareValue);
-      TC4->COUNT16.CC[0].reg = compareValue;
-      TC_wait_for_sync();
-
-      TC4->COUNT16.CTRLA.bit.ENABLE = 1;
-      TC_wait_for_sync();
-
-      break;
-    
-    case 5:
-      TC5->COUNT16.CTRLA.reg |= TC_CTRLA_PRESCALER_DIVN;
-      TC_wait_for_sync();
-
-      // Make sure the count is in a proportional position to where it was
-      // to prevent any jitter or disconnect when changing the compare value.
-      TC5->COUNT16.COUNT.reg = map(TC5->COUNT16.COUNT.reg, 0,
-                                  TC5->COUNT16.CC[0].reg, 0, compareValue);
-      TC5->COUNT16.CC[0].reg = compareValue;
-      TC_wait_for_sync();
-
-      TC5->COUNT16.CTRLA.bit.ENABLE = 1;
-      TC_wait_for_sync();
-
-      break;
+// Default handlers, calling the TC_Timer callbacks. A TC whose
+// TCn_USER_HANDLER is defined gets its handler from TC_TIMER_HANDLER()
+// instead.
+static inline void tc_dispatch(Tc *tc, int n) {
+  PROFILE_SCOPE(PROF_TC0 + n);
+
+  // If this interrupt is due to the compare register matching the timer count
+  if (tc->COUNT16.INTFLAG.bit.MC0 == 1) {
+    tc->COUNT16.INTFLAG.reg = TC_INTFLAG_MC0;
+    void (*f)() = tc_callbacks[n];
+    if (f != NULL) {
+      (*f)();
+    }
   }
 }
 
-
+#ifndef TC0_USER_HANDLER
 void TC0_Handler() {
-  // If this interrupt is due to the compare register matching the timer count
-  if (TC0->COUNT16.INTFLAG.bit.MC0 == 1) {
-    TC0->COUNT16.INTFLAG.bit.MC0 = 1;
-    (*func0)();
-  }
+  tc_dispatch(TC0, 0);
 }
+#endif
 
+#ifndef TC1_USER_HANDLER
 void TC1_Handler() {
-  // If this interrupt is due to the compare register matching the timer count
-  if (TC1->COUNT16.INTFLAG.bit.MC0 == 1) {
-    TC1->COUNT16.INTFLAG.bit.MC0 = 1;
-    (*func1)();
-  }
+  tc_dispatch(TC1, 1);
 }
+#endif
 
+#ifndef TC2_USER_HANDLER
 void TC2_Handler() {
-  // If this interrupt is due to the compare register matching the timer count
-  if (TC2->COUNT16.INTFLAG.bit.MC0 == 1) {
-    TC2->COUNT16.INTFLAG.bit.MC0 = 1;
-    (*func2)();
-  }
+  tc_dispatch(TC2, 2);
 }
+#endif
 
+#ifndef TC3_USER_HANDLER
 void TC3_Handler() {
-  // If this interrupt is due to the compare register matching the timer count
-  if (TC3->COUNT16.INTFLAG.bit.MC0 == 1) {
-    TC3->COUNT16.INTFLAG.bit.MC0 = 1;
-    (*func3)();
-  }
+  tc_dispatch(TC3, 3);
 }
+#endif
 
+#ifndef TC4_USER_HANDLER
 void TC4_Handler() {
-  // If this interrupt is due to the compare register matching the timer count
-  if (TC4->COUNT16.INTFLAG.bit.MC0 == 1) {
-    TC4->COUNT16.INTFLAG.bit.MC0 = 1;
-    (*func4)();
-  }
+  tc_dispatch(TC4, 4);
 }
+#endif
 
+#ifndef TC5_USER_HANDLER
 void TC5_Handler() {
-  // If this interrupt is due to the compare register matching the timer count
-  if (TC5->COUNT16.INTFLAG.bit.MC0 == 1) {
-    TC5->COUNT16.INTFLAG.bit.MC0 = 1;
-    (*func5)();
-  }
+  tc_dispatch(TC5, 5);
 }
+#endif
@@ -7,6 +7,14 @@
   switching compilation between SAMD21 and SAMD51 microprocessor boards.
   See https://github.com/EHbtj/ZeroTimer for the SAMD21 library.
 
+  Two interfaces share one implementation:
+  - TC_StaticTimer<N> resolves the TC instance at compile time. Together with
+    TC_TIMER_HANDLER(N, f) the callback is called directly from TCN_Handler
+    and can be inlined into it. TCN_USER_HANDLER must then be defined below,
+    which leaves out the default TCN_Handler.
+  - TC_Timer selects the TC at runtime and calls the callback through a
+    function pointer, as before.
+
   Adapted by MIDI Music Magic from Dennis van Gils
   November 2022
 */
@@ -14,6 +22,133 @@
 #ifndef SAMD51_ISR_Timer_h
 #define SAMD51_ISR_Timer_h
 
+#include "Arduino.h"
+#include "profiler.h"
+
+#define TC_TIMER_COUNT 6   // TC0 - TC5 are supported
+
+// Uncomment for every TC whose handler is defined with TC_TIMER_HANDLER()
+// (or pass -DTCn_USER_HANDLER). The default handlers are not weak, so a
+// handler defined without this fails to link instead of silently replacing
+// the default.
+// #define TC0_USER_HANDLER
+// #define TC1_USER_HANDLER
+// #define TC2_USER_HANDLER
+// #define TC3_USER_HANDLER
+// #define TC4_USER_HANDLER
+// #define TC5_USER_HANDLER
+
+// Generic implementation, shared by TC_Timer and TC_StaticTimer.
+// Periods are given in 10s of ns.
+void tc_start(Tc *tc, int gclk_id, IRQn_Type irq, bool interrupt);
+void tc_stop(Tc *tc);
+void tc_set_period(Tc *tc, unsigned long period);
+void tc_retune(Tc *tc, unsigned long period);
+
+inline void tc_wait_for_sync(Tc *tc) {
+  while (tc->COUNT16.SYNCBUSY.reg != 0) {}
+}
+
+// Peripheral instance, IRQ and clock channel of each TC
+template <int N> struct TC_Instance;
+
+#define TC_INSTANCE(n) \
+  template <> struct TC_Instance<n> { \
+    static Tc *tc() { return TC##n; } \
+    static const IRQn_Type irq = TC##n##_IRQn; \
+    static const int gclk_id = TC##n##_GCLK_ID; \
+  };
+
+TC_INSTANCE(0)
+TC_INSTANCE(1)
+TC_INSTANCE(2)
+TC_INSTANCE(3)
+TC_INSTANCE(4)
+TC_INSTANCE(5)
+
+template <int N>
+class TC_StaticTimer {
+  public:
+    // Start the timer; with interrupt = false it only paces other peripherals (e.g. DMA)
+    static void startTimer(unsigned long period, bool interrupt = true) {
+      tc_start(TC_Instance<N>::tc(), TC_Instance<N>::gclk_id, TC_Instance<N>::irq, interrupt);
+      tc_set_period(TC_Instance<N>::tc(), period);
+    }
+
+    static void stopTimer() {
+      tc_stop(TC_Instance<N>::tc());
+    }
+
+    static void restartTimer(unsigned long period) {
+      startTimer(period);
+    }
+
+    static void setPeriod(unsigned long period) {
+      tc_set_period(TC_Instance<N>::tc(), period);
+    }
+
+    // Glitch-free period change, see tc_retune()
+    static void retune(unsigned long period) {
+      tc_retune(TC_Instance<N>::tc(), period);
+    }
+
+    static int getTCNumber() {
+      return N;
+    }
+
+    // Acknowledge the compare match and call F, for use in TCN_Handler
+    template <void (*F)()>
+    static inline void handleInterrupt() {
+      Tc *tc = TC_Instance<N>::tc();
+      if (tc->COUNT16.INTFLAG.bit.MC0 == 1) {
+        tc->COUNT16.INTFLAG.reg = TC_INTFLAG_MC0;
+        F();
+      }
+    }
+};
+
+// Whether the default handler of each TC is left out
+#ifdef TC0_USER_HANDLER
+#define TC_USER_HANDLER_0 true
+#else
+#define TC_USER_HANDLER_0 false
+#endif
+#ifdef TC1_USER_HANDLER
+#define TC_USER_HANDLER_1 true
+#else
+#define TC_USER_HANDLER_1 false
+#endif
+#ifdef TC2_USER_HANDLER
+#define TC_USER_HANDLER_2 true
+#else
+#define TC_USER_HANDLER_2 false
+#endif
+#ifdef TC3_USER_HANDLER
+#define TC_USER_HANDLER_3 true
+#else
+#define TC_USER_HANDLER_3 false
+#endif
+#ifdef TC4_USER_HANDLER
+#define TC_USER_HANDLER_4 true
+#else
+#define TC_USER_HANDLER_4 false
+#endif
+#ifdef TC5_USER_HANDLER
+#define TC_USER_HANDLER_5 true
+#else
+#define TC_USER_HANDLER_5 false
+#endif
+
+// Define TCn_Handler to call f directly, in place of the default handler
+// that calls the callback given to TC_Timer::startTimer(). Needs
+// TCn_USER_HANDLER.
+#define TC_TIMER_HANDLER(n, f) \
+  static_assert(TC_USER_HANDLER_##n, "define TC" #n "_USER_HANDLER in SAMD51_InterruptTimer.h"); \
+  void TC##n##_Handler() { \
+    PROFILE_SCOPE(PROF_TC0 + n); \
+    TC_StaticTimer<n>::handleInterrupt<f>(); \
+  }
+
 class TC_Timer {
   public:
     TC_Timer();
@@ -22,6 +157,7 @@ class TC_Timer {
     void stopTimer();
     void restartTimer(unsigned long period);
     void setPeriod(unsigned long period);
+    void retune(unsigned long period);
     void setTCNumber(int n);
     int getTCNumber();
 
@@ -0,0 +1,96 @@
+#include "adcScanner.h"
+#include "wiring_private.h"
+
+static Adc * const adc_instances[2] = {ADC0, ADC1};
+static const int adc_gclk_ids[2] = {ADC0_GCLK_ID, ADC1_GCLK_ID};
+static const int adc_seq_triggers[2] = {ADC0_DMAC_ID_SEQ, ADC1_DMAC_ID_SEQ};
+static const int adc_result_triggers[2] = {ADC0_DMAC_ID_RESRDY, ADC1_DMAC_ID_RESRDY};
+
+adcScanner::adcScanner() {
+  this -> first_dma_channel = 1;
+  this -> n_pins = 0;
+}
+
+// Uses DMA channels first_dma_channel to first_dma_channel + 3
+adcScanner::adcScanner(int first_dma_channel) {
+  this -> first_dma_channel = first_dma_channel;
+  this -> n_pins = 0;
+}
+
+// Start scanning pins. Results are 10 bit, like analogRead().
+void adcScanner::begin(const int *pins, int n) {
+  if (n > ADC_SCAN_MAX_PINS) {
+    n = ADC_SCAN_MAX_PINS;
+  }
+  this -> n_pins = n;
+  this -> n_seq[0] = 0;
+  this -> n_seq[1] = 0;
+
+  for (int i = 0; i < n; i++) {
+    const PinDescription &desc = g_APinDescription[pins[i]];
+    int a = (desc.ulPinAttribute & PIN_ATTR_ANALOG_ALT) ? 1 : 0;
+    int k = this -> n_seq[a]++;
+
+    pinPeripheral(pins[i], PIO_ANALOG);
+    this -> seq[a][k] = ADC_INPUTCTRL_MUXPOS(desc.ulADCChannelNumber) | ADC_INPUTCTRL_MUXNEG_GND;
+    this -> results[a][k] = 0;
+    this -> slot[i] = a * ADC_SCAN_MAX_PINS + k;
+  }
+
+  // Each ADC that has pins on it runs its own sequence
+  for (int a = 0; a < 2; a++) {
+    if (this -> n_seq[a] > 0) {
+      startADC(a);
+    }
+  }
+}
+
+void adcScanner::startADC(int a) {
+  Adc *adc = adc_instances[a];
+  int n = this -> n_seq[a];
+
+  if (a == 0) {
+    MCLK->APBDMASK.bit.ADC0_ = 1;
+  } else {
+    MCLK->APBDMASK.bit.ADC1_ = 1;
+  }
+  GCLK->PCHCTRL[adc_gclk_ids[a]].reg = GCLK_PCHCTRL_GEN_GCLK1 | GCLK_PCHCTRL_CHEN;   // 48MHz
+
+  adc->CTRLA.bit.ENABLE = 0;
+  while (adc->SYNCBUSY.reg);
+  adc->CTRLA.bit.SWRST = 1;
+  while (adc->SYNCBUSY.reg);
+
+  adc->CTRLA.reg = ADC_CTRLA_PRESCALER_DIV256;    // ~14k conversions/s shared by the pins of this ADC
+  adc->CTRLB.reg = ADC_CTRLB_RESSEL_10BIT;
+  adc->REFCTRL.reg = ADC_REFCTRL_REFSEL_INTVCC1;
+  adc->AVGCTRL.reg = ADC_AVGCTRL_SAMPLENUM_1;
+  adc->SAMPCTRL.reg = ADC_SAMPCTRL_SAMPLEN(5);
+  adc->DSEQCTRL.reg = ADC_DSEQCTRL_INPUTCTRL | ADC_DSEQCTRL_AUTOSTART;
+  while (adc->SYNCBUSY.reg);
+
+  // Sequencer: next INPUTCTRL per conversion. Results: one ring slot per pin.
+  dmaHandler seq_dma(this -> first_dma_channel + 2 * a);
+  dmaHandler result_dma(this -> first_dma_channel + 2 * a + 1);
+  result_dma.startCircular(adc_result_triggers[a], &adc->RESULT.reg, this -> results[a], n, 2, false, true);
+  seq_dma.startCircular(adc_seq_triggers[a], this -> seq[a], &adc->DSEQDATA.reg, n, 4, true, false);
+
+  adc->CTRLA.bit.ENABLE = 1;
+  while (adc->SYNCBUSY.reg);
+}
+
+int adcScanner::getCount() {
+  return this -> n_pins;
+}
+
+// Latest conversion of pin i (in the order given to begin())
+uint16_t adcScanner::read(int i) {
+  int s = this -> slot[i];
+  return this -> results[s / ADC_SCAN_MAX_PINS][s % ADC_SCAN_MAX_PINS];
+}
+
+void adcScanner::readAll(uint16_t *dst) {
+  for (int i = 0; i < this -> n_pins; i++) {
+    dst[i] = read(i);
+  }
+}
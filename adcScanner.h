@@ -0,0 +1,36 @@
+// This class scans a set of analog pins continuously without the CPU. Each
+// ADC walks its pins with the DMA sequencer (DSEQ): one DMA channel feeds
+// the next INPUTCTRL value, a second copies each RESULT into a ring with one
+// slot per pin. Reading a knob is then just a memory read.
+// On the Grand Central A2 is on ADC0 and A3 - A7 are on ADC1, so both ADCs
+// are used and each needs two DMA channels.
+
+#include <Arduino.h>
+#include "dmaHandler.h"
+
+#ifndef ADCSCANNER_H
+#define ADCSCANNER_H
+
+#define ADC_SCAN_MAX_PINS 8   // Pins per scanner
+
+class adcScanner {
+  public:
+    adcScanner();
+    adcScanner(int first_dma_channel);
+    void begin(const int *pins, int n);
+    int getCount();
+    uint16_t read(int i);
+    void readAll(uint16_t *dst);
+
+  private:
+    void startADC(int a);
+
+    int first_dma_channel;
+    int n_pins;
+    uint8_t slot[ADC_SCAN_MAX_PINS];       // ADC * ADC_SCAN_MAX_PINS + index within that ADC's ring
+    int n_seq[2];                          // pins on ADC0 and ADC1
+    uint32_t seq[2][ADC_SCAN_MAX_PINS];    // INPUTCTRL value of each conversion
+    volatile uint16_t results[2][ADC_SCAN_MAX_PINS];
+};
+
+#endif
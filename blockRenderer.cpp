@@ -0,0 +1,35 @@
+#include "blockRenderer.h"
+#include "wavetable.h"
+
+BlockRenderer::BlockRenderer() {
+  this -> voices = 0;
+  this -> sample_clock = 0;
+}
+
+BlockRenderer::BlockRenderer(VoicePool *voices) {
+  this -> voices = voices;
+  this -> sample_clock = 0;
+}
+
+// Fill block with the next n samples of all playing voices
+void BlockRenderer::render(uint16_t *block, int n) {
+  this -> sample_clock += n;
+  if (this -> voices == 0) {
+    silence(block, n);
+    return;
+  }
+
+  this -> voices -> mix(block, n);
+}
+
+// Fill block with the DAC mid-scale code that idle voices mix to
+void BlockRenderer::silence(uint16_t *block, int n) {
+  for (int i = 0; i < n; i++) {
+    block[i] = DAC_MID_CODE;
+  }
+}
+
+// Sample time of the end of the last rendered block, used to stamp events
+uint32_t BlockRenderer::getSampleClock() {
+  return this -> sample_clock;
+}
@@ -0,0 +1,31 @@
+/*
+  blockRenderer.h
+  Renders blocks of DAC samples for the audio output
+
+  The DAC is fed by DMA from two ping-pong buffers, so samples are produced a
+  block at a time from the DMA interrupt instead of one interrupt per sample.
+  Plain C++ so throughput can also be measured on a host machine.
+*/
+
+#ifndef BLOCKRENDERER_H
+#define BLOCKRENDERER_H
+
+#include <stdint.h>
+#include "voicePool.h"
+
+#define AUDIO_BLOCK_SIZE 64   // Samples per DMA buffer (1.28 ms at 50 kHz)
+
+class BlockRenderer {
+  public:
+    BlockRenderer();
+    BlockRenderer(VoicePool *voices);
+    void render(uint16_t *block, int n);
+    void silence(uint16_t *block, int n);
+    uint32_t getSampleClock();
+
+  private:
+    VoicePool *voices;
+    volatile uint32_t sample_clock;   // samples rendered since start
+};
+
+#endif
@@ -0,0 +1,66 @@
+#include "controlScheduler.h"
+
+ControlScheduler::ControlScheduler() {
+  this -> n_tasks = 0;
+  this -> ticks = 0;
+}
+
+// Add a task that first runs phase ticks from now and then every period
+// ticks. Returns the task number, or -1 when the table is full.
+int ControlScheduler::addTask(void (*f)(), uint32_t period, uint32_t phase) {
+  if (this -> n_tasks >= CONTROL_MAX_TASKS || f == 0) {
+    return -1;
+  }
+  if (period == 0) {
+    period = 1;
+  }
+
+  ControlTask &t = this -> tasks[this -> n_tasks];
+  t.f = f;
+  t.period = period;
+  t.next_due = this -> ticks + phase;
+  t.runs = 0;
+  t.misses = 0;
+  return this -> n_tasks++;
+}
+
+// Called from the timer interrupt (or by a host test as a virtual clock)
+void ControlScheduler::tick() {
+  this -> ticks = this -> ticks + 1;
+}
+
+uint32_t ControlScheduler::getTicks() {
+  return this -> ticks;
+}
+
+// Run every task that is due, in table order. Returns the number of tasks run.
+int ControlScheduler::run() {
+  uint32_t now = this -> ticks;
+  int count = 0;
+
+  for (int i = 0; i < this -> n_tasks; i++) {
+    ControlTask &t = this -> tasks[i];
+    uint32_t late = now - t.next_due;
+    if ((int32_t)late < 0) {
+      continue;
+    }
+
+    t.f();
+    t.runs++;
+    count++;
+
+    // Skip deadlines that have already passed rather than running in a burst
+    uint32_t skipped = late >= t.period ? late / t.period : 0;
+    t.misses += skipped;
+    t.next_due += (skipped + 1) * t.period;
+  }
+  return count;
+}
+
+uint32_t ControlScheduler::getRuns(int task) {
+  return this -> tasks[task].runs;
+}
+
+uint32_t ControlScheduler::getMisses(int task) {
+  return this -> tasks[task].misses;
+}
@@ -0,0 +1,46 @@
+/*
+  controlScheduler.h
+  Cooperative control-rate task scheduler
+
+  One timer interrupt only counts ticks; loop() calls run(), which calls
+  every task whose deadline has come. Each task has a period and a phase
+  offset in ticks, so slow work (knob reads, envelope parameters) is spread
+  over different ticks instead of each having its own timer. A task that
+  falls behind by whole periods runs once and has the skipped runs counted
+  as misses. Plain C++, so it can be driven by a virtual clock on a host.
+*/
+
+#ifndef CONTROLSCHEDULER_H
+#define CONTROLSCHEDULER_H
+
+#include <stdint.h>
+
+#define CONTROL_MAX_TASKS 8            // Size of the static task table
+#define CONTROL_TICK_RATE 1000UL       // Ticks per second
+#define CONTROL_TICK_PERIOD (100000000UL / CONTROL_TICK_RATE)   // Tick period in 10s of ns (TC_Timer units)
+
+struct ControlTask {
+  void (*f)();
+  uint32_t period;     // ticks between runs
+  uint32_t next_due;   // tick of the next run
+  uint32_t runs;
+  uint32_t misses;     // runs skipped because the task was late by a whole period
+};
+
+class ControlScheduler {
+  public:
+    ControlScheduler();
+    int addTask(void (*f)(), uint32_t period, uint32_t phase);
+    void tick();
+    uint32_t getTicks();
+    int run();
+    uint32_t getRuns(int task);
+    uint32_t getMisses(int task);
+
+  private:
+    ControlTask tasks[CONTROL_MAX_TASKS];
+    int n_tasks;
+    volatile uint32_t ticks;
+};
+
+#endif
@@ -0,0 +1,192 @@
+#include "dmaHandler.h"
+#include "profiler.h"
+
+// The DMAC reads its first descriptor for each channel from BASEADDR and
+// writes the channel state back to WRBADDR. The second ping-pong descriptor
+// of each channel is kept in dma_linked.
+static DmacDescriptor dma_descriptors[DMAC_CH_NUM] __attribute__((aligned(16)));
+static DmacDescriptor dma_writeback[DMAC_CH_NUM] __attribute__((aligned(16)));
+static DmacDescriptor dma_linked[DMAC_CH_NUM] __attribute__((aligned(16)));
+
+// Every DMAC interrupt line gets the same NVIC priority, so the block
+// callbacks never preempt each other. Synth::renderVca() (channel 5, on the
+// DMAC_4 line) relies on not running in the middle of Synth::render()
+// (channel 0).
+#define DMA_IRQ_PRIORITY 2
+
+static void (*dma_callbacks[DMAC_CH_NUM])(uint16_t *block, int n);
+static uint16_t *dma_buffers[DMAC_CH_NUM][2];
+static int dma_block_size[DMAC_CH_NUM];
+static volatile uint8_t dma_current[DMAC_CH_NUM];       // buffer being sent
+static volatile unsigned long dma_blocks[DMAC_CH_NUM];  // completed blocks
+
+static void set_descriptor(DmacDescriptor *d, uint16_t *src, volatile void *dst,
+                           int n, DmacDescriptor *next) {
+  d->BTCTRL.reg = DMAC_BTCTRL_VALID |
+                  DMAC_BTCTRL_BLOCKACT_INT |     // interrupt, then continue with the next descriptor
+                  DMAC_BTCTRL_BEATSIZE_HWORD |
+                  DMAC_BTCTRL_SRCINC;
+  d->BTCNT.reg = n;
+  d->SRCADDR.reg = (uint32_t)(src + n);          // with SRCINC the source is the end address
+  d->DSTADDR.reg = (uint32_t)dst;
+  d->DESCADDR.reg = (uint32_t)next;
+}
+
+static void dma_irq(int ch) {
+  PROFILE_SCOPE(ch < 4 ? PROF_DMAC0 + ch : PROF_DMAC4);
+
+  DMAC->Channel[ch].CHINTFLAG.reg = DMAC_CHINTFLAG_TCMPL;
+
+  // The DMA has already moved on to the other buffer, refill this one
+  uint8_t done = dma_current[ch];
+  dma_current[ch] = done ^ 1;
+  dma_blocks[ch]++;
+
+  if (dma_callbacks[ch] != NULL) {
+    (*dma_callbacks[ch])(dma_buffers[ch][done], dma_block_size[ch]);
+  }
+}
+
+dmaHandler::dmaHandler() {
+  this -> channel = 0;
+}
+
+dmaHandler::dmaHandler(int channel) {
+  if (channel >= 0 && channel < DMAC_CH_NUM) {
+    this -> channel = channel;
+  } else {
+    this -> channel = 0;
+  }
+}
+
+int dmaHandler::getChannel() {
+  return this -> channel;
+}
+
+void dmaHandler::init() {
+  static bool initialised = false;
+  if (initialised) {
+    return;
+  }
+
+  MCLK->AHBMASK.bit.DMAC_ = 1;
+
+  DMAC->CTRL.bit.DMAENABLE = 0;
+  DMAC->CTRL.bit.SWRST = 1;
+  while (DMAC->CTRL.bit.SWRST);
+
+  DMAC->BASEADDR.reg = (uint32_t)dma_descriptors;
+  DMAC->WRBADDR.reg = (uint32_t)dma_writeback;
+  DMAC->CTRL.reg = DMAC_CTRL_DMAENABLE | DMAC_CTRL_LVLEN(0xF);
+
+  initialised = true;
+}
+
+// Send buf0, then buf1, then buf0 again... to dst, one half-word per trigger.
+// f is called from the DMA interrupt with the buffer that was just sent.
+void dmaHandler::startPingPong(int trigger, volatile void *dst, uint16_t *buf0, uint16_t *buf1,
+                               int n, void (*f)(uint16_t *block, int n)) {
+  int ch = this -> channel;
+  init();
+
+  DMAC->Channel[ch].CHCTRLA.bit.ENABLE = 0;
+  DMAC->Channel[ch].CHCTRLA.bit.SWRST = 1;
+  while (DMAC->Channel[ch].CHCTRLA.bit.SWRST);
+
+  dma_callbacks[ch] = f;
+  dma_buffers[ch][0] = buf0;
+  dma_buffers[ch][1] = buf1;
+  dma_block_size[ch] = n;
+  dma_current[ch] = 0;
+  dma_blocks[ch] = 0;
+
+  set_descriptor(&dma_descriptors[ch], buf0, dst, n, &dma_linked[ch]);
+  set_descriptor(&dma_linked[ch], buf1, dst, n, &dma_descriptors[ch]);
+
+  DMAC->Channel[ch].CHCTRLA.reg = DMAC_CHCTRLA_TRIGSRC(trigger) |
+                                  DMAC_CHCTRLA_TRIGACT_BURST |      // one beat per trigger
+                                  DMAC_CHCTRLA_BURSTLEN_SINGLE;
+  DMAC->Channel[ch].CHPRILVL.reg = DMAC_CHPRILVL_PRILVL_LVL3;
+  DMAC->Channel[ch].CHINTENSET.reg = DMAC_CHINTENSET_TCMPL;
+
+  IRQn_Type irq = ch < 4 ? (IRQn_Type)(DMAC_0_IRQn + ch) : DMAC_4_IRQn;
+  NVIC_SetPriority(irq, DMA_IRQ_PRIORITY);
+  NVIC_EnableIRQ(irq);
+
+  DMAC->Channel[ch].CHCTRLA.bit.ENABLE = 1;
+}
+
+// Move n beats of beat_bytes (2 or 4) from src to dst, one beat per trigger,
+// and start over at the beginning when the block is done. Incremented
+// addresses wrap back to src/dst, so a memory buffer becomes a ring.
+void dmaHandler::startCircular(int trigger, volatile void *src, volatile void *dst, int n,
+                               int beat_bytes, bool src_inc, bool dst_inc) {
+  int ch = this -> channel;
+  init();
+
+  DMAC->Channel[ch].CHCTRLA.bit.ENABLE = 0;
+  DMAC->Channel[ch].CHCTRLA.bit.SWRST = 1;
+  while (DMAC->Channel[ch].CHCTRLA.bit.SWRST);
+
+  dma_callbacks[ch] = NULL;
+
+  DmacDescriptor *d = &dma_descriptors[ch];
+  uint32_t src_addr = (uint32_t)src;
+  uint32_t dst_addr = (uint32_t)dst;
+  uint16_t btctrl = DMAC_BTCTRL_VALID | DMAC_BTCTRL_BLOCKACT_NOACT;
+  btctrl |= (beat_bytes == 4) ? DMAC_BTCTRL_BEATSIZE_WORD : DMAC_BTCTRL_BEATSIZE_HWORD;
+  if (src_inc) {
+    btctrl |= DMAC_BTCTRL_SRCINC;
+    src_addr += n * beat_bytes;                    // incremented addresses are end addresses
+  }
+  if (dst_inc) {
+    btctrl |= DMAC_BTCTRL_DSTINC;
+    dst_addr += n * beat_bytes;
+  }
+  d->BTCTRL.reg = btctrl;
+  d->BTCNT.reg = n;
+  d->SRCADDR.reg = src_addr;
+  d->DSTADDR.reg = dst_addr;
+  d->DESCADDR.reg = (uint32_t)d;                   // loop on itself
+
+  DMAC->Channel[ch].CHCTRLA.reg = DMAC_CHCTRLA_TRIGSRC(trigger) |
+                                  DMAC_CHCTRLA_TRIGACT_BURST |
+                                  DMAC_CHCTRLA_BURSTLEN_SINGLE;
+  DMAC->Channel[ch].CHPRILVL.reg = DMAC_CHPRILVL_PRILVL_LVL0;  // below the audio stream
+  DMAC->Channel[ch].CHCTRLA.bit.ENABLE = 1;
+}
+
+void dmaHandler::stop() {
+  DMAC->Channel[this -> channel].CHCTRLA.bit.ENABLE = 0;
+}
+
+unsigned long dmaHandler::getBlockCount() {
+  return dma_blocks[this -> channel];
+}
+
+
+void DMAC_0_Handler() {
+  dma_irq(0);
+}
+
+void DMAC_1_Handler() {
+  dma_irq(1);
+}
+
+void DMAC_2_Handler() {
+  dma_irq(2);
+}
+
+void DMAC_3_Handler() {
+  dma_irq(3);
+}
+
+// Channels 4 and up share one interrupt line
+void DMAC_4_Handler() {
+  uint32_t pending = DMAC->INTSTATUS.reg & ~0xFUL;
+  for (int ch = 4; ch < DMAC_CH_NUM; ch++) {
+    if (pending & (1UL << ch)) {
+      dma_irq(ch);
+    }
+  }
+}
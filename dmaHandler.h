@@ -0,0 +1,30 @@
+// This class streams ping-pong buffers to a peripheral register using the
+// SAMD51 DMA controller. Each transfer is paced by a hardware trigger (e.g.
+// a TC overflow), and a callback is run from the DMA interrupt whenever one
+// of the two buffers has been sent so that it can be refilled.
+// startCircular() instead repeats one block forever with no interrupt, for
+// peripherals that are read or fed continuously (e.g. ADC scanning).
+
+#include <Arduino.h>
+
+#ifndef DMAHANDLER_H
+#define DMAHANDLER_H
+
+class dmaHandler {
+  public:
+    dmaHandler();
+    dmaHandler(int channel);
+    int getChannel();
+    void startPingPong(int trigger, volatile void *dst, uint16_t *buf0, uint16_t *buf1,
+                       int n, void (*f)(uint16_t *block, int n));
+    void startCircular(int trigger, volatile void *src, volatile void *dst, int n,
+                       int beat_bytes, bool src_inc, bool dst_inc);
+    void stop();
+    unsigned long getBlockCount();
+
+  private:
+    int channel;
+    static void init();
+};
+
+#endif
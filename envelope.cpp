@@ -0,0 +1,178 @@
+#include "envelope.h"
+#include <math.h>
+
+#define ENV_CURVE_STEPS (1 << ENV_CURVE_BITS)
+#define ENV_ATTACK_SHAPE 2.0   // Curvature of the attack rise
+#define ENV_DECAY_SHAPE 5.0    // Curvature of the decay and release fall
+
+// Normalised 1 - e^(-kx) curves, filled once at startup
+static uint16_t attack_curve[ENV_CURVE_STEPS + 1];
+static uint16_t decay_curve[ENV_CURVE_STEPS + 1];
+
+static void fill_curve(uint16_t *curve, double k) {
+  for (int i = 0; i <= ENV_CURVE_STEPS; i++) {
+    double x = (double)i / ENV_CURVE_STEPS;
+    double y = (1.0 - exp(-k * x)) / (1.0 - exp(-k));
+    curve[i] = (uint16_t)(y * ENV_CURVE_ONE + 0.5);
+  }
+}
+
+static struct EnvelopeCurves {
+  EnvelopeCurves() {
+    fill_curve(attack_curve, ENV_ATTACK_SHAPE);
+    fill_curve(decay_curve, ENV_DECAY_SHAPE);
+  }
+} envelope_curves;
+
+// Curve value at position p of a stage, interpolated between table steps
+static inline int32_t curve_at(const uint16_t *curve, uint32_t p) {
+  uint32_t idx = p >> (ENV_SEGMENT_BITS - ENV_CURVE_BITS);
+  int32_t frac = (p >> (ENV_SEGMENT_BITS - ENV_CURVE_BITS - 15)) & 0x7FFF;
+  int32_t a = curve[idx];
+  int32_t b = curve[idx + 1];
+  return a + (((b - a) * frac) >> 15);
+}
+
+uint32_t envelope_increment(int ms, unsigned long sample_rate) {
+  uint64_t samples = (uint64_t)(ms < 0 ? 0 : ms) * sample_rate / 1000;
+  if (samples <= 1) {
+    return ENV_SEGMENT_END;
+  }
+  return (uint32_t)((ENV_SEGMENT_END + samples / 2) / samples);
+}
+
+void envelope_set_params(EnvelopeParams *p, int attack_ms, int decay_ms, uint16_t sustain,
+                         int release_ms, unsigned long sample_rate) {
+  p -> attack_inc = envelope_increment(attack_ms, sample_rate);
+  p -> decay_inc = envelope_increment(decay_ms, sample_rate);
+  p -> release_inc = envelope_increment(release_ms, sample_rate);
+  p -> sustain = sustain;
+}
+
+Envelope::Envelope() {
+  this -> params = 0;
+  reset();
+}
+
+void Envelope::setParams(const EnvelopeParams *params) {
+  this -> params = params;
+}
+
+// Start the attack from the current level, so a retrigger does not click
+void Envelope::noteOn() {
+  enterStage(ENV_ATTACK);
+}
+
+void Envelope::noteOff() {
+  if (isHeld()) {
+    enterStage(ENV_RELEASE);
+  }
+}
+
+void Envelope::reset() {
+  this -> pos = 0;
+  this -> start = 0;
+  this -> level = 0;
+  this -> stage = ENV_IDLE;
+}
+
+void Envelope::enterStage(int st) {
+  this -> stage = st;
+  this -> start = this -> level;
+  this -> pos = 0;
+  if (st == ENV_SUSTAIN) {
+    this -> level = this -> params -> sustain;
+  } else if (st == ENV_IDLE) {
+    this -> level = 0;
+  }
+}
+
+uint16_t Envelope::levelAt(uint32_t p) {
+  int32_t s = this -> start;
+  int32_t c;
+
+  switch (this -> stage) {
+    case ENV_ATTACK:
+      c = curve_at(attack_curve, p);
+      return s + (((ENV_LEVEL_MAX - s) * c) >> 15);
+
+    case ENV_DECAY: {
+      int32_t sus = this -> params -> sustain;
+      c = ENV_CURVE_ONE - curve_at(decay_curve, p);
+      return sus + (((s - sus) * c) >> 15);
+    }
+
+    case ENV_SUSTAIN:
+      return this -> params -> sustain;
+
+    case ENV_RELEASE:
+      c = ENV_CURVE_ONE - curve_at(decay_curve, p);
+      return (s * c) >> 15;
+  }
+  return 0;
+}
+
+// Advance one sample and return the new level
+uint16_t Envelope::next() {
+  return advance(1);
+}
+
+// Advance n samples and return the level at the end of them. Samples left
+// over when a stage ends are carried into the next stage.
+uint16_t Envelope::advance(int n) {
+  while (n > 0) {
+    uint32_t inc;
+    switch (this -> stage) {
+      case ENV_ATTACK:
+        inc = this -> params -> attack_inc;
+        break;
+      case ENV_DECAY:
+        inc = this -> params -> decay_inc;
+        break;
+      case ENV_RELEASE:
+        inc = this -> params -> release_inc;
+        break;
+      case ENV_SUSTAIN:
+        this -> level = this -> params -> sustain;
+        return this -> level;
+      default:
+        return 0;
+    }
+
+    uint64_t p = this -> pos + (uint64_t)inc * n;
+    if (p < ENV_SEGMENT_END) {
+      this -> pos = (uint32_t)p;
+      this -> level = levelAt(this -> pos);
+      return this -> level;
+    }
+
+    // Stage finished part way through: carry the remaining samples over
+    n = (int)((p - ENV_SEGMENT_END) / inc);
+    if (this -> stage == ENV_ATTACK) {
+      this -> level = ENV_LEVEL_MAX;
+      enterStage(ENV_DECAY);
+    } else if (this -> stage == ENV_DECAY) {
+      enterStage(ENV_SUSTAIN);
+    } else {
+      enterStage(ENV_IDLE);
+    }
+  }
+  return this -> level;
+}
+
+uint16_t Envelope::getLevel() {
+  return this -> level;
+}
+
+int Envelope::getStage() {
+  return this -> stage;
+}
+
+bool Envelope::isActive() {
+  return this -> stage != ENV_IDLE;
+}
+
+// Key still down (attack, decay or sustain)
+bool Envelope::isHeld() {
+  return this -> stage == ENV_ATTACK || this -> stage == ENV_DECAY || this -> stage == ENV_SUSTAIN;
+}
@@ -0,0 +1,72 @@
+/*
+  envelope.h
+  Table-driven exponential ADSR envelope generator
+
+  Each stage is a segment that a fixed-point position walks from 0 to
+  ENV_SEGMENT_END, advanced by a per-sample increment worked out once from
+  the stage time. The position indexes a precomputed exponential curve, so
+  no timers are reprogrammed and nothing is divided per sample. State is kept
+  per instance and the times are shared through EnvelopeParams, so the same
+  code runs once per block for the VCA and once per voice in the mixer.
+  Plain C++ so it can also be built and measured on a host machine.
+*/
+
+#ifndef ENVELOPE_H
+#define ENVELOPE_H
+
+#include <stdint.h>
+
+#define ENV_LEVEL_MAX 65535          // Full-scale envelope output
+#define ENV_SEGMENT_BITS 30
+#define ENV_SEGMENT_END (1UL << ENV_SEGMENT_BITS)   // Position at the end of a stage
+#define ENV_CURVE_BITS 8             // log2 of the number of curve table steps
+#define ENV_CURVE_ONE 32768          // Curve tables are Q15
+
+enum EnvelopeStage {
+  ENV_IDLE,
+  ENV_ATTACK,
+  ENV_DECAY,
+  ENV_SUSTAIN,
+  ENV_RELEASE
+};
+
+// Stage times shared by every envelope that uses them
+struct EnvelopeParams {
+  uint32_t attack_inc;
+  uint32_t decay_inc;
+  uint32_t release_inc;
+  uint16_t sustain;   // 0..ENV_LEVEL_MAX
+};
+
+// Per-sample position increment for a stage that lasts ms milliseconds
+uint32_t envelope_increment(int ms, unsigned long sample_rate);
+
+void envelope_set_params(EnvelopeParams *p, int attack_ms, int decay_ms, uint16_t sustain,
+                         int release_ms, unsigned long sample_rate);
+
+class Envelope {
+  public:
+    Envelope();
+    void setParams(const EnvelopeParams *params);
+    void noteOn();
+    void noteOff();
+    void reset();
+    uint16_t next();
+    uint16_t advance(int n);
+    uint16_t getLevel();
+    int getStage();
+    bool isActive();
+    bool isHeld();
+
+  private:
+    void enterStage(int st);
+    uint16_t levelAt(uint32_t p);
+
+    const EnvelopeParams *params;
+    uint32_t pos;     // position within the current stage
+    uint16_t start;   // level the current stage started from
+    uint16_t level;
+    uint8_t stage;
+};
+
+#endif
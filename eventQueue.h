@@ -0,0 +1,80 @@
+/*
+  eventQueue.h
+  Lock-free single-producer/single-consumer queue of synth events
+
+  MIDI callbacks and knob scanning run from loop() and only push events;
+  the audio interrupt pops them as they fall due in each block, so all voice,
+  envelope and knob state is changed from one context. The producer only
+  writes head and the consumer only writes tail, so no locks or disabled
+  interrupts are needed. Plain C++ so it can also be exercised from two
+  threads on a host machine.
+*/
+
+#ifndef EVENTQUEUE_H
+#define EVENTQUEUE_H
+
+#include <stdint.h>
+#include <atomic>
+
+enum SynthEventType {
+  EVENT_NOTE_ON,
+  EVENT_NOTE_OFF,
+  EVENT_PARAM      // note is the parameter number, value its new value
+};
+
+struct SynthEvent {
+  uint32_t timestamp;   // sample clock the event is due at
+  uint8_t type;         // SynthEventType
+  uint8_t channel;
+  uint8_t note;
+  uint8_t velocity;
+  uint16_t value;
+};
+
+// N must be a power of two; the queue holds up to N - 1 events
+template <typename T, int N>
+class EventQueue {
+  public:
+    EventQueue() : head(0), tail(0), dropped(0) {}
+
+    // Producer side. Returns false (and counts a drop) when the queue is full.
+    bool push(const T &item) {
+      uint32_t h = this -> head.load(std::memory_order_relaxed);
+      if (h - this -> tail.load(std::memory_order_acquire) >= N - 1) {
+        this -> dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      }
+      this -> items[h & (N - 1)] = item;
+      this -> head.store(h + 1, std::memory_order_release);
+      return true;
+    }
+
+    // Consumer side. Returns false when the queue is empty.
+    bool pop(T &item) {
+      uint32_t t = this -> tail.load(std::memory_order_relaxed);
+      if (t == this -> head.load(std::memory_order_acquire)) {
+        return false;
+      }
+      item = this -> items[t & (N - 1)];
+      this -> tail.store(t + 1, std::memory_order_release);
+      return true;
+    }
+
+    int size() {
+      return this -> head.load(std::memory_order_acquire) - this -> tail.load(std::memory_order_acquire);
+    }
+
+    unsigned long getDropped() {
+      return this -> dropped.load(std::memory_order_relaxed);
+    }
+
+  private:
+    static_assert((N & (N - 1)) == 0, "queue size must be a power of two");
+
+    T items[N];
+    std::atomic<uint32_t> head;
+    std::atomic<uint32_t> tail;
+    std::atomic<uint32_t> dropped;
+};
+
+#endif
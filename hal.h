@@ -0,0 +1,75 @@
+/*
+  hal.h
+  Hardware abstraction for the synth
+
+  The synth only talks to hardware through these interfaces: the audio
+  output (a DAC fed a block at a time), 8-bit PWM control voltages or PWM
+  streamed from buffers, periodic timers, scanned analog inputs, the MIDI
+  byte stream and files on the SD card. halSAMD51.h wraps the existing
+  drivers for the board, halLinux.h runs the same synth code from a virtual
+  clock on a workstation and captures its output.
+*/
+
+#ifndef HAL_H
+#define HAL_H
+
+#include <stdint.h>
+
+// Plays blocks of DAC codes at AUDIO_SAMPLE_RATE from two ping-pong buffers.
+// f is called from interrupt context with each buffer once it has been played.
+class HalAudioOut {
+  public:
+    virtual void start(uint16_t *buf0, uint16_t *buf1, int n, void (*f)(uint16_t *block, int n)) = 0;
+    virtual void stop() = 0;
+};
+
+class HalPwm {
+  public:
+    virtual void write(uint8_t val) = 0;
+};
+
+// PWM fed one duty value per PWM period from two ping-pong buffers, for
+// control voltages that have to move faster than once per audio block.
+// f is called from interrupt context with each buffer once it has been sent.
+class HalPwmStream {
+  public:
+    virtual void start(uint16_t *buf0, uint16_t *buf1, int n, void (*f)(uint16_t *block, int n)) = 0;
+    virtual void stop() = 0;
+    virtual unsigned long getRate() = 0;   // values per second
+    virtual uint16_t getTop() = 0;         // duty value of a fully on output
+};
+
+// Calls f from interrupt context every period (in 10s of ns, like TC_Timer)
+class HalTimer {
+  public:
+    virtual void start(unsigned long period, void (*f)()) = 0;
+    virtual void stop() = 0;
+};
+
+// Converts pins in the background; readAll() returns the latest 10-bit values
+class HalAdc {
+  public:
+    virtual void begin(const int *pins, int n) = 0;
+    virtual void readAll(uint16_t *dst) = 0;
+};
+
+class HalMidiIn {
+  public:
+    virtual int available() = 0;
+    virtual int read() = 0;                    // next byte, -1 when none
+    virtual int read(uint8_t *dst, int n) = 0; // up to n bytes already received, never waits
+};
+
+// A file read front to back in blocks. read() may return fewer bytes than
+// asked for while the storage is busy; available() says whether more follow.
+class HalFile {
+  public:
+    virtual bool open(const char *name) = 0;
+    virtual void close() = 0;
+    virtual uint32_t size() = 0;
+    virtual uint32_t available() = 0;         // bytes left after the read position
+    virtual bool seek(uint32_t pos) = 0;
+    virtual int read(void *dst, int n) = 0;   // bytes read, -1 on error
+};
+
+#endif
@@ -0,0 +1,327 @@
+#ifndef ARDUINO
+
+#include "halLinux.h"
+#include "oscillator.h"
+#include <algorithm>
+
+LinuxDevice::LinuxDevice() {
+  this -> clock = 0;
+  this -> next_due = 0;
+  this -> running = false;
+}
+
+LinuxClock::LinuxClock() {
+  this -> idle = 0;
+  this -> time = 0;
+}
+
+void LinuxClock::attach(LinuxDevice *d) {
+  d -> clock = this;
+  this -> devices.push_back(d);
+}
+
+// f runs after every simulated interrupt, like loop() would between them
+void LinuxClock::setIdle(void (*f)()) {
+  this -> idle = f;
+}
+
+uint64_t LinuxClock::now() {
+  return this -> time;
+}
+
+// Advance the clock, firing every device that falls due in time order
+void LinuxClock::run(uint64_t duration) {
+  uint64_t end = this -> time + duration;
+
+  for (;;) {
+    LinuxDevice *next = 0;
+    for (size_t i = 0; i < this -> devices.size(); i++) {
+      LinuxDevice *d = this -> devices[i];
+      if (d -> running && d -> next_due <= end && (next == 0 || d -> next_due < next -> next_due)) {
+        next = d;
+      }
+    }
+    if (next == 0) {
+      break;
+    }
+
+    this -> time = next -> next_due;
+    next -> fire();
+    if (this -> idle != 0) {
+      this -> idle();
+    }
+  }
+  this -> time = end;
+}
+
+void LinuxClock::runSamples(unsigned long n) {
+  run((uint64_t)n * AUDIO_TIMER_PERIOD);
+}
+
+LinuxAudioOut::LinuxAudioOut(LinuxClock *clock) {
+  clock -> attach(this);
+  this -> buffers[0] = 0;
+  this -> buffers[1] = 0;
+  this -> block_size = 0;
+  this -> current = 0;
+  this -> callback = 0;
+}
+
+void LinuxAudioOut::start(uint16_t *buf0, uint16_t *buf1, int n, void (*f)(uint16_t *block, int n)) {
+  this -> buffers[0] = buf0;
+  this -> buffers[1] = buf1;
+  this -> block_size = n;
+  this -> current = 0;
+  this -> callback = f;
+  this -> next_due = this -> clock -> now() + (uint64_t)n * AUDIO_TIMER_PERIOD;
+  this -> running = true;
+}
+
+void LinuxAudioOut::stop() {
+  this -> running = false;
+}
+
+// A block has been played: capture it and hand it back for refilling while
+// the other buffer plays, as the DMA interrupt does
+void LinuxAudioOut::fire() {
+  int done = this -> current;
+  uint16_t *block = this -> buffers[done];
+
+  this -> output.insert(this -> output.end(), block, block + this -> block_size);
+  this -> current = done ^ 1;
+  this -> next_due += (uint64_t)this -> block_size * AUDIO_TIMER_PERIOD;
+
+  if (this -> callback != 0) {
+    this -> callback(block, this -> block_size);
+  }
+}
+
+LinuxPwm::LinuxPwm(LinuxClock *clock) {
+  this -> clock = clock;
+  this -> value = 0;
+}
+
+void LinuxPwm::write(uint8_t val) {
+  if (this -> changes.empty() || val != this -> value) {
+    Change c;
+    c.time = this -> clock -> now();
+    c.value = val;
+    this -> changes.push_back(c);
+  }
+  this -> value = val;
+}
+
+uint8_t LinuxPwm::getValue() {
+  return this -> value;
+}
+
+LinuxPwmStream::LinuxPwmStream(LinuxClock *clock, unsigned long rate, uint16_t top) {
+  clock -> attach(this);
+  this -> started = 0;
+  this -> rate = rate;
+  this -> top = top;
+  this -> buffers[0] = 0;
+  this -> buffers[1] = 0;
+  this -> block_size = 0;
+  this -> current = 0;
+  this -> sent = 0;
+  this -> callback = 0;
+}
+
+void LinuxPwmStream::start(uint16_t *buf0, uint16_t *buf1, int n, void (*f)(uint16_t *block, int n)) {
+  this -> buffers[0] = buf0;
+  this -> buffers[1] = buf1;
+  this -> block_size = n;
+  this -> current = 0;
+  this -> callback = f;
+  this -> started = this -> clock -> now();
+  this -> sent = 0;
+  this -> next_due = this -> started + (uint64_t)n * 100000000UL / this -> rate;
+  this -> running = true;
+}
+
+void LinuxPwmStream::stop() {
+  this -> running = false;
+}
+
+unsigned long LinuxPwmStream::getRate() {
+  return this -> rate;
+}
+
+uint16_t LinuxPwmStream::getTop() {
+  return this -> top;
+}
+
+// The PWM periods do not divide the clock evenly, so block times are worked
+// out from the number of values sent since the start
+void LinuxPwmStream::fire() {
+  int done = this -> current;
+  uint16_t *block = this -> buffers[done];
+
+  this -> output.insert(this -> output.end(), block, block + this -> block_size);
+  this -> current = done ^ 1;
+  this -> sent += this -> block_size;
+  this -> next_due = this -> started + (this -> sent + this -> block_size) * 100000000UL / this -> rate;
+
+  if (this -> callback != 0) {
+    this -> callback(block, this -> block_size);
+  }
+}
+
+LinuxTimer::LinuxTimer(LinuxClock *clock) {
+  clock -> attach(this);
+  this -> period = 0;
+  this -> callback = 0;
+}
+
+void LinuxTimer::start(unsigned long period, void (*f)()) {
+  this -> period = period > 0 ? period : 1;
+  this -> callback = f;
+  this -> next_due = this -> clock -> now() + this -> period;
+  this -> running = true;
+}
+
+void LinuxTimer::stop() {
+  this -> running = false;
+}
+
+void LinuxTimer::fire() {
+  this -> next_due += this -> period;
+  if (this -> callback != 0) {
+    this -> callback();
+  }
+}
+
+LinuxAdc::LinuxAdc() {
+}
+
+void LinuxAdc::begin(const int *, int n) {
+  this -> values.assign(n, 0);
+}
+
+void LinuxAdc::readAll(uint16_t *dst) {
+  for (size_t i = 0; i < this -> values.size(); i++) {
+    dst[i] = this -> values[i];
+  }
+}
+
+void LinuxAdc::set(int i, uint16_t val) {
+  if (i >= 0 && i < (int)this -> values.size()) {
+    this -> values[i] = val;
+  }
+}
+
+void LinuxMidiIn::send(const uint8_t *bytes, int n) {
+  this -> bytes.insert(this -> bytes.end(), bytes, bytes + n);
+}
+
+int LinuxMidiIn::available() {
+  return this -> bytes.size();
+}
+
+int LinuxMidiIn::read() {
+  if (this -> bytes.empty()) {
+    return -1;
+  }
+  int b = this -> bytes.front();
+  this -> bytes.pop_front();
+  return b;
+}
+
+int LinuxMidiIn::read(uint8_t *dst, int n) {
+  if (n > (int)this -> bytes.size()) {
+    n = this -> bytes.size();
+  }
+  std::copy(this -> bytes.begin(), this -> bytes.begin() + n, dst);
+  this -> bytes.erase(this -> bytes.begin(), this -> bytes.begin() + n);
+  return n;
+}
+
+#define LINUX_FILE_BURST 4096   // most bytes a throttled file hands out at once
+
+LinuxFile::LinuxFile(LinuxClock *clock) {
+  this -> clock = clock;
+  this -> fp = 0;
+  this -> length = 0;
+  this -> pos = 0;
+  this -> rate = 0;
+  this -> credit = 0;
+  this -> last_time = 0;
+}
+
+LinuxFile::~LinuxFile() {
+  close();
+}
+
+void LinuxFile::setThroughput(unsigned long bytes_per_second) {
+  this -> rate = bytes_per_second;
+}
+
+bool LinuxFile::open(const char *name) {
+  close();
+  this -> fp = fopen(name, "rb");
+  if (this -> fp == 0) {
+    return false;
+  }
+  fseek(this -> fp, 0, SEEK_END);
+  this -> length = ftell(this -> fp);
+  fseek(this -> fp, 0, SEEK_SET);
+  this -> pos = 0;
+  this -> credit = (uint64_t)LINUX_FILE_BURST * 100000000UL;   // the first burst is ready at once
+  this -> last_time = this -> clock -> now();
+  return true;
+}
+
+void LinuxFile::close() {
+  if (this -> fp != 0) {
+    fclose(this -> fp);
+    this -> fp = 0;
+  }
+}
+
+uint32_t LinuxFile::size() {
+  return this -> length;
+}
+
+uint32_t LinuxFile::available() {
+  return this -> length - this -> pos;
+}
+
+bool LinuxFile::seek(uint32_t pos) {
+  if (this -> fp == 0 || pos > this -> length || fseek(this -> fp, pos, SEEK_SET) != 0) {
+    return false;
+  }
+  this -> pos = pos;
+  return true;
+}
+
+int LinuxFile::read(void *dst, int n) {
+  if (this -> fp == 0) {
+    return -1;
+  }
+
+  if (this -> rate != 0) {
+    // Earn rate bytes per second of virtual time, up to one burst
+    uint64_t now = this -> clock -> now();
+    const uint64_t burst = (uint64_t)LINUX_FILE_BURST * 100000000UL;
+    this -> credit += (now - this -> last_time) * this -> rate;
+    if (this -> credit > burst) {
+      this -> credit = burst;
+    }
+    this -> last_time = now;
+
+    uint64_t allowed = this -> credit / 100000000UL;
+    if ((uint64_t)n > allowed) {
+      n = allowed;
+    }
+  }
+
+  int got = fread(dst, 1, n, this -> fp);
+  this -> pos += got;
+  if (this -> rate != 0) {
+    this -> credit -= (uint64_t)got * 100000000UL;
+  }
+  return got;
+}
+
+#endif
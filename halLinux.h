@@ -0,0 +1,176 @@
+/*
+  halLinux.h
+  Linux simulation backend of the HAL in hal.h
+
+  Everything runs from a virtual clock (LinuxClock) in the same 10 ns units
+  as TC_Timer. Audio blocks and timer callbacks fire at their simulated times
+  as if they were interrupts, and an idle function stands in for loop()
+  between them. DAC samples and PWM writes are captured into buffers so the
+  synth can be profiled and regression tested on a workstation. Not built for
+  the board.
+*/
+
+#ifndef HALLINUX_H
+#define HALLINUX_H
+
+#ifndef ARDUINO
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <vector>
+#include <deque>
+#include "hal.h"
+
+class LinuxClock;
+
+// Something that fires at a time on the virtual clock
+class LinuxDevice {
+  public:
+    LinuxDevice();
+    virtual void fire() = 0;
+
+  protected:
+    friend class LinuxClock;
+    LinuxClock *clock;
+    uint64_t next_due;
+    bool running;
+};
+
+class LinuxClock {
+  public:
+    LinuxClock();
+    void attach(LinuxDevice *d);
+    void setIdle(void (*f)());
+    uint64_t now();
+    void run(uint64_t duration);
+    void runSamples(unsigned long n);
+
+  private:
+    std::vector<LinuxDevice *> devices;
+    void (*idle)();
+    uint64_t time;
+};
+
+// DAC fed by ping-pong buffers; every sample played is appended to output
+class LinuxAudioOut : public HalAudioOut, public LinuxDevice {
+  public:
+    LinuxAudioOut(LinuxClock *clock);
+    void start(uint16_t *buf0, uint16_t *buf1, int n, void (*f)(uint16_t *block, int n));
+    void stop();
+    void fire();
+
+    std::vector<uint16_t> output;
+
+  private:
+    uint16_t *buffers[2];
+    int block_size;
+    int current;
+    void (*callback)(uint16_t *block, int n);
+};
+
+// PWM output; every change of value is recorded with its time
+class LinuxPwm : public HalPwm {
+  public:
+    struct Change {
+      uint64_t time;
+      uint8_t value;
+    };
+
+    LinuxPwm(LinuxClock *clock);
+    void write(uint8_t val);
+    uint8_t getValue();
+
+    std::vector<Change> changes;
+
+  private:
+    LinuxClock *clock;
+    uint8_t value;
+};
+
+// PWM stream at rate values per second; every value sent is appended to output
+class LinuxPwmStream : public HalPwmStream, public LinuxDevice {
+  public:
+    LinuxPwmStream(LinuxClock *clock, unsigned long rate, uint16_t top);
+    void start(uint16_t *buf0, uint16_t *buf1, int n, void (*f)(uint16_t *block, int n));
+    void stop();
+    unsigned long getRate();
+    uint16_t getTop();
+    void fire();
+
+    std::vector<uint16_t> output;
+    uint64_t started;          // clock time of the first value
+
+  private:
+    unsigned long rate;
+    uint16_t top;
+    uint16_t *buffers[2];
+    int block_size;
+    int current;
+    uint64_t sent;             // values sent since start
+    void (*callback)(uint16_t *block, int n);
+};
+
+class LinuxTimer : public HalTimer, public LinuxDevice {
+  public:
+    LinuxTimer(LinuxClock *clock);
+    void start(unsigned long period, void (*f)());
+    void stop();
+    void fire();
+
+  private:
+    unsigned long period;
+    void (*callback)();
+};
+
+// Knob readings are whatever the test sets them to
+class LinuxAdc : public HalAdc {
+  public:
+    LinuxAdc();
+    void begin(const int *pins, int n);
+    void readAll(uint16_t *dst);
+    void set(int i, uint16_t val);
+
+  private:
+    std::vector<uint16_t> values;
+};
+
+class LinuxMidiIn : public HalMidiIn {
+  public:
+    void send(const uint8_t *bytes, int n);
+    int available();
+    int read();
+    int read(uint8_t *dst, int n);
+
+  private:
+    std::deque<uint8_t> bytes;
+};
+
+// Host file standing in for the SD card. setThroughput() limits how fast
+// reads return data on the virtual clock, to see how a reader copes with a
+// slow card; reads come back short (or empty) once the budget is used up.
+class LinuxFile : public HalFile {
+  public:
+    LinuxFile(LinuxClock *clock);
+    ~LinuxFile();
+    void setThroughput(unsigned long bytes_per_second);   // 0 for no limit
+    bool open(const char *name);
+    void close();
+    uint32_t size();
+    uint32_t available();
+    bool seek(uint32_t pos);
+    int read(void *dst, int n);
+
+  private:
+    LinuxClock *clock;
+    FILE *fp;
+    uint32_t length;
+    uint32_t pos;
+    unsigned long rate;
+    uint64_t credit;           // bytes that may be read, times 10^8
+    uint64_t last_time;        // clock time credit was last added
+};
+
+#endif
+
+#endif
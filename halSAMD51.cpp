@@ -0,0 +1,133 @@
+#include "halSAMD51.h"
+#include "oscillator.h"
+
+#define MIDI_BAUD_RATE 31250
+
+// The DMA is triggered by TC3 overflows, so TC3 is kept for audio pacing
+static TC_StaticTimer<3> audio_timer;
+
+Samd51AudioOut::Samd51AudioOut(int dma_channel) : dma(dma_channel) {
+}
+
+// The timer triggers one DMA transfer to the DAC per sample and the CPU only
+// wakes up to render a block
+void Samd51AudioOut::start(uint16_t *buf0, uint16_t *buf1, int n, void (*f)(uint16_t *block, int n)) {
+  analogWrite(A0, 0); // enable the DAC
+  this -> dma.startPingPong(TC3_DMAC_ID_OVF, &DAC->DATA[0].reg, buf0, buf1, n, f);
+  audio_timer.startTimer(AUDIO_TIMER_PERIOD, false);
+}
+
+void Samd51AudioOut::stop() {
+  audio_timer.stopTimer();
+  this -> dma.stop();
+}
+
+Samd51Pwm::Samd51Pwm(int pin) : pwm(pin) {
+}
+
+void Samd51Pwm::write(uint8_t val) {
+  this -> pwm.fast_pwm_analogWrite(val);
+}
+
+Samd51PwmStream::Samd51PwmStream(int pin, int dma_channel) : Samd51Pwm(pin), dma(dma_channel) {
+}
+
+void Samd51PwmStream::start(uint16_t *buf0, uint16_t *buf1, int n, void (*f)(uint16_t *block, int n)) {
+  this -> pwm.startStream(&(this -> dma), buf0, buf1, n, f);
+}
+
+void Samd51PwmStream::stop() {
+  this -> dma.stop();
+}
+
+unsigned long Samd51PwmStream::getRate() {
+  return PWM_FREQUENCY;
+}
+
+uint16_t Samd51PwmStream::getTop() {
+  return PWM_TOP;
+}
+
+Samd51Timer::Samd51Timer(int tc_number) : timer(tc_number) {
+}
+
+void Samd51Timer::start(unsigned long period, void (*f)()) {
+  this -> timer.startTimer(period, f);
+}
+
+void Samd51Timer::stop() {
+  this -> timer.stopTimer();
+}
+
+Samd51Adc::Samd51Adc(int first_dma_channel) : scanner(first_dma_channel) {
+}
+
+void Samd51Adc::begin(const int *pins, int n) {
+  this -> scanner.begin(pins, n);
+}
+
+void Samd51Adc::readAll(uint16_t *dst) {
+  this -> scanner.readAll(dst);
+}
+
+Samd51MidiIn::Samd51MidiIn(HardwareSerial *port) {
+  this -> port = port;
+}
+
+void Samd51MidiIn::begin() {
+  this -> port -> begin(MIDI_BAUD_RATE);
+}
+
+int Samd51MidiIn::available() {
+  return this -> port -> available();
+}
+
+int Samd51MidiIn::read() {
+  return this -> port -> read();
+}
+
+// Copy out of the receive ring what is there in one call. readBytes() only
+// waits for bytes it does not have yet, so asking for no more than
+// available() never runs into its timeout.
+int Samd51MidiIn::read(uint8_t *dst, int n) {
+  int avail = this -> port -> available();
+  if (n > avail) {
+    n = avail;
+  }
+  if (n <= 0) {
+    return 0;
+  }
+  return this -> port -> readBytes((char *)dst, n);
+}
+
+bool Samd51SdFile::begin() {
+  return SD.begin(SDCARD_SS_PIN);
+}
+
+bool Samd51SdFile::open(const char *name) {
+  close();
+  this -> file = SD.open(name);
+  return this -> file;
+}
+
+void Samd51SdFile::close() {
+  if (this -> file) {
+    this -> file.close();
+  }
+}
+
+uint32_t Samd51SdFile::size() {
+  return this -> file.size();
+}
+
+uint32_t Samd51SdFile::available() {
+  return this -> file.available();
+}
+
+bool Samd51SdFile::seek(uint32_t pos) {
+  return this -> file.seek(pos);
+}
+
+int Samd51SdFile::read(void *dst, int n) {
+  return this -> file.read(dst, n);
+}
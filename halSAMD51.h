@@ -0,0 +1,97 @@
+// SAMD51 (Grand Central) backend of the HAL in hal.h. Each class wraps one
+// of the existing drivers: audio goes to the DAC by DMA paced by TC3, PWM
+// uses pwmHandler (streams add a DMA channel), timers use TC_Timer, knobs use adcScanner and MIDI bytes
+// come from a hardware serial port. Files come from the SD card through the
+// Arduino SD library.
+
+#include <Arduino.h>
+#include <SD.h>
+#include "hal.h"
+#include "SAMD51_InterruptTimer.h"
+#include "pwmHandler.h"
+#include "dmaHandler.h"
+#include "adcScanner.h"
+
+#ifndef HALSAMD51_H
+#define HALSAMD51_H
+
+class Samd51AudioOut : public HalAudioOut {
+  public:
+    Samd51AudioOut(int dma_channel);
+    void start(uint16_t *buf0, uint16_t *buf1, int n, void (*f)(uint16_t *block, int n));
+    void stop();
+
+  private:
+    dmaHandler dma;
+};
+
+class Samd51Pwm : public HalPwm {
+  public:
+    Samd51Pwm(int pin);
+    void write(uint8_t val);
+
+  protected:
+    pwmHandler pwm;
+};
+
+// Streams a PWM pin by DMA, paced by the overflow of its TCC. It is also the
+// pin's HalPwm, so one object programs the pin whether it streams or not.
+class Samd51PwmStream : public Samd51Pwm, public HalPwmStream {
+  public:
+    Samd51PwmStream(int pin, int dma_channel);
+    void start(uint16_t *buf0, uint16_t *buf1, int n, void (*f)(uint16_t *block, int n));
+    void stop();
+    unsigned long getRate();
+    uint16_t getTop();
+
+  private:
+    dmaHandler dma;
+};
+
+class Samd51Timer : public HalTimer {
+  public:
+    Samd51Timer(int tc_number);
+    void start(unsigned long period, void (*f)());
+    void stop();
+
+  private:
+    TC_Timer timer;
+};
+
+class Samd51Adc : public HalAdc {
+  public:
+    Samd51Adc(int first_dma_channel);
+    void begin(const int *pins, int n);
+    void readAll(uint16_t *dst);
+
+  private:
+    adcScanner scanner;
+};
+
+class Samd51MidiIn : public HalMidiIn {
+  public:
+    Samd51MidiIn(HardwareSerial *port);
+    void begin();
+    int available();
+    int read();
+    int read(uint8_t *dst, int n);
+
+  private:
+    HardwareSerial *port;
+};
+
+class Samd51SdFile : public HalFile {
+  public:
+    static bool begin();   // mount the card, once before any open()
+    bool open(const char *name);
+    void close();
+    uint32_t size();
+    uint32_t available();
+    bool seek(uint32_t pos);
+    int read(void *dst, int n);
+
+  private:
+    File file;
+};
+
+#endif
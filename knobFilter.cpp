@@ -0,0 +1,64 @@
+#include "knobFilter.h"
+
+KnobFilter::KnobFilter() {
+  this -> max_value = 1023;
+  this -> shift = KNOB_SMOOTHING_SHIFT;
+  this -> hysteresis = KNOB_HYSTERESIS;
+  reset();
+}
+
+void KnobFilter::setup(uint16_t max_value, int smoothing_shift, int hysteresis) {
+  this -> max_value = max_value;
+  this -> shift = smoothing_shift;
+  this -> hysteresis = hysteresis;
+  reset();
+}
+
+// Forget the history, the next reading is published as is
+void KnobFilter::reset() {
+  this -> state = 0;
+  this -> value = 0;
+  this -> primed = false;
+}
+
+// Add a reading. Returns true when the published value changed.
+bool KnobFilter::update(uint16_t raw) {
+  if (raw > this -> max_value) {
+    raw = this -> max_value;
+  }
+
+  if (!this -> primed) {
+    this -> state = (int32_t)raw << 16;
+    this -> value = raw;
+    this -> primed = true;
+    return true;
+  }
+
+  this -> state += (((int32_t)raw << 16) - this -> state) >> this -> shift;
+  int32_t smoothed = (this -> state + 0x8000) >> 16;
+
+  int32_t diff = smoothed - this -> value;
+  if (diff < 0) {
+    diff = -diff;
+  }
+  bool at_end = (smoothed == 0 || smoothed == this -> max_value);
+  if (diff > this -> hysteresis || (at_end && diff != 0)) {
+    this -> value = smoothed;
+    return true;
+  }
+  return false;
+}
+
+uint16_t KnobFilter::getValue() {
+  return this -> value;
+}
+
+uint32_t knob_update_all(KnobFilter *filters, const uint16_t *raw, int n) {
+  uint32_t changed = 0;
+  for (int i = 0; i < n; i++) {
+    if (filters[i].update(raw[i])) {
+      changed |= 1UL << i;
+    }
+  }
+  return changed;
+}
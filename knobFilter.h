@@ -0,0 +1,41 @@
+/*
+  knobFilter.h
+  Smoothing and change detection for knob readings
+
+  Each knob gets a one-pole low-pass filter in fixed point and a hysteresis
+  band, so ADC noise does not turn into a stream of parameter updates: a new
+  value is only published when the smoothed reading moves by more than the
+  band, or reaches either end of the range. Plain C++ so it can be fed from
+  a mock ADC source on a host machine.
+*/
+
+#ifndef KNOBFILTER_H
+#define KNOBFILTER_H
+
+#include <stdint.h>
+
+#define KNOB_SMOOTHING_SHIFT 3   // Filter coefficient 1/2^shift per reading
+#define KNOB_HYSTERESIS 2        // Change (in input LSBs) needed to publish a new value
+
+class KnobFilter {
+  public:
+    KnobFilter();
+    void setup(uint16_t max_value, int smoothing_shift, int hysteresis);
+    bool update(uint16_t raw);
+    uint16_t getValue();
+    void reset();
+
+  private:
+    int32_t state;        // smoothed reading << 16
+    uint16_t value;       // last published value
+    uint16_t max_value;
+    uint8_t shift;
+    uint8_t hysteresis;
+    bool primed;
+};
+
+// Feed one reading per knob through its filter. Returns a bit mask of the
+// knobs whose published value changed.
+uint32_t knob_update_all(KnobFilter *filters, const uint16_t *raw, int n);
+
+#endif
@@ -0,0 +1,133 @@
+#include "logRing.h"
+#include <stdio.h>
+#include <atomic>
+
+// In LogMessage order. Each format may use up to two %ld for the arguments.
+static const char *log_formats[LOG_MESSAGES] = {
+  "entering setup(), waveform %ld",
+  "MIDI begin",
+  "waveform select idx: %ld",
+  "note on %ld velocity %ld",
+  "note off %ld",
+  "event queue full, note %ld dropped",
+  "SD card not found",
+  "streaming sample %ld",
+  "no stream file for sample %ld",
+  "stream underruns: %ld, fewest blocks buffered: %ld",
+  "wavetable bank open, %ld tables",
+  "no wavetable bank, using the built-in waveforms",
+  "wavetable %ld loaded in %ld us",
+  "wavetable bank not loaded: %ld read errors after %ld us",
+  "MIDI input errors: %ld stray bytes, %ld messages cut short",
+};
+
+static const char log_level_names[] = "-EWID";
+
+// Bounded multi-producer ring: a writer claims a position with a
+// compare-and-swap on head, fills the slot and then publishes it by setting
+// the slot sequence to position + 1. The reader frees a slot by setting its
+// sequence to position + LOG_RING_SIZE, which is what the writer one lap
+// later waits for. A writer interrupted between the claim and the publish
+// only holds up the reader, never another writer.
+struct LogSlot {
+  std::atomic<uint32_t> sequence;
+  LogRecord record;
+};
+
+static LogSlot log_slots[LOG_RING_SIZE];
+static std::atomic<uint32_t> log_head(0);
+static uint32_t log_tail = 0;
+static std::atomic<uint32_t> log_dropped(0);
+static uint32_t log_reported = 0;
+static uint32_t (*log_clock)() = 0;
+
+static struct LogSlotInit {
+  LogSlotInit() {
+    for (uint32_t i = 0; i < LOG_RING_SIZE; i++) {
+      log_slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+} log_slot_init;
+
+void log_set_clock(uint32_t (*now)()) {
+  log_clock = now;
+}
+
+bool log_write(uint8_t level, uint16_t id, int32_t a, int32_t b) {
+  uint32_t pos = log_head.load(std::memory_order_relaxed);
+  LogSlot *slot;
+  for (;;) {
+    slot = &log_slots[pos & (LOG_RING_SIZE - 1)];
+    int32_t diff = (int32_t)(slot -> sequence.load(std::memory_order_acquire) - pos);
+    if (diff == 0) {
+      if (log_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      // slot still holds a record from the previous lap
+      log_dropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    } else {
+      pos = log_head.load(std::memory_order_relaxed);
+    }
+  }
+  slot -> record.timestamp = log_clock ? log_clock() : 0;
+  slot -> record.id = id;
+  slot -> record.level = level;
+  slot -> record.a = a;
+  slot -> record.b = b;
+  slot -> sequence.store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+bool log_read(LogRecord *record) {
+  LogSlot *slot = &log_slots[log_tail & (LOG_RING_SIZE - 1)];
+  if (slot -> sequence.load(std::memory_order_acquire) != log_tail + 1) {
+    return false;
+  }
+  *record = slot -> record;
+  slot -> sequence.store(log_tail + LOG_RING_SIZE, std::memory_order_release);
+  log_tail++;
+  return true;
+}
+
+int log_format(const LogRecord *record, char *text, int size) {
+  int level = record -> level <= LOG_LEVEL_DEBUG ? record -> level : 0;
+  int n = snprintf(text, size, "[%lu] %c ", (unsigned long)record -> timestamp, log_level_names[level]);
+  if (n < 0 || n >= size) {
+    return size - 1;
+  }
+  if (record -> id < LOG_MESSAGES) {
+    n += snprintf(text + n, size - n, log_formats[record -> id], (long)record -> a, (long)record -> b);
+  } else {
+    n += snprintf(text + n, size - n, "unknown message %u (%ld, %ld)", record -> id, (long)record -> a, (long)record -> b);
+  }
+  if (n > size - 2) {
+    n = size - 2;
+  }
+  text[n++] = '\n';
+  text[n] = 0;
+  return n;
+}
+
+int log_drain(void (*write)(const char *text), int max) {
+  char text[LOG_LINE_LENGTH];
+  LogRecord record;
+  int count = 0;
+  while (count < max && log_read(&record)) {
+    log_format(&record, text, sizeof(text));
+    write(text);
+    count++;
+  }
+  uint32_t dropped = log_dropped.load(std::memory_order_relaxed);
+  if (dropped != log_reported) {
+    snprintf(text, sizeof(text), "log overflow, %lu records dropped\n", (unsigned long)(dropped - log_reported));
+    write(text);
+    log_reported = dropped;
+  }
+  return count;
+}
+
+uint32_t log_get_dropped() {
+  return log_dropped.load(std::memory_order_relaxed);
+}
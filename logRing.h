@@ -0,0 +1,105 @@
+/*
+  logRing.h
+  Deferred binary logging that is safe to call from interrupts
+
+  LOG_ERROR/LOG_WARN/LOG_INFO/LOG_DEBUG(msg, a, b) only copy a fixed-size
+  record (message id, timestamp and two integer arguments) into a lock-free
+  ring and return, they never wait for the serial port. loop() calls
+  log_drain() when it has nothing else to do, which turns the records into
+  text using the format table in logRing.cpp. When the ring is full new
+  records are dropped and counted, and the next drain reports how many were
+  lost. Messages below LOG_LEVEL compile to nothing, arguments included, so
+  a build with LOG_LEVEL_NONE pays nothing for them.
+*/
+
+#ifndef LOGRING_H
+#define LOGRING_H
+
+#include <stdint.h>
+
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+// Messages above this level are compiled out (or pass -DLOG_LEVEL=...)
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+#define LOG_RING_SIZE 64         // records, must be a power of two
+#define LOG_LINE_LENGTH 96       // longest formatted line including the newline
+
+// Message ids, the format strings are in logRing.cpp in the same order
+enum LogMessage {
+  LOG_MSG_SETUP,
+  LOG_MSG_MIDI_BEGIN,
+  LOG_MSG_WAVEFORM,
+  LOG_MSG_NOTE_ON,
+  LOG_MSG_NOTE_OFF,
+  LOG_MSG_QUEUE_FULL,
+  LOG_MSG_SD_FAILED,
+  LOG_MSG_STREAM_START,
+  LOG_MSG_STREAM_MISSING,
+  LOG_MSG_STREAM_UNDERRUN,
+  LOG_MSG_BANK_OPEN,
+  LOG_MSG_BANK_MISSING,
+  LOG_MSG_BANK_LOADED,
+  LOG_MSG_BANK_FAILED,
+  LOG_MSG_MIDI_ERRORS,
+  LOG_MESSAGES
+};
+
+struct LogRecord {
+  uint32_t timestamp;   // from the clock passed to log_set_clock()
+  uint16_t id;          // LogMessage
+  uint8_t level;
+  int32_t a;
+  int32_t b;
+};
+
+// Timestamp source for new records, e.g. micros() on the board
+void log_set_clock(uint32_t (*now)());
+
+// Queue a record, from any context. Returns false (and counts a drop) when
+// the ring is full.
+bool log_write(uint8_t level, uint16_t id, int32_t a, int32_t b);
+
+// Consumer side, one context only. Takes the oldest record if there is one.
+bool log_read(LogRecord *record);
+
+// Format a record as one line of text, returns its length
+int log_format(const LogRecord *record, char *text, int size);
+
+// Format and write up to max records (and any new drop count) through write.
+// Returns the number of records taken from the ring.
+int log_drain(void (*write)(const char *text), int max);
+
+uint32_t log_get_dropped();
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(msg, a, b) log_write(LOG_LEVEL_ERROR, msg, a, b)
+#else
+#define LOG_ERROR(msg, a, b)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(msg, a, b) log_write(LOG_LEVEL_WARN, msg, a, b)
+#else
+#define LOG_WARN(msg, a, b)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(msg, a, b) log_write(LOG_LEVEL_INFO, msg, a, b)
+#else
+#define LOG_INFO(msg, a, b)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(msg, a, b) log_write(LOG_LEVEL_DEBUG, msg, a, b)
+#else
+#define LOG_DEBUG(msg, a, b)
+#endif
+
+#endif
@@ -0,0 +1,257 @@
+#include "midiParser.h"
+#include <string.h>
+
+MidiParser::MidiParser() {
+  for (int t = 0; t < MIDI_CHANNEL_TYPES; t++) {
+    this -> handlers[t] = 0;
+  }
+  this -> realtime = 0;
+  this -> common = 0;
+  this -> sysex_handler = 0;
+  this -> status = 0;
+  this -> data[0] = 0;
+  this -> data[1] = 0;
+  this -> count = 0;
+  this -> needed = 0;
+  this -> time = 0;
+  this -> byte_time = 0;
+  this -> stamp_head = 0;
+  this -> stamp_tail = 0;
+  this -> stamped = 0;
+  this -> consumed = 0;
+  this -> reading = false;
+  this -> earliest = 0;
+  this -> in_sysex = false;
+  this -> sysex_overflow = false;
+  this -> sysex_length = 0;
+  memset(&(this -> stats), 0, sizeof(this -> stats));
+}
+
+void MidiParser::setHandler(MidiType type, MidiChannelHandler f) {
+  this -> handlers[type - MIDI_NOTE_OFF] = f;
+}
+
+void MidiParser::setRealtimeHandler(MidiRealtimeHandler f) {
+  this -> realtime = f;
+}
+
+void MidiParser::setCommonHandler(MidiCommonHandler f) {
+  this -> common = f;
+}
+
+void MidiParser::setSysExHandler(MidiSysExHandler f) {
+  this -> sysex_handler = f;
+}
+
+// Time it takes the port to receive one byte, e.g. 320 us at 31250 baud
+void MidiParser::setByteTime(uint32_t units) {
+  this -> byte_time = units;
+}
+
+uint32_t MidiParser::getTime() {
+  return this -> time;
+}
+
+void MidiParser::parse(uint8_t byte) {
+  this -> stats.bytes++;
+
+  // Real-time bytes may come anywhere, even inside another message, and
+  // leave it untouched. 0xF9 and 0xFD are undefined.
+  if (byte >= 0xF8) {
+    if (byte != 0xF9 && byte != 0xFD) {
+      this -> stats.messages++;
+      if (this -> realtime) {
+        this -> realtime(byte);
+      }
+    }
+    return;
+  }
+
+  if (byte < 0x80) {
+    if (this -> in_sysex) {
+      if (this -> sysex_length < MIDI_SYSEX_SIZE) {
+        this -> sysex[this -> sysex_length++] = byte;
+      } else if (!this -> sysex_overflow) {
+        this -> sysex_overflow = true;
+        this -> stats.sysex_overflows++;
+      }
+    } else if (this -> status == 0) {
+      this -> stats.stray_bytes++;
+    } else {
+      this -> data[this -> count++] = byte;
+      if (this -> count == this -> needed) {
+        dispatch();
+        this -> count = 0;
+        if (this -> status >= 0xF0) {
+          this -> status = 0;   // only channel messages have running status
+        }
+      }
+    }
+    return;
+  }
+
+  // Any other status byte ends a SysEx, normally with an EOX
+  if (this -> in_sysex) {
+    endSysEx(byte == 0xF7 && !this -> sysex_overflow);
+    if (byte == 0xF7) {
+      return;
+    }
+    this -> stats.truncated++;
+  } else if (this -> count != 0) {
+    this -> stats.truncated++;
+  }
+  this -> count = 0;
+
+  if (byte < 0xF0) {
+    this -> status = byte;
+    int type = byte >> 4;
+    this -> needed = (type == MIDI_PROGRAM_CHANGE || type == MIDI_CHANNEL_PRESSURE) ? 1 : 2;
+    return;
+  }
+
+  this -> status = 0;
+  switch (byte) {
+    case 0xF0:
+      this -> in_sysex = true;
+      this -> sysex_overflow = false;
+      this -> sysex_length = 0;
+      break;
+    case 0xF1:   // MTC quarter frame
+    case 0xF3:   // song select
+      this -> status = byte;
+      this -> needed = 1;
+      break;
+    case 0xF2:   // song position
+      this -> status = byte;
+      this -> needed = 2;
+      break;
+    case 0xF6:   // tune request
+      this -> status = byte;
+      this -> needed = 0;
+      dispatch();
+      this -> status = 0;
+      break;
+    default:     // EOX outside a SysEx, undefined 0xF4 and 0xF5
+      this -> stats.stray_bytes++;
+      break;
+  }
+}
+
+void MidiParser::parse(const uint8_t *bytes, int n) {
+  for (int i = 0; i < n; i++) {
+    parse(bytes[i]);
+  }
+}
+
+// Take what the port has buffered a chunk at a time rather than a byte per
+// call, and parse it straight away
+int MidiParser::poll(HalMidiIn *in, int max, uint32_t now) {
+  uint8_t buf[MIDI_POLL_CHUNK];
+  int total = 0;
+  uint32_t first = this -> consumed.load(std::memory_order_relaxed);
+  uint32_t received = first + in -> available();   // bytes that had arrived by now
+
+  while (total < max) {
+    int n = max - total;
+    if (n > MIDI_POLL_CHUNK) {
+      n = MIDI_POLL_CHUNK;
+    }
+    // a stamp between the read and the count would miss these bytes
+    this -> reading.store(true, std::memory_order_release);
+    n = in -> read(buf, n);
+    if (n > 0) {
+      this -> consumed.store(first + total + n, std::memory_order_release);
+    }
+    this -> reading.store(false, std::memory_order_release);
+    if (n <= 0) {
+      break;
+    }
+    for (int i = 0; i < n; i++) {
+      this -> time = arrival(first + total + i, received, now);
+      parse(buf[i]);
+    }
+    total += n;
+  }
+  if ((int32_t)(first + total - received) >= 0) {
+    this -> earliest = now;   // everything that had arrived by now is parsed
+  }
+  return total;
+}
+
+void MidiParser::stamp(HalMidiIn *in, uint32_t now) {
+  if (this -> reading.load(std::memory_order_acquire)) {
+    return;
+  }
+  uint32_t received = this -> consumed.load(std::memory_order_acquire) + in -> available();
+  if (received == this -> stamped) {
+    return;
+  }
+  uint32_t h = this -> stamp_head.load(std::memory_order_relaxed);
+  if (h - this -> stamp_tail.load(std::memory_order_acquire) >= MIDI_STAMPS) {
+    return;   // poll() dates these bytes with the next stamp it has
+  }
+  this -> stamps[h & (MIDI_STAMPS - 1)].received = received;
+  this -> stamps[h & (MIDI_STAMPS - 1)].time = now;
+  this -> stamp_head.store(h + 1, std::memory_order_release);
+  this -> stamped = received;
+}
+
+// Time byte number index arrived, from the first stamp that counts it (or
+// the poll, which had received bytes by now), and no earlier than the last
+// one that does not
+uint32_t MidiParser::arrival(uint32_t index, uint32_t received, uint32_t now) {
+  uint32_t t = this -> stamp_tail.load(std::memory_order_relaxed);
+  uint32_t h = this -> stamp_head.load(std::memory_order_acquire);
+  while (t != h && (int32_t)(this -> stamps[t & (MIDI_STAMPS - 1)].received - index) <= 0) {
+    this -> earliest = this -> stamps[t & (MIDI_STAMPS - 1)].time;
+    t++;
+  }
+  this -> stamp_tail.store(t, std::memory_order_release);
+
+  uint32_t time = now;
+  if (t != h) {
+    received = this -> stamps[t & (MIDI_STAMPS - 1)].received;
+    time = this -> stamps[t & (MIDI_STAMPS - 1)].time;
+  }
+  if ((int32_t)(received - index) > 0) {
+    time -= (received - 1 - index) * this -> byte_time;
+  }
+  if ((int32_t)(time - this -> earliest) < 0) {
+    time = this -> earliest;
+  }
+  return time;
+}
+
+void MidiParser::getStats(MidiParserStats *stats) {
+  *stats = this -> stats;
+}
+
+void MidiParser::dispatch() {
+  uint8_t d1 = this -> needed > 0 ? this -> data[0] : 0;
+  uint8_t d2 = this -> needed > 1 ? this -> data[1] : 0;
+  this -> stats.messages++;
+
+  if (this -> status >= 0xF0) {
+    if (this -> common) {
+      this -> common(this -> status, d1, d2);
+    }
+    return;
+  }
+
+  int type = this -> status >> 4;
+  if (type == MIDI_NOTE_ON && d2 == 0) {
+    type = MIDI_NOTE_OFF;   // note on with velocity 0 is a note off
+  }
+  MidiChannelHandler f = this -> handlers[type - MIDI_NOTE_OFF];
+  if (f) {
+    f((this -> status & 0x0F) + 1, d1, d2);
+  }
+}
+
+void MidiParser::endSysEx(bool complete) {
+  this -> in_sysex = false;
+  this -> stats.messages++;
+  if (this -> sysex_handler) {
+    this -> sysex_handler(this -> sysex, this -> sysex_length, complete);
+  }
+}
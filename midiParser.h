@@ -0,0 +1,139 @@
+/*
+  midiParser.h
+  MIDI byte stream parser with a static handler table
+
+  poll() takes everything the serial port has received in one go and parses
+  it, so a burst of controller or clock messages is worked through in a
+  single pass of loop() instead of one message per pass, and note messages
+  behind it are not held up. Channel messages (with running status) go to
+  the handler set for their type, system real-time bytes are passed on the
+  moment they arrive, even in the middle of another message, and SysEx is
+  collected into a fixed buffer. Nothing is allocated; bytes that do not fit
+  the protocol are dropped and counted. Plain C++ so it can be fed recorded
+  streams on a host.
+
+  poll() also timestamps each byte. The port's receive interrupt belongs to
+  the core, so arrival is bracketed instead: stamp(), called from the audio
+  interrupt, records how many bytes had arrived by then, and poll() does the
+  same. A byte is dated to the first stamp that counts it, less one byte
+  time for each byte counted after it (they could not have arrived any
+  sooner), but never before the last stamp that did not count it. A byte is
+  therefore never dated early, and late by at most the time between two
+  stamps: one audio block however long loop() stalls, unless more than
+  MIDI_STAMPS blocks with new bytes pass between polls or a stamp falls
+  while poll() is reading the port, in which case that stamp is skipped and
+  the next one is used. A handler gets the time its message completed from
+  getTime().
+*/
+
+#ifndef MIDIPARSER_H
+#define MIDIPARSER_H
+
+#include <stdint.h>
+#include <atomic>
+#include "hal.h"
+
+#define MIDI_SYSEX_SIZE 64     // longest SysEx kept, without the F0/F7 framing
+#define MIDI_POLL_CHUNK 32     // bytes taken from the port per read in poll()
+#define MIDI_STAMPS 16         // arrival stamps kept between polls, a power of two
+
+// Channel message types, the high nibble of the status byte
+enum MidiType {
+  MIDI_NOTE_OFF = 0x8,
+  MIDI_NOTE_ON = 0x9,
+  MIDI_POLY_PRESSURE = 0xA,
+  MIDI_CONTROL_CHANGE = 0xB,
+  MIDI_PROGRAM_CHANGE = 0xC,
+  MIDI_CHANNEL_PRESSURE = 0xD,
+  MIDI_PITCH_BEND = 0xE
+};
+
+#define MIDI_CHANNEL_TYPES 7
+
+// channel is 1 - 16 like the Arduino MIDI library; data2 is 0 for the
+// messages that have one data byte
+typedef void (*MidiChannelHandler)(uint8_t channel, uint8_t data1, uint8_t data2);
+// status is 0xF8 - 0xFF
+typedef void (*MidiRealtimeHandler)(uint8_t status);
+// status is 0xF1 - 0xF6, data2 is 0 unless it is a song position
+typedef void (*MidiCommonHandler)(uint8_t status, uint8_t data1, uint8_t data2);
+// data without F0/F7; complete is false when the message was cut short by
+// another status byte or did not fit MIDI_SYSEX_SIZE
+typedef void (*MidiSysExHandler)(const uint8_t *data, int n, bool complete);
+
+struct MidiParserStats {
+  unsigned long messages;        // messages dispatched, handler set or not
+  unsigned long bytes;
+  unsigned long stray_bytes;     // data bytes with no status to belong to
+  unsigned long truncated;       // messages cut short by a new status byte
+  unsigned long sysex_overflows;
+};
+
+class MidiParser {
+  public:
+    MidiParser();
+    void setHandler(MidiType type, MidiChannelHandler f);
+    void setRealtimeHandler(MidiRealtimeHandler f);
+    void setCommonHandler(MidiCommonHandler f);
+    void setSysExHandler(MidiSysExHandler f);
+    void setByteTime(uint32_t units);
+
+    // Parse bytes from any source
+    void parse(uint8_t byte);
+    void parse(const uint8_t *bytes, int n);
+
+    // Drain the port: parse up to max bytes of what it has received and
+    // return the number parsed. now is the time of the call, in the units of
+    // setByteTime().
+    int poll(HalMidiIn *in, int max, uint32_t now);
+
+    // Record how many bytes the port has received by now, on the clock of
+    // poll(). Called from an interrupt that preempts poll(), e.g. once per
+    // audio block.
+    void stamp(HalMidiIn *in, uint32_t now);
+
+    // Arrival time of the last byte parsed, for use in handlers
+    uint32_t getTime();
+
+    void getStats(MidiParserStats *stats);
+
+  private:
+    void dispatch();
+    void endSysEx(bool complete);
+    uint32_t arrival(uint32_t index, uint32_t received, uint32_t now);
+
+    struct Stamp {
+      uint32_t received;   // bytes the port had received
+      uint32_t time;
+    };
+
+    MidiChannelHandler handlers[MIDI_CHANNEL_TYPES];   // by type - MIDI_NOTE_OFF
+    MidiRealtimeHandler realtime;
+    MidiCommonHandler common;
+    MidiSysExHandler sysex_handler;
+
+    uint8_t status;     // running status, or the system common message in progress, 0 for none
+    uint8_t data[2];
+    uint8_t count;      // data bytes received for the current message
+    uint8_t needed;     // data bytes the current message takes
+
+    uint32_t time;
+    uint32_t byte_time;
+
+    Stamp stamps[MIDI_STAMPS];
+    std::atomic<uint32_t> stamp_head;   // written by stamp()
+    std::atomic<uint32_t> stamp_tail;   // written by poll()
+    uint32_t stamped;                   // received at the last stamp, stamp() only
+    std::atomic<uint32_t> consumed;     // bytes poll() has taken from the port
+    std::atomic<bool> reading;          // poll() is between a read and counting it
+    uint32_t earliest;                  // no byte not yet parsed arrived before this
+
+    bool in_sysex;
+    bool sysex_overflow;
+    int sysex_length;
+    uint8_t sysex[MIDI_SYSEX_SIZE];
+
+    MidiParserStats stats;
+};
+
+#endif
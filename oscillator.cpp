@@ -0,0 +1,30 @@
+#include "oscillator.h"
+
+uint32_t phase_increment(double freq, unsigned long sample_rate) {
+  if (freq <= 0) {
+    return 0;
+  }
+  // One full cycle is 2^32 phase units
+  return (uint32_t)(freq * 4294967296.0 / sample_rate + 0.5);
+}
+
+PhaseOscillator::PhaseOscillator() {
+  this -> phase = 0;
+  this -> increment = 0;
+}
+
+void PhaseOscillator::setFrequency(double freq) {
+  this -> increment = phase_increment(freq, AUDIO_SAMPLE_RATE);
+}
+
+void PhaseOscillator::setIncrement(uint32_t inc) {
+  this -> increment = inc;
+}
+
+uint32_t PhaseOscillator::getIncrement() {
+  return this -> increment;
+}
+
+void PhaseOscillator::reset() {
+  this -> phase = 0;
+}
@@ -0,0 +1,43 @@
+/*
+  oscillator.h
+  Fixed sample rate phase-accumulator (DDS) oscillator
+
+  The audio timer runs at AUDIO_SAMPLE_RATE for every note. Pitch is set by
+  a 32-bit fixed-point phase increment that is added once per sample, and the
+  top bits of the phase index the wavetable. Only depends on the C++ standard
+  library so it can also be built and measured on a host machine.
+*/
+
+#ifndef OSCILLATOR_H
+#define OSCILLATOR_H
+
+#include <stdint.h>
+
+#define AUDIO_SAMPLE_RATE 50000UL                              // DAC sample rate in Hz
+#define AUDIO_TIMER_PERIOD (100000000UL / AUDIO_SAMPLE_RATE)   // Sample period in 10s of ns (TC_Timer units)
+
+// Phase increment that plays freq (Hz) at the given sample rate
+uint32_t phase_increment(double freq, unsigned long sample_rate);
+
+class PhaseOscillator {
+  public:
+    PhaseOscillator();
+    void setFrequency(double freq);
+    void setIncrement(uint32_t inc);
+    uint32_t getIncrement();
+    void reset();
+
+    // Return the wavetable index for the current sample and advance the phase.
+    // table_bits is log2 of the wavetable length.
+    inline uint32_t nextIndex(int table_bits) {
+      uint32_t idx = phase >> (32 - table_bits);
+      phase += increment;
+      return idx;
+    }
+
+  private:
+    uint32_t phase;
+    volatile uint32_t increment;   // written on note-on, read by the audio ISR
+};
+
+#endif
@@ -0,0 +1,142 @@
+#include "profiler.h"
+
+#ifdef PROFILE_ENABLED
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#else
+#include <chrono>
+#endif
+
+static ProfileStats profile_stats[PROF_SLOTS];
+static volatile uint8_t profile_stack[PROFILE_MAX_DEPTH];   // slots currently running
+static volatile uint8_t profile_depth;
+static uint8_t profile_max_depth;
+
+// Start the cycle counter (DWT is off until the debug unit is enabled)
+void profiler_init() {
+#ifdef ARDUINO
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+  profiler_reset();
+}
+
+void profiler_reset() {
+  for (int s = 0; s < PROF_SLOTS; s++) {
+    ProfileStats &st = profile_stats[s];
+    st.count = 0;
+    st.min = 0xFFFFFFFFUL;
+    st.max = 0;
+    st.total = 0;
+    st.preempted = 0;
+    st.nested = 0;
+    for (int b = 0; b < PROFILE_BUCKETS; b++) {
+      st.histogram[b] = 0;
+    }
+  }
+  profile_max_depth = 0;
+}
+
+uint32_t profiler_now() {
+#ifdef ARDUINO
+  return DWT->CYCCNT;
+#else
+  static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+  return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now() - epoch).count();
+#endif
+}
+
+// Ticks per second of profiler_now()
+uint32_t profiler_tick_rate() {
+#ifdef ARDUINO
+  return F_CPU;
+#else
+  return 1000000000UL;
+#endif
+}
+
+// Scopes nest strictly (an interrupt always finishes before the code it
+// preempted carries on), so a plain stack tracks which scope was interrupted
+uint32_t profiler_begin(int slot) {
+  uint8_t d = profile_depth;
+  if (d > 0 && d <= PROFILE_MAX_DEPTH) {
+    profile_stats[profile_stack[d - 1]].preempted++;
+    profile_stats[slot].nested++;
+  }
+  if (d < PROFILE_MAX_DEPTH) {
+    profile_stack[d] = slot;
+  }
+  profile_depth = d + 1;
+  if (d + 1 > profile_max_depth) {
+    profile_max_depth = d + 1;
+  }
+  return profiler_now();
+}
+
+void profiler_end(int slot, uint32_t start) {
+  uint32_t ticks = profiler_now() - start;
+  ProfileStats &st = profile_stats[slot];
+
+  st.count++;
+  st.total += ticks;
+  if (ticks < st.min) {
+    st.min = ticks;
+  }
+  if (ticks > st.max) {
+    st.max = ticks;
+  }
+  int b = ticks == 0 ? 0 : 31 - __builtin_clz(ticks);
+  if (b >= PROFILE_BUCKETS) {
+    b = PROFILE_BUCKETS - 1;
+  }
+  st.histogram[b]++;
+
+  profile_depth = profile_depth - 1;
+}
+
+void profiler_get(int slot, ProfileStats *stats) {
+  *stats = profile_stats[slot];
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+  p[0] = v;
+  p[1] = v >> 8;
+  p[2] = v >> 16;
+  p[3] = v >> 24;
+}
+
+// Binary dump, all values little-endian:
+//   u32 magic "PRF1", u32 tick rate, u8 slots, u8 buckets, u8 max depth, u8 0
+//   then per slot: u32 count, min, max, total (low), total (high), preempted,
+//   nested, and PROFILE_BUCKETS u32 histogram counts
+void profiler_dump(void (*write)(const uint8_t *data, int n)) {
+  uint8_t buf[4 * (7 + PROFILE_BUCKETS)];
+
+  put_u32(buf, PROFILE_DUMP_MAGIC);
+  put_u32(buf + 4, profiler_tick_rate());
+  buf[8] = PROF_SLOTS;
+  buf[9] = PROFILE_BUCKETS;
+  buf[10] = profile_max_depth;
+  buf[11] = 0;
+  write(buf, 12);
+
+  for (int s = 0; s < PROF_SLOTS; s++) {
+    ProfileStats st = profile_stats[s];
+    put_u32(buf, st.count);
+    put_u32(buf + 4, st.count ? st.min : 0);
+    put_u32(buf + 8, st.max);
+    put_u32(buf + 12, (uint32_t)st.total);
+    put_u32(buf + 16, (uint32_t)(st.total >> 32));
+    put_u32(buf + 20, st.preempted);
+    put_u32(buf + 24, st.nested);
+    for (int b = 0; b < PROFILE_BUCKETS; b++) {
+      put_u32(buf + 28 + 4 * b, st.histogram[b]);
+    }
+    write(buf, sizeof(buf));
+  }
+}
+
+#endif
@@ -0,0 +1,93 @@
+/*
+  profiler.h
+  Interrupt cycle-budget profiler
+
+  Wrap a handler body in PROFILE_SCOPE(slot) to record how long it takes:
+  call count, min/max/total, a log2 histogram, and how often it preempted or
+  was preempted by another profiled scope. On the board time is read from
+  the Cortex-M4 DWT cycle counter; on a host it comes from a steady clock in
+  nanoseconds. PROFILE_DUMP(write) sends everything as one binary record.
+  Unless PROFILE_ENABLED is defined all of the PROFILE_ macros compile to
+  nothing and the profiler takes no time or RAM.
+*/
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+// Uncomment to build the profiler in (or pass -DPROFILE_ENABLED)
+// #define PROFILE_ENABLED
+
+#include <stdint.h>
+
+enum ProfileSlot {
+  PROF_TC0,
+  PROF_TC1,
+  PROF_TC2,
+  PROF_TC3,
+  PROF_TC4,
+  PROF_TC5,
+  PROF_DMAC0,
+  PROF_DMAC1,
+  PROF_DMAC2,
+  PROF_DMAC3,
+  PROF_DMAC4,          // channels 4 and up share one handler
+  PROF_MIDI_NOTE_ON,
+  PROF_MIDI_NOTE_OFF,
+  PROF_SLOTS
+};
+
+#define PROFILE_BUCKETS 24      // bucket b counts durations of 2^b to 2^(b+1) - 1 ticks
+#define PROFILE_MAX_DEPTH 8     // deepest nesting of profiled scopes that is tracked
+#define PROFILE_DUMP_MAGIC 0x31465250UL   // "PRF1" as little-endian bytes
+
+struct ProfileStats {
+  uint32_t count;
+  uint32_t min;
+  uint32_t max;
+  uint64_t total;
+  uint32_t preempted;   // times another scope started while this one was running
+  uint32_t nested;      // times this scope started while another was running
+  uint32_t histogram[PROFILE_BUCKETS];
+};
+
+#ifdef PROFILE_ENABLED
+
+void profiler_init();
+void profiler_reset();
+uint32_t profiler_now();
+uint32_t profiler_tick_rate();
+uint32_t profiler_begin(int slot);
+void profiler_end(int slot, uint32_t start);
+void profiler_get(int slot, ProfileStats *stats);
+void profiler_dump(void (*write)(const uint8_t *data, int n));
+
+class ProfileScope {
+  public:
+    ProfileScope(int slot) {
+      this -> slot = slot;
+      this -> start = profiler_begin(slot);
+    }
+    ~ProfileScope() {
+      profiler_end(this -> slot, this -> start);
+    }
+
+  private:
+    int slot;
+    uint32_t start;
+};
+
+#define PROFILE_CONCAT2(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT2(a, b)
+#define PROFILE_SCOPE(slot) ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(slot)
+#define PROFILE_INIT() profiler_init()
+#define PROFILE_DUMP(write) profiler_dump(write)
+
+#else
+
+#define PROFILE_SCOPE(slot)
+#define PROFILE_INIT()
+#define PROFILE_DUMP(write)
+
+#endif
+
+#endif
@@ -1,16 +1,44 @@
 #include "pwmHandler.h"
 
+// Where each PWM pin is wired. All of these use peripheral function F (5).
+struct PwmPin {
+  int pin;
+  Tcc *tcc;
+  uint8_t channel;       // compare channel driving the pin
+  uint8_t gclk_id;       // peripheral clock channel of the TCC
+  uint8_t dma_trigger;   // DMA trigger of the TCC overflow
+  uint8_t pmux;          // peripheral function of the pin
+};
+
+static const PwmPin pwm_pins[] = {
+  {5, TCC0, 5, TCC0_GCLK_ID, TCC0_DMAC_ID_OVF, 5},
+  {6, TCC1, 0, TCC1_GCLK_ID, TCC1_DMAC_ID_OVF, 5},
+  {7, TCC1, 1, TCC1_GCLK_ID, TCC1_DMAC_ID_OVF, 5},
+};
+
+#define PWM_PINS (sizeof(pwm_pins) / sizeof(pwm_pins[0]))
+
+static int pwm_row(int pin) {
+  for (unsigned int r = 0; r < PWM_PINS; r++) {
+    if (pwm_pins[r].pin == pin) {
+      return r;
+    }
+  }
+  return -1;
+}
+
 pwmHandler::pwmHandler() {
   this -> pin = 5;
+  this -> row = 0;
   this -> init();
 }
 
 pwmHandler::pwmHandler(int pin) {
-  if (pin >=5 && pin <=7) {
-    this -> pin = pin;
-  } else {
-    this -> pin = 5;
+  this -> row = pwm_row(pin);
+  if (this -> row < 0) {
+    this -> row = 0;
   }
+  this -> pin = pwm_pins[this -> row].pin;
 
   this -> init();
 }
@@ -20,121 +48,75 @@ int pwmHandler::getPinNumber() {
 }
 
 void pwmHandler::setPinNumber(int pin) {
-  this -> pin = pin;
+  int r = pwm_row(pin);
+  if (r >= 0) {
+    this -> pin = pin;
+    this -> row = r;
+  }
 }
 
+// 8-bit duty cycle, scaled up to the counter period
 void pwmHandler::fast_pwm_analogWrite(uint8_t val) {
-  switch (this -> pin) {
-    case 5:
-      TCC0->CC[5].reg = val;
-      break;
-
-    case 6:
-      TCC1->CC[0].reg = val;
-      break;
-
-    case 7:
-      TCC1->CC[1].reg = val;
-      break;
-  }
+  writeDuty((uint16_t)val << 2);
+}
+
+// Duty cycle from 0 to PWM_TOP
+void pwmHandler::writeDuty(uint16_t duty) {
+  const PwmPin *p = &pwm_pins[this -> row];
+  p -> tcc -> CC[p -> channel].reg = duty;
+}
+
+// Send buf0, buf1, buf0... to the compare buffer, one value per PWM period.
+// f is called from the DMA interrupt with each buffer once it has been sent.
+void pwmHandler::startStream(dmaHandler *dma, uint16_t *buf0, uint16_t *buf1, int n,
+                             void (*f)(uint16_t *block, int n)) {
+  const PwmPin *p = &pwm_pins[this -> row];
+  dma -> startPingPong(p -> dma_trigger, &(p -> tcc -> CCBUF[p -> channel].reg), buf0, buf1, n, f);
 }
 
 void pwmHandler::init() {
-  if (this -> pin == 7) {
-    // Set up the generic clock (GCLK7) to clock timer TCC0 
-    GCLK->GENCTRL[7].reg = GCLK_GENCTRL_DIV(1) |       // Divide the 48MHz clock source by divisor 1: 48MHz/1 = 48MHz
-                          GCLK_GENCTRL_IDC |          // Set the duty cycle to 50/50 HIGH/LOW
-                          GCLK_GENCTRL_GENEN |        // Enable GCLK7
-                          GCLK_GENCTRL_SRC_DFLL;      // Select 48MHz DFLL clock source
-
-    while (GCLK->SYNCBUSY.bit.GENCTRL7);               // Wait for synchronization  
-
-    GCLK->PCHCTRL[25].reg = GCLK_PCHCTRL_CHEN |        // Enable the TCC1 peripheral channel
-                            GCLK_PCHCTRL_GEN_GCLK7;    // Connect generic clock 7 to TCC1
-
-    // Enable the peripheral multiplexer on pin D7
-    PORT->Group[g_APinDescription[7].ulPort].PINCFG[g_APinDescription[7].ulPin].bit.PMUXEN = 1;
-    
-    // Set the D7 (PORT_PB12) peripheral multiplexer to peripheral (even port number) E(6): TCC0, Channel 0
-    PORT->Group[g_APinDescription[7].ulPort].PMUX[g_APinDescription[7].ulPin >> 1].reg |= PORT_PMUX_PMUXO(5);
-    
-    TCC1->CTRLA.reg = TC_CTRLA_PRESCALER_DIV4 |        // Set prescaler to 4, 48MHz/4 = 12MHz
-                      TC_CTRLA_PRESCSYNC_PRESC;        // Set the reset/reload to trigger on prescaler clock                 
-
-    TCC1->WAVE.reg = TC_WAVE_WAVEGEN_NPWM;             // Set-up TCC1 timer for Normal (single slope) PWM mode (NPWM)
-    while (TCC1->SYNCBUSY.bit.WAVE)                    // Wait for synchronization
-                         
-    TCC1->PER.reg = 255;                               // Set-up the PER (period) register 47kHz PWM
-    while (TCC1->SYNCBUSY.bit.PER);                    // Wait for synchronization
-    
-    TCC1->CC[1].reg = 127;                             // Set-up the CC (counter compare), channel 0 register for 50% duty-cycle
-    while (TCC1->SYNCBUSY.bit.CC1);                    // Wait for synchronization
-
-    TCC1->CTRLA.bit.ENABLE = 1;                        // Enable timer TCC0
-    while (TCC1->SYNCBUSY.bit.ENABLE);                 // Wait for synchronization
-
-  } else if (pin == 6) {
-    // Set up the generic clock (GCLK7) to clock timer TCC0 
-    GCLK->GENCTRL[7].reg = GCLK_GENCTRL_DIV(1) |       // Divide the 48MHz clock source by divisor 1: 48MHz/1 = 48MHz
-                          GCLK_GENCTRL_IDC |          // Set the duty cycle to 50/50 HIGH/LOW
-                          GCLK_GENCTRL_GENEN |        // Enable GCLK7
-                          GCLK_GENCTRL_SRC_DFLL;      // Select 48MHz DFLL clock source
-
-    while (GCLK->SYNCBUSY.bit.GENCTRL7);               // Wait for synchronization  
-
-    GCLK->PCHCTRL[25].reg = GCLK_PCHCTRL_CHEN |        // Enable the TCC0 peripheral channel
-                            GCLK_PCHCTRL_GEN_GCLK7;    // Connect generic clock 7 to TCC0
-
-    // Enable the peripheral multiplexer on pin D6
-    PORT->Group[g_APinDescription[6].ulPort].PINCFG[g_APinDescription[6].ulPin].bit.PMUXEN = 1;
-    
-    PORT->Group[g_APinDescription[6].ulPort].PMUX[g_APinDescription[6].ulPin >> 1].reg |= PORT_PMUX_PMUXE(5);
-    
-    TCC1->CTRLA.reg = TC_CTRLA_PRESCALER_DIV4 |        // Set prescaler to 4, 48MHz/4 = 12MHz
-                      TC_CTRLA_PRESCSYNC_PRESC;        // Set the reset/reload to trigger on prescaler clock                 
-
-    TCC1->WAVE.reg = TC_WAVE_WAVEGEN_NPWM;             // Set-up TCC1 timer for Normal (single slope) PWM mode (NPWM)
-    while (TCC1->SYNCBUSY.bit.WAVE)                    // Wait for synchronization
-
-    TCC1->PER.reg = 255;                               // Set-up the PER (period) register 47kHz PWM
-    while (TCC1->SYNCBUSY.bit.PER);                    // Wait for synchronization
-    
-    TCC1->CC[0].reg = 127;                             // Set-up the CC (counter compare), channel 0 register for 50% duty-cycle
-    while (TCC1->SYNCBUSY.bit.CC0);                    // Wait for synchronization
-
-    TCC1->CTRLA.bit.ENABLE = 1;                        // Enable timer TCC1
-    while (TCC1->SYNCBUSY.bit.ENABLE);                 // Wait for synchronization
-
-  } else if (pin == 5) {
-    // Set up the generic clock (GCLK7) to clock timer TCC0 
-    GCLK->GENCTRL[7].reg = GCLK_GENCTRL_DIV(1) |       // Divide the 48MHz clock source by divisor 1: 48MHz/1 = 48MHz
-                          GCLK_GENCTRL_IDC |          // Set the duty cycle to 50/50 HIGH/LOW
-                          GCLK_GENCTRL_GENEN |        // Enable GCLK7
-                          GCLK_GENCTRL_SRC_DFLL;      // Select 48MHz DFLL clock source
-
-    while (GCLK->SYNCBUSY.bit.GENCTRL7);               // Wait for synchronization  
-
-    GCLK->PCHCTRL[25].reg = GCLK_PCHCTRL_CHEN |        // Enable the TCC0 peripheral channel
-                            GCLK_PCHCTRL_GEN_GCLK7;    // Connect generic clock 7 to TCC0
-
-    // Enable the peripheral multiplexer on pin D5
-    PORT->Group[g_APinDescription[5].ulPort].PINCFG[g_APinDescription[5].ulPin].bit.PMUXEN = 1;
-    
-    PORT->Group[g_APinDescription[5].ulPort].PMUX[g_APinDescription[5].ulPin >> 1].reg |= PORT_PMUX_PMUXO(5);
-    
-    TCC0->CTRLA.reg = TC_CTRLA_PRESCALER_DIV4 |        // Set prescaler to 4, 48MHz/4 = 12MHz
-                      TC_CTRLA_PRESCSYNC_PRESC;        // Set the reset/reload to trigger on prescaler clock                 
-
-    TCC0->WAVE.reg = TC_WAVE_WAVEGEN_NPWM;             // Set-up TCC0 timer for Normal (single slope) PWM mode (NPWM)
-    while (TCC0->SYNCBUSY.bit.WAVE)                    // Wait for synchronization
-                           
-    TCC0->PER.reg = 255;                               // Set-up the PER (period) register 47kHz PWM
-    while (TCC0->SYNCBUSY.bit.PER);                    // Wait for synchronization
-                        
-    TCC0->CC[5].reg = 127;                             // Set-up the CC (counter compare), channel 5 register for 50% duty-cycle
-    while (TCC0->SYNCBUSY.bit.CC5);                    // Wait for synchronization
-
-    TCC0->CTRLA.bit.ENABLE = 1;                        // Enable timer TCC0
-    while (TCC0->SYNCBUSY.bit.ENABLE);                 // Wait for synchronization
+  const PwmPin *p = &pwm_pins[this -> row];
+  Tcc *tcc = p -> tcc;
+  uint32_t group = g_APinDescription[this -> pin].ulPort;
+  uint32_t port_pin = g_APinDescription[this -> pin].ulPin;
+
+  // Set up the generic clock (GCLK7) to clock the TCC
+  GCLK->GENCTRL[7].reg = GCLK_GENCTRL_DIV(1) |       // Divide the 48MHz clock source by divisor 1: 48MHz/1 = 48MHz
+                         GCLK_GENCTRL_IDC |          // Set the duty cycle to 50/50 HIGH/LOW
+                         GCLK_GENCTRL_GENEN |        // Enable GCLK7
+                         GCLK_GENCTRL_SRC_DFLL;      // Select 48MHz DFLL clock source
+
+  while (GCLK->SYNCBUSY.bit.GENCTRL7);               // Wait for synchronization
+
+  GCLK->PCHCTRL[p -> gclk_id].reg = GCLK_PCHCTRL_CHEN |      // Enable the TCC peripheral channel
+                                    GCLK_PCHCTRL_GEN_GCLK7;  // Connect generic clock 7 to the TCC
+
+  // Enable the peripheral multiplexer on the pin; odd and even port pins
+  // share a PMUX register
+  PORT->Group[group].PINCFG[port_pin].bit.PMUXEN = 1;
+  if (port_pin & 1) {
+    PORT->Group[group].PMUX[port_pin >> 1].reg |= PORT_PMUX_PMUXO(p -> pmux);
+  } else {
+    PORT->Group[group].PMUX[port_pin >> 1].reg |= PORT_PMUX_PMUXE(p -> pmux);
+  }
+
+  // Pins can share a TCC, which is only set up by the first of them
+  if (!tcc->CTRLA.bit.ENABLE) {
+    tcc->CTRLA.reg = TCC_CTRLA_PRESCALER_DIV1 |      // No prescaler, 48MHz
+                     TCC_CTRLA_PRESCSYNC_PRESC;      // Set the reset/reload to trigger on prescaler clock
+
+    tcc->WAVE.reg = TCC_WAVE_WAVEGEN_NPWM;           // Normal (single slope) PWM mode (NPWM)
+    while (tcc->SYNCBUSY.bit.WAVE);                  // Wait for synchronization
+
+    tcc->PER.reg = PWM_TOP;                          // 48MHz / 1024 = 47kHz PWM with 10-bit duty
+    while (tcc->SYNCBUSY.bit.PER);                   // Wait for synchronization
   }
-}
\ No newline at end of file
+
+  tcc->CC[p -> channel].reg = PWM_TOP / 2;           // 50% duty-cycle
+  while (tcc->SYNCBUSY.reg & (TCC_SYNCBUSY_CC0 << p -> channel));   // Wait for synchronization
+
+  if (!tcc->CTRLA.bit.ENABLE) {
+    tcc->CTRLA.bit.ENABLE = 1;                       // Enable the TCC
+    while (tcc->SYNCBUSY.bit.ENABLE);                // Wait for synchronization
+  }
+}
@@ -1,14 +1,24 @@
-// This class increases the PWM frequency on three digital pins
-// to roughly 47kHz. It works with pins D5, D6, and D7 on the
-// Adafruit Metro M4 Grand Central (SAMD51).
+// This class increases the PWM frequency on TCC-capable digital pins
+// to roughly 47kHz on the Adafruit Metro M4 Grand Central (SAMD51).
+// The TCC and compare channel behind each pin come from the pwm_pins table
+// in pwmHandler.cpp; add a row there to use another pin.
+//
+// Besides single writes, a channel can be streamed from ping-pong buffers by
+// DMA, one duty value per PWM period, triggered by the TCC overflow. The
+// values go to the CCBUF register so each one takes effect cleanly at the
+// start of the next period.
 
 // Note: true measured pwm frequency is ~46.8kHz
 
 #include <Arduino.h>
+#include "dmaHandler.h"
 
 #ifndef PWMHANDLER_H
 #define PWMHANDLER_H
 
+#define PWM_TOP 1023                                // Counter period, duty values run 0 - PWM_TOP
+#define PWM_FREQUENCY (48000000UL / (PWM_TOP + 1))  // PWM periods (and stream values) per second
+
 class pwmHandler {
   public:
     pwmHandler();
@@ -16,10 +26,14 @@ class pwmHandler {
     int getPinNumber();
     void setPinNumber(int pin);
     void fast_pwm_analogWrite(uint8_t val);
+    void writeDuty(uint16_t duty);
+    void startStream(dmaHandler *dma, uint16_t *buf0, uint16_t *buf1, int n,
+                     void (*f)(uint16_t *block, int n));
 
   private:
     int pin;
+    int row;          // entry of pwm_pins
     void init();
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,201 @@
+#include "streamPlayer.h"
+#include "voicePool.h"
+#include "wavetable.h"
+
+StreamPlayer::StreamPlayer() : head(0), tail(0), playing(false) {
+  this -> file = 0;
+  this -> looping = false;
+  this -> ended = true;
+  this -> fill_bytes = 0;
+  this -> read_pos = 0;
+  this -> drained = true;
+  this -> low_water = STREAM_BLOCKS;
+  this -> underruns = 0;
+  this -> underrun_samples = 0;
+  this -> blocks_read = 0;
+  this -> read_errors = 0;
+}
+
+// Open name, fill the ring and start playing it from the next audio block.
+// With loop the file starts over when it ends.
+bool StreamPlayer::start(HalFile *file, const char *name, bool loop) {
+  stop();
+  if (!file -> open(name)) {
+    return false;
+  }
+  if (file -> size() < 2) {
+    file -> close();
+    return false;
+  }
+
+  // The audio interrupt leaves the ring alone until playing is set
+  this -> file = file;
+  this -> looping = loop;
+  this -> ended = false;
+  this -> fill_bytes = 0;
+  this -> read_pos = 0;
+  this -> drained = false;
+  this -> low_water = STREAM_BLOCKS;
+  this -> underruns = 0;
+  this -> underrun_samples = 0;
+  this -> blocks_read = 0;
+  this -> read_errors = 0;
+  this -> head.store(0, std::memory_order_relaxed);
+  this -> tail.store(0, std::memory_order_relaxed);
+
+  fill(STREAM_BLOCKS);
+  this -> playing.store(true, std::memory_order_release);
+  return true;
+}
+
+void StreamPlayer::stop() {
+  this -> playing.store(false, std::memory_order_release);
+  if (this -> file != 0) {
+    this -> file -> close();
+    this -> file = 0;
+  }
+  this -> ended = true;
+}
+
+// Read ahead until the ring is full, the file has no more data ready, or
+// max_blocks blocks have been completed. Returns the blocks completed.
+int StreamPlayer::fill(int max_blocks) {
+  int done = 0;
+
+  if (this -> file == 0) {
+    return 0;
+  }
+  if (this -> drained) {
+    // the audio interrupt has played everything up to the end of the file
+    stop();
+    return 0;
+  }
+
+  while (done < max_blocks && !this -> ended) {
+    uint32_t h = this -> head.load(std::memory_order_relaxed);
+    if (h - this -> tail.load(std::memory_order_acquire) >= STREAM_BLOCKS) {
+      break;
+    }
+
+    int idx = h & (STREAM_BLOCKS - 1);
+    uint8_t *dst = (uint8_t *)this -> blocks[idx] + this -> fill_bytes;
+    int got = this -> file -> read(dst, STREAM_BLOCK_BYTES - this -> fill_bytes);
+    bool at_end = false;
+    if (got < 0) {
+      this -> read_errors++;
+      at_end = true;
+    } else if (got > 0) {
+      this -> fill_bytes += got;
+    } else if (this -> file -> available() > 0) {
+      break;   // storage busy, try again on the next call
+    } else if (this -> looping && this -> file -> seek(0)) {
+      continue;
+    } else {
+      at_end = true;
+    }
+
+    // Publish a full block, or the partial last one
+    if (this -> fill_bytes == STREAM_BLOCK_BYTES || (at_end && this -> fill_bytes >= 2)) {
+      this -> counts[idx] = this -> fill_bytes / 2;
+      this -> fill_bytes = 0;
+      this -> head.store(h + 1, std::memory_order_release);
+      this -> blocks_read++;
+      done++;
+    }
+
+    // Only after the last block is out, so the audio side never takes an
+    // empty ring for the end of the file too early
+    if (at_end) {
+      this -> ended = true;
+    }
+  }
+  return done;
+}
+
+// Add the next n samples of the file to a block of DAC codes, at the level of
+// one full-scale voice
+void StreamPlayer::mix(uint16_t *out, int n) {
+  if (!this -> playing.load(std::memory_order_acquire) || this -> drained) {
+    return;
+  }
+
+  uint32_t t = this -> tail.load(std::memory_order_relaxed);
+  uint32_t h = this -> head.load(std::memory_order_acquire);
+  if (!this -> ended && (int)(h - t) < this -> low_water) {
+    this -> low_water = h - t;
+  }
+
+  int i = 0;
+  while (i < n) {
+    if (t == h) {
+      // ended is set after the last block is published, so check it first
+      bool end = this -> ended;
+      h = this -> head.load(std::memory_order_acquire);
+      if (t != h) {
+        continue;
+      }
+      if (end) {
+        // the whole file has been played
+        this -> drained = true;
+      } else {
+        this -> underruns++;
+        this -> underrun_samples += n - i;
+      }
+      break;
+    }
+
+    int idx = t & (STREAM_BLOCKS - 1);
+    const int16_t *src = this -> blocks[idx] + this -> read_pos;
+    int count = this -> counts[idx] - this -> read_pos;
+    if (count > n - i) {
+      count = n - i;
+    }
+
+    for (int k = 0; k < count; k++) {
+      int32_t s = out[i + k] + ((src[k] >> 5) >> VOICE_MIX_SHIFT);
+      if (s < 0) {
+        s = 0;
+      } else if (s > DAC_MAX_CODE) {
+        s = DAC_MAX_CODE;
+      }
+      out[i + k] = (uint16_t)s;
+    }
+    i += count;
+    this -> read_pos += count;
+
+    if (this -> read_pos == this -> counts[idx]) {
+      this -> read_pos = 0;
+      t++;
+      this -> tail.store(t, std::memory_order_release);
+    }
+  }
+}
+
+bool StreamPlayer::isPlaying() {
+  return this -> playing.load(std::memory_order_acquire) && !this -> drained;
+}
+
+// Blocks read ahead of the audio
+int StreamPlayer::getBuffered() {
+  return this -> head.load(std::memory_order_acquire) - this -> tail.load(std::memory_order_acquire);
+}
+
+int StreamPlayer::getLowWater() {
+  return this -> low_water;
+}
+
+unsigned long StreamPlayer::getUnderruns() {
+  return this -> underruns;
+}
+
+unsigned long StreamPlayer::getUnderrunSamples() {
+  return this -> underrun_samples;
+}
+
+unsigned long StreamPlayer::getBlocksRead() {
+  return this -> blocks_read;
+}
+
+unsigned long StreamPlayer::getReadErrors() {
+  return this -> read_errors;
+}
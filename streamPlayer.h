@@ -0,0 +1,72 @@
+/*
+  streamPlayer.h
+  Plays a long sample from a file with read-ahead buffering
+
+  The file is raw signed 16-bit little-endian mono at AUDIO_SAMPLE_RATE,
+  so sampled sounds and long multi-cycle waves don't have to fit in RAM.
+  loop() calls fill() to read the file a block at a time into a small ring,
+  and the audio interrupt mixes from the ring into each DAC block. RAM use is
+  the ring only, whatever the length of the file. If the ring runs dry the
+  rest of that DAC block gets no stream audio, playback picks up where it
+  stopped, and the gap is counted as an underrun. One producer
+  (loop) and one consumer (the audio interrupt), like eventQueue.h. Plain
+  C++ so it can be run against a host file on a workstation.
+*/
+
+#ifndef STREAMPLAYER_H
+#define STREAMPLAYER_H
+
+#include <stdint.h>
+#include <atomic>
+#include "hal.h"
+
+#define STREAM_BLOCK_SAMPLES 256   // samples per ring block (one 512-byte SD sector)
+#define STREAM_BLOCKS 8            // blocks in the ring, a power of two (41 ms at 50 kHz)
+#define STREAM_BLOCK_BYTES (STREAM_BLOCK_SAMPLES * 2)
+
+class StreamPlayer {
+  public:
+    StreamPlayer();
+
+    // loop() side
+    bool start(HalFile *file, const char *name, bool loop);
+    void stop();
+    int fill(int max_blocks);
+
+    // audio interrupt side
+    void mix(uint16_t *out, int n);
+
+    bool isPlaying();
+    int getBuffered();
+    int getLowWater();
+    unsigned long getUnderruns();
+    unsigned long getUnderrunSamples();
+    unsigned long getBlocksRead();
+    unsigned long getReadErrors();
+
+  private:
+    int16_t blocks[STREAM_BLOCKS][STREAM_BLOCK_SAMPLES];
+    uint16_t counts[STREAM_BLOCKS];   // samples in each filled block
+
+    std::atomic<uint32_t> head;       // blocks filled, only written by fill()
+    std::atomic<uint32_t> tail;       // blocks played, only written by mix()
+    std::atomic<bool> playing;
+
+    // loop() side state
+    HalFile *file;
+    bool looping;
+    volatile bool ended;              // every block of the file has been published
+    int fill_bytes;                   // bytes already in the block being filled
+
+    // audio interrupt side state
+    int read_pos;                     // next sample of the block being played
+    volatile bool drained;            // played up to the end of the file
+    volatile int low_water;           // fewest blocks buffered at the start of a mix, before the end of the file
+    volatile unsigned long underruns;
+    volatile unsigned long underrun_samples;
+
+    volatile unsigned long blocks_read;
+    volatile unsigned long read_errors;
+};
+
+#endif
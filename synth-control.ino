@@ -1,95 +1,138 @@
-#include "SAMD51_InterruptTimer.h"
-#include "pwmHandler.h"
-#include "waveforms/SDHandling.h"
-#include <MIDI.h>
-#include <vector>
-
-#define N_SAMPLES 2048          // Number of samples in each wavetable entry
-#define N_WAVEFORMS 3           // Number of waveforms stored in wavetable
+#include "halSAMD51.h"
+#include "synth.h"
+#include "oscillator.h"
+#include "controlScheduler.h"
+#include "wavetable.h"
+#include "profiler.h"
+#include "logRing.h"
+#include "wavetableCache.h"
+#include "midiParser.h"
+
+#define N_WAVEFORMS BUILTIN_WAVEFORMS   // Number of waveforms stored in wavetable
 #define WAVEFORM_SELECT_PIN 1   // Pin for reading hardware to change waveforms
-
-
-TC_Timer TC_adsr(4);         // Interrupt timer for envelope generator
-TC_Timer TC_Midi(3);         // Interrupt timer for converting MIDI to analog waveforms
-TC_Timer TC_knob(2);         // Interrupt timer for reading filter knobs
-TC_Timer TC_adsrParams(1);   // Interrupt timer for reading adsr knobs
+#define LOG_DRAIN_PER_LOOP 4    // Most log lines printed per pass of loop()
+#define STREAM_REPORT_TICKS 1000 // Control ticks between stream underrun checks (1 s)
+#define MIDI_REPORT_TICKS 1000 // Control ticks between MIDI input error checks (1 s)
+#define MIDI_POLL_MAX 128       // Most MIDI bytes parsed per pass of loop()
+#define MIDI_BYTE_SAMPLES (AUDIO_SAMPLE_RATE * 10 / 31250) // Samples per MIDI byte (10 bits at 31250 baud)
+#define VCA_BLOCK_SIZE 64       // PWM periods per VCA stream buffer (1.37 ms at 47 kHz)
+#define STREAM_CONTROL 80       // MIDI controller that starts sample stream n (general purpose 5)
+#define BANK_LOAD_TIMEOUT 500000 // Longest wait for the first bank table in setup() (us)
+
+
+// Board backend of the HAL
+Samd51AudioOut dacOut(0);    // Streams audio blocks to the DAC on DMA channel 0, paced by TC3
+Samd51Timer controlTimer(2); // Control-rate tick for the scheduler
+Samd51Adc knobADC(1);        // Scans the knobs in the background, DMA channels 1 - 4
+Samd51MidiIn midiIn(&Serial1); // MIDI input UART
 
 // Custom PWM writers for pins 5 - 7
-pwmHandler pwm5(5);          // for filter cutoff control signal
-pwmHandler pwm6(6);          // for filter Q control signal
-pwmHandler pwm7(7);          // for ADSR envelope signal
+Samd51Pwm pwm5(5);           // for filter cutoff control signal
+Samd51Pwm pwm6(6);           // for filter Q control signal
+Samd51PwmStream vcaOut(7, 5); // for ADSR envelope signal, streamed by DMA channel 5
+
+Samd51SdFile streamFile;     // sample file being streamed from the SD card
+Samd51SdFile bankFile;       // wavetable bank the cache loads from
 
-MIDI_CREATE_DEFAULT_INSTANCE();
+Synth synth(&pwm5, &pwm6, &vcaOut);
+StreamPlayer player;         // reads streamFile ahead of the audio from loop()
+ControlScheduler control;    // Control-rate tasks, run from loop()
+WavetableCache bank;         // wavetables of the bank on the SD card, loaded by loop()
 
-double A440_num = 69;
+MidiParser midi;             // Parses midiIn and calls the handlers below
 
-double wavetable[N_WAVEFORMS][N_SAMPLES];
-int counter = 0;
-int downsample = 1;
+double A4_reference = 440;   // Reference pitch in Hz, applied to the tuning table in setup()
 
-int WAVEFORM_SEL_IDX = 1; // 0: sine, 1: square, 2: sawtooth
+// Ping-pong buffers sent to the DAC by DMA
+uint16_t audio_buffers[2][AUDIO_BLOCK_SIZE];
 
-// For reading manual cutoff frequency and Q control knobs
-int cutoffPin = A2;
-int cutoffVal = 255;
-int qPin = A3; 
-int qVal = 0;
+// Ping-pong buffers of VCA duty values sent to pin 7 by DMA
+uint16_t vca_buffers[2][VCA_BLOCK_SIZE];
 
-// For reading ADSR knobs
-int APin = A4; 
-int DPin = A5;
-int SPin = A6;
-int RPin = A7;
-int attack = 100;
-int decay = 200;
-int sustain_parameter = 127;
-int release = 1000;
-int maxVCA = 255;
+// Knob pins, in SynthKnob order
+const int knobPins[N_KNOBS] = {A2, A3, A4, A5, A6, A7};
 
 // Keep track of last waveform change for de-bouncing
 unsigned long last_waveform_isr_time = 0;
 
-// ISR function to send waveform samples to DAC
-void noteISR() {
-  analogWrite(A0, wavetable[WAVEFORM_SEL_IDX][downsample * counter] * (pow(2,11) - 1));
-  counter = (counter + 1) % (N_SAMPLES / downsample);
+// Stream underruns already reported
+unsigned long reported_underruns = 0;
+
+// MIDI input errors already reported
+unsigned long reported_midi_errors = 0;
+
+// Bank wavetable last asked for, -1 when playing the built-in waveforms
+volatile int bank_waveform = -1;
+
+// DMA callback to refill an audio buffer once the DAC has finished with it.
+// It also stamps how many MIDI bytes have arrived, which bounds their
+// arrival times to one block however late loop() gets to them.
+void audioBlockISR(uint16_t *block, int n) {
+  synth.render(block, n);
+  midi.stamp(&midiIn, synth.getSampleTime());
+}
+
+// DMA callback to refill a VCA buffer, one envelope step per PWM period
+void vcaBlockISR(uint16_t *block, int n) {
+  synth.renderVca(block, n);
 }
 
 // ISR function to change waveforms from user input
 void waveformISR() {
   unsigned long isrTime = millis();
   if (isrTime - last_waveform_isr_time > 200) {
-    WAVEFORM_SEL_IDX = (WAVEFORM_SEL_IDX + 1) % N_WAVEFORMS;
+    if (bank_waveform >= 0) {
+      // loop() loads the table while the current one keeps playing
+      selectWaveform((bank_waveform + 1) % bank.getCount());
+    } else {
+      selectWaveform((synth.getWaveform() + 1) % N_WAVEFORMS);
+    }
   }
   last_waveform_isr_time = isrTime;
-  Serial.print("waveform select idx: ");
-  Serial.println(WAVEFORM_SEL_IDX);
 }
 
-// ISR to check the filter control knobs
-void filterKnobISR() {
-  // adjust cutoff frequency and Q
-  cutoffVal = analogRead(cutoffPin);
-  cutoffVal = cutoffVal / 4;
-  qVal = analogRead(qPin);
-  qVal = 255 - qVal / 4;
-  pwm5.fast_pwm_analogWrite(cutoffVal);
-  pwm6.fast_pwm_analogWrite(qVal);
+// Switch to a waveform: a built-in one straight away, a bank one once the
+// cache has it in RAM
+void selectWaveform(int idx) {
+  if (bank_waveform >= 0) {
+    bank_waveform = idx;
+    bank.request(idx);
+  } else {
+    synth.setWaveform(idx);
+  }
+  LOG_INFO(LOG_MSG_WAVEFORM, idx, 0);
+}
+
+// Task to pick up the latest knob scan, the synth queues the knobs that moved
+void knobScanTask() {
+  uint16_t raw[N_KNOBS];
+  knobADC.readAll(raw);
+  synth.updateKnobs(raw);
+}
+
+// Task to report new stream underruns
+void streamReportTask() {
+  unsigned long underruns = player.getUnderruns();
+  if (underruns != reported_underruns) {
+    LOG_WARN(LOG_MSG_STREAM_UNDERRUN, underruns, player.getLowWater());
+    reported_underruns = underruns;
+  }
 }
 
-// ISR to check the ADSR control knobs
-void adsrKnobISR() {
-  int div = 1024 / (maxVCA + 1);
-  // adjust ADSR envelope parameters
-  int attackVal = analogRead(APin);
-  attack = maxVCA - (attackVal / div);
-  int decayVal = analogRead(DPin);
-  // decay = maxVCA - (decayVal / div);
-  decay = (maxVCA + 1) * div - decayVal;
-  int sustainVal = analogRead(SPin);
-  sustain_parameter = maxVCA - (sustainVal / div);
-  int releaseVal = analogRead(RPin);
-  release = (maxVCA + 1) * div - releaseVal;
+// Task to report bytes the MIDI parser had to throw away
+void midiReportTask() {
+  MidiParserStats stats;
+  midi.getStats(&stats);
+  unsigned long errors = stats.stray_bytes + stats.truncated + stats.sysex_overflows;
+  if (errors != reported_midi_errors) {
+    LOG_WARN(LOG_MSG_MIDI_ERRORS, stats.stray_bytes, stats.truncated + stats.sysex_overflows);
+    reported_midi_errors = errors;
+  }
+}
+
+// Control-rate tick, the scheduled tasks themselves run from loop()
+void controlTickISR() {
+  control.tick();
 }
 
 // the setup function runs once when you press reset or power the board
@@ -101,218 +144,171 @@ void setup() {
   pinMode(8, OUTPUT);
   digitalWrite(8, HIGH);
 
-  Serial.println("Entering setup()");
-  Serial.println(WAVEFORM_SEL_IDX);
+  PROFILE_INIT();
+  log_set_clock(logClock);
 
-  // Populate wavetable from SD Card memory
-  init_SDCard();
+  LOG_INFO(LOG_MSG_SETUP, synth.getWaveform(), 0);
 
-  std::vector<double> sine = read_SDCard("sine.txt", 2048);
-  std::vector<double> square = read_SDCard("square.txt", 2048);
-  std::vector<double> saw = read_SDCard("sawtooth.txt", 2048);
+  // Audio output: the CPU only wakes up to render a block. Notes only change
+  // the phase increment of a voice.
+  synth.setReference(A4_reference);
+  synth.setClock(logClock);   // places MIDI arrival times within an audio block
+  synth.begin();
+  synth.silence(audio_buffers[0], AUDIO_BLOCK_SIZE);
+  synth.silence(audio_buffers[1], AUDIO_BLOCK_SIZE);
 
-  for (int i = 0; i < N_SAMPLES; i++) {
-    wavetable[0][i] = sine[i];
-    wavetable[1][i] = square[i];
-    wavetable[2][i] = saw[i];
+  // Sample files on the SD card are streamed in by loop() and mixed with the
+  // voices, started by MIDI controller STREAM_CONTROL
+  if (!Samd51SdFile::begin()) {
+    LOG_WARN(LOG_MSG_SD_FAILED, 0, 0);
+  }
+  synth.setStream(&player);
+
+  // A wavetable bank on the card replaces the built-in waveforms. Only a few
+  // of its tables are held in RAM; the first one is loaded before audio starts.
+  // A bank that fails to load, or takes too long, is closed and the built-in
+  // waveforms are used.
+  if (bank.open(&bankFile, "WAVES.WTB")) {
+    const uint16_t *slots[WT_CACHE_SLOTS];
+    int slot = -1;
+    uint32_t start = logClock();
+    bank.setClock(logClock);
+    bank.request(0);
+    while (slot < 0 && bank.isLoading() && logClock() - start < BANK_LOAD_TIMEOUT) {
+      slot = bank.service(0);
+    }
+    if (slot < 0) {
+      WavetableCacheStats stats;
+      bank.getStats(&stats);
+      bank.close();
+      LOG_WARN(LOG_MSG_BANK_FAILED, stats.errors, logClock() - start);
+    } else {
+      LOG_INFO(LOG_MSG_BANK_OPEN, bank.getCount(), 0);
+      bank.getSlots(slots);
+      synth.setWavetables(slots, WT_CACHE_SLOTS);
+      synth.setWaveform(slot);
+      bank_waveform = 0;
+    }
   }
+  if (bank_waveform < 0) {
+    LOG_INFO(LOG_MSG_BANK_MISSING, 0, 0);
+  }
+
+  // The VCA envelope is rendered a buffer at a time and sent to pin 7 at the
+  // PWM rate, with no interrupt per step
+  synth.streamVca(vcaOut.getRate(), vcaOut.getTop());
+  synth.renderVca(vca_buffers[0], VCA_BLOCK_SIZE);
+  synth.renderVca(vca_buffers[1], VCA_BLOCK_SIZE);
+  vcaOut.start(vca_buffers[0], vca_buffers[1], VCA_BLOCK_SIZE, vcaBlockISR);
 
-  Serial.println("MIDI begin");
+  dacOut.start(audio_buffers[0], audio_buffers[1], AUDIO_BLOCK_SIZE, audioBlockISR);
 
-  MIDI.begin(MIDI_CHANNEL_OMNI); // initialize the Midi Library (listen to all channels)
-  MIDI.setHandleNoteOn(MyHandleNoteOn); // set callback function for when Note On is receieved
-  MIDI.setHandleNoteOff(MyHandleNoteOff); // set callback function for Note Off
+  LOG_INFO(LOG_MSG_MIDI_BEGIN, 0, 0);
 
-  // set Q control and cutoff frequency
-  pwm6.fast_pwm_analogWrite(qVal);  // Q control
-  pwm5.fast_pwm_analogWrite(cutoffVal); // cutoff frequency
-  TC_knob.startTimer(100000, filterKnobISR); 
+  midiIn.begin(); // all channels are handled
+  midi.setByteTime(MIDI_BYTE_SAMPLES); // notes are stamped with the sample they arrived at
+  midi.setHandler(MIDI_NOTE_ON, MyHandleNoteOn); // set callback function for when Note On is receieved
+  midi.setHandler(MIDI_NOTE_OFF, MyHandleNoteOff); // set callback function for Note Off (and Note On with velocity 0)
+  midi.setHandler(MIDI_PROGRAM_CHANGE, MyHandleProgramChange); // select a waveform
+  midi.setHandler(MIDI_CONTROL_CHANGE, MyHandleControlChange); // start or stop a sample stream
 
-  // set ADSR values
-  TC_adsrParams.startTimer(1000000, adsrKnobISR);
+  // The ADC scans the knobs by itself; the latest readings are filtered at
+  // control rate and only knobs that moved are sent to the audio interrupt
+  knobADC.begin(knobPins, N_KNOBS);
+  control.addTask(knobScanTask, 1, 1);   // first run once a full scan has completed
+  control.addTask(streamReportTask, STREAM_REPORT_TICKS, STREAM_REPORT_TICKS);
+  control.addTask(midiReportTask, MIDI_REPORT_TICKS, MIDI_REPORT_TICKS);
+  controlTimer.start(CONTROL_TICK_PERIOD, controlTickISR);
 
   // Set hardware interrupt for waveform selection
   pinMode(WAVEFORM_SELECT_PIN, INPUT_PULLUP); //Setup internal pullup for digital input
   attachInterrupt(digitalPinToInterrupt(WAVEFORM_SELECT_PIN), waveformISR, FALLING); //Create interrupt whenever this pin is pulled low
 }
 
-// the loop function waits for MIDI data
+// the loop function waits for MIDI data and runs the control tasks, then
+// prints a few log records if there is time left
 void loop() {
-  MIDI.read();
+  midi.poll(&midiIn, MIDI_POLL_MAX, synth.getSampleTime());   // every message that has arrived, not just one
+  player.fill(1);   // one SD block per pass keeps MIDI and the tasks responsive
+  serviceBank();
+  if (control.run() == 0) {
+    log_drain(serialPrint, LOG_DRAIN_PER_LOOP);
+  }
+
+#ifdef PROFILE_ENABLED
+  // Send 'p' over USB serial for a binary dump of the handler timings
+  if (Serial.available() && Serial.read() == 'p') {
+    PROFILE_DUMP(serialWrite);
+  }
+#endif
+}
+
+// Load the selected bank wavetable a chunk at a time, never into a slot the
+// voices may still play. Voices change over to it at the end of their cycle.
+void serviceBank() {
+  int slot = bank.service(synth.getWavetablesInUse());
+  if (slot >= 0) {
+    synth.setWaveform(slot);
+    WavetableCacheStats stats;
+    bank.getStats(&stats);
+    LOG_DEBUG(LOG_MSG_BANK_LOADED, bank.getSlotTable(slot), stats.last_latency);
+  }
+}
+
+// Log timestamps in microseconds
+uint32_t logClock() {
+  return micros();
+}
+
+void serialPrint(const char *text) {
+  Serial.print(text);
 }
 
-// Global variables for ADSR EG
-int attack_count = 0;
-int decay_count = 0;
-int release_count = 0;
-uint8_t sustain = 0;
-bool attack_done = false;
-bool decay_done = false;
-bool release_done = false;
-bool midi_off = false;
-bool note_playing = false;
-int decay_time_between_writes = 0;
-int release_time_between_writes = 0;
-uint8_t last_value;
-int current_note;
+#ifdef PROFILE_ENABLED
+void serialWrite(const uint8_t *data, int n) {
+  Serial.write(data, n);
+}
+#endif
 
 // MIDI Note On Handler
 void MyHandleNoteOn(byte channel, byte pitch, byte velocity) { 
-
-  current_note = int(pitch);
-
-  double diff = double(pitch) - A440_num;
-  double freq = 440 * pow(2, diff/12);
-
-  Serial.println(freq);
-  Serial.println(pitch);
-
-  // -------- Uncomment this section to improve tuning --------
-  // if (pitch < 15) {
-  //   diff = double(pitch) - (A440_num - 60);
-  //   freq = 13.75 * pow(2, diff/12);
-  // } else if (pitch >= 15 && pitch < 27) {
-  //   diff = double(pitch) - (A440_num - 48);
-  //   freq = 27.5 * pow(2, diff/12);
-  // } else if (pitch >= 27 && pitch < 39) {
-  //   diff = double(pitch) - (A440_num - 36);
-  //   freq = 55 * pow(2, diff/12);
-  // } else if (pitch >= 39 && pitch < 51) {
-  //   diff = double(pitch) - (A440_num - 24);
-  //   freq = 110 * pow(2, diff/12);
-  // } else if (pitch >= 51 && pitch < 63) {
-  //   diff = double(pitch) - (A440_num - 12);
-  //   freq = 220 * pow(2, diff/12);
-  // } else if (pitch >= 63 && pitch < 75) {
-  //   diff = double(pitch) - A440_num;    
-  //   freq = 440 * pow(2, diff/12);
-  // } else if (pitch >= 75 && pitch < 87) {
-  //   diff = double(pitch) - (A440_num + 12);    
-  //   freq = 880 * pow(2, diff/12);
-  // } else if (pitch >= 87 && pitch < 99) {
-  //   diff = double(pitch) - (A440_num + 24);    
-  //   freq = 1760 * pow(2, diff/12);
-  // } else {
-  //   diff = double(pitch) - (A440_num + 36);    
-  //   freq = 3520 * pow(2, diff/12);
-  // }
-  // ------------------------------------------------------------
-
-  if (pitch > 54 && pitch < 67) {
-    downsample = 2;
-  } else if (pitch < 79) {
-    downsample = 4;
-  } else if (pitch < 91) {
-    downsample = 8;
-  } else if (pitch < 103) {
-    downsample = 16;
-  } else if (pitch < 115) {
-    downsample = 32;
-  } else {
-    downsample = 64;
+  PROFILE_SCOPE(PROF_MIDI_NOTE_ON);
+  LOG_DEBUG(LOG_MSG_NOTE_ON, pitch, velocity);
+  if (!synth.noteOn(channel, pitch, velocity, midi.getTime())) {
+    LOG_WARN(LOG_MSG_QUEUE_FULL, pitch, 0);
   }
-
-  double samps_per_sec = freq * N_SAMPLES / downsample;
-  
-  if (note_playing) {
-    TC_Midi.stopTimer();
-    TC_adsr.stopTimer();
-
-    attack_count = 0;
-    decay_count = 0;
-    release_count = 0;
-    attack_done = false;
-    decay_done = false;
-    release_done = false;
-    midi_off = false;
-  }  
-
-  // Time is given in 10s of ns
-  TC_Midi.startTimer(((1.0 / samps_per_sec) * 100000000.0), noteISR); // start playing note
-  note_playing = true;
-  // writeADSREnvelope(100, 200, 127, 1000);
-  writeADSREnvelope(attack, decay, sustain_parameter, release);
 }
 
 // MIDI Note Off Handler
 void MyHandleNoteOff(byte channel, byte pitch, byte velocity) { 
-  if (int(pitch) == current_note) {
-    attack_count = 0;
-    decay_count = 0;
-    attack_done = true;
-    decay_done = true;
-    midi_off = true;
-    release_time_between_writes = release_time_between_writes / last_value;
-    TC_adsr.stopTimer();
-    TC_adsr.startTimer(release_time_between_writes, adsrISR);
-    // TC_Midi.stopTimer(); // stop playing note
+  PROFILE_SCOPE(PROF_MIDI_NOTE_OFF);
+  LOG_DEBUG(LOG_MSG_NOTE_OFF, pitch, 0);
+  if (!synth.noteOff(channel, pitch, velocity, midi.getTime())) {
+    LOG_WARN(LOG_MSG_QUEUE_FULL, pitch, 0);
   }
 }
 
-// ISR function to produce ADSR envelope
-void adsrISR() {
-
-    if (!attack_done) {
-      if (attack_count < maxVCA + 1) {
-        pwm7.fast_pwm_analogWrite(maxVCA - attack_count);
-        last_value = attack_count;
-        attack_count++;
-      } else {
-        attack_count = 0;
-        TC_adsr.stopTimer();
-        TC_adsr.startTimer(decay_time_between_writes, adsrISR);
-        attack_done = true;
-      }
-    } else if (!decay_done) {
-      if ((maxVCA-decay_count) >= sustain && decay_count < maxVCA + 1) {
-        pwm7.fast_pwm_analogWrite(decay_count);
-        last_value = maxVCA - decay_count;
-        decay_count++;
-      } else {
-        decay_count = 0;
-        // TC_adsr.stopTimer();
-        // TC_adsr.startTimer(release_time_between_writes, adsrISR);
-        decay_done = true;
-      }
-    } else if (midi_off) {
-      if ((last_value - release_count) >= 0) {
-        // analogWrite(5, last_value - release_count);
-        pwm7.fast_pwm_analogWrite(maxVCA - (last_value - release_count));      
-        release_count++;
-      } else {
-        TC_adsr.stopTimer();
-        TC_Midi.stopTimer();
-        
-        attack_count = 0;
-        decay_count = 0;
-        release_count = 0;
-        attack_done = false;
-        decay_done = false;
-        release_done = false;
-        midi_off = false;
-        note_playing = false;
-        analogWrite(A0, 0); // reset DAC output to 0
-        
-      }
-    }
-
+// MIDI Program Change Handler: select a waveform of the bank, or of the
+// built-in ones
+void MyHandleProgramChange(byte channel, byte number, byte unused) {
+  int count = bank_waveform >= 0 ? bank.getCount() : N_WAVEFORMS;
+  if (number < count) {
+    selectWaveform(number);
+  }
 }
 
-// Function to trigger ADSR envelope (input times in milliseconds)
-void writeADSREnvelope(int A, int D, uint8_t S, int R) {
-  if (A == 0) {
-    A = 1;
-  }  
-  int attack_tens_of_ns = A * 1000 * 100;
-  int attack_time_between_writes = attack_tens_of_ns / (maxVCA + 1);
-  
-  int decay_tens_of_ns = D * 1000 * 100;
-  decay_time_between_writes = decay_tens_of_ns / (maxVCA + 1 - S);
-  sustain = S;
-
-  int release_tens_of_ns = R * 1000 * 100;
-  // release_time_between_writes = release_tens_of_ns / 256;
-  release_time_between_writes = release_tens_of_ns;
-
-  TC_adsr.startTimer(attack_time_between_writes, adsrISR);
+// MIDI Control Change Handler: controller STREAM_CONTROL streams STREAMnn.RAW
+// (raw 16-bit mono at the audio sample rate) from the SD card, or stops if
+// there is no such file
+void MyHandleControlChange(byte channel, byte number, byte value) {
+  if (number != STREAM_CONTROL) {
+    return;
+  }
+  char name[16];
+  snprintf(name, sizeof(name), "STREAM%02d.RAW", value);
+  if (player.start(&streamFile, name, false)) {
+    LOG_INFO(LOG_MSG_STREAM_START, value, 0);
+  } else {
+    LOG_INFO(LOG_MSG_STREAM_MISSING, value, 0);
+  }
 }
@@ -0,0 +1,339 @@
+#include "synth.h"
+#include "oscillator.h"
+#include "wavetable.h"
+
+Synth::Synth(HalPwm *cutoff, HalPwm *q, HalPwm *vca) : renderer(&voices) {
+  this -> pwm_cutoff = cutoff;
+  this -> pwm_q = q;
+  this -> pwm_vca = vca;
+
+  this -> waveform = 1;
+  this -> cutoff = 255;
+  this -> q = 0;
+  this -> attack = 100;
+  this -> decay = 200;
+  this -> sustain = 127;
+  this -> release = 1000;
+  this -> vca_rate = AUDIO_SAMPLE_RATE;
+  this -> vca_top = 0;
+  this -> stream = 0;
+  this -> latency = SYNTH_EVENT_LATENCY;
+  this -> clock = 0;
+  this -> has_next_event = false;
+  this -> late_events = 0;
+  this -> block_end = 0;
+  this -> block_time = 0;
+  this -> block_samples = 0;
+  this -> block_seq = 0;
+}
+
+// Set the outputs to their starting values, before audio starts
+void Synth::begin() {
+  const uint16_t *tables[BUILTIN_WAVEFORMS];
+  for (int w = 0; w < BUILTIN_WAVEFORMS; w++) {
+    tables[w] = builtin_wavetables[w];
+  }
+  this -> voices.setWavetables(tables, BUILTIN_WAVEFORMS);
+
+  this -> vca.setParams(&(this -> vca_params));
+  writeEnvelope();
+  setWaveform(this -> waveform);
+
+  this -> pwm_vca -> write(SYNTH_VCA_MAX);
+  this -> pwm_q -> write(this -> q);
+  this -> pwm_cutoff -> write(this -> cutoff);
+}
+
+void Synth::setReference(double a4_hz) {
+  if (a4_hz != this -> tuning.getReference()) {
+    this -> tuning.setReference(a4_hz);
+  }
+}
+
+// Play from another set of wavetables, e.g. the slots of a WavetableCache,
+// in place of the built-in ones. Call before audio starts.
+void Synth::setWavetables(const uint16_t * const *mipsets, int count) {
+  this -> voices.setWavetables(mipsets, count);
+  this -> waveform = this -> voices.getMorph() >> VOICE_MORPH_BITS;
+}
+
+void Synth::setWaveform(int idx) {
+  if (idx < 0 || idx >= this -> voices.getWavetableCount()) {
+    idx = 0;
+  }
+  this -> waveform = idx;
+  this -> voices.setMorph(idx << VOICE_MORPH_BITS);
+}
+
+int Synth::getWaveform() {
+  return this -> waveform;
+}
+
+// Crossfade between adjacent waveforms: position is waveform * 256 plus how
+// far to fade towards the next one. Voices change over at the end of a cycle.
+void Synth::setMorph(uint16_t position) {
+  this -> voices.setMorph(position);
+  this -> waveform = this -> voices.getMorph() >> VOICE_MORPH_BITS;
+}
+
+uint16_t Synth::getMorph() {
+  return this -> voices.getMorph();
+}
+
+// Mask of the wavetables the voices may still read, see VoicePool
+uint32_t Synth::getWavetablesInUse() {
+  return this -> voices.getWavetablesInUse();
+}
+
+// Mix a streamed sample in with the voices. Call before audio starts; the
+// player itself is started and fed from loop().
+void Synth::setStream(StreamPlayer *player) {
+  this -> stream = player;
+}
+
+// Time source for getSampleTime(), e.g. micros() on the board. Without one
+// the sample time only moves a block at a time.
+void Synth::setClock(uint32_t (*now)()) {
+  this -> clock = now;
+}
+
+// Delay from the arrival of a note to its onset. It has to cover the block
+// being played and the one already rendered (2 blocks) plus how late loop()
+// may get to a message; notes that still miss it start at the next block.
+void Synth::setLatency(uint32_t samples) {
+  this -> latency = samples;
+}
+
+uint32_t Synth::getLatency() {
+  return this -> latency;
+}
+
+// Sample being played by the DAC now, on the same clock as getSampleClock().
+// The block rendered last plays after the one playing now, so the DAC is two
+// blocks behind the sample clock at each audio interrupt and moves on at the
+// sample rate until the next one.
+uint32_t Synth::getSampleTime() {
+  uint32_t seq, end, t;
+  int n;
+  do {
+    seq = this -> block_seq;
+    end = this -> block_end;
+    t = this -> block_time;
+    n = this -> block_samples;
+  } while (seq != this -> block_seq);
+
+  uint32_t elapsed = 0;
+  if (this -> clock != 0) {
+    elapsed = (uint64_t)(this -> clock() - t) * AUDIO_SAMPLE_RATE / 1000000UL;
+    if (elapsed > (uint32_t)n) {
+      elapsed = n;
+    }
+  }
+  return end - 2 * n + elapsed;
+}
+
+// Schedule a note latency samples after it arrived and queue it
+bool Synth::queueNote(SynthEvent &e, uint32_t time) {
+  uint32_t now = getSampleTime();
+  if ((int32_t)(time - now) > 0) {
+    time = now;   // never ahead of the DAC, or it would hold up the queue
+  }
+  e.timestamp = time + this -> latency;
+  return this -> events.push(e);
+}
+
+bool Synth::noteOn(uint8_t channel, uint8_t note, uint8_t velocity, uint32_t time) {
+  SynthEvent e;
+  e.type = EVENT_NOTE_ON;
+  e.channel = channel;
+  e.note = note;
+  e.velocity = velocity;
+  e.value = 0;
+  return queueNote(e, time);
+}
+
+bool Synth::noteOff(uint8_t channel, uint8_t note, uint8_t velocity, uint32_t time) {
+  SynthEvent e;
+  e.type = EVENT_NOTE_OFF;
+  e.channel = channel;
+  e.note = note;
+  e.velocity = velocity;
+  e.value = 0;
+  return queueNote(e, time);
+}
+
+// Filter the latest reading of every knob and queue the ones that moved
+void Synth::updateKnobs(const uint16_t *raw) {
+  uint32_t changed = knob_update_all(this -> knob_filters, raw, N_KNOBS);
+
+  for (int i = 0; changed != 0; i++, changed >>= 1) {
+    if (changed & 1) {
+      SynthEvent e;
+      e.type = EVENT_PARAM;
+      e.channel = 0;
+      e.note = i;
+      e.velocity = 0;
+      e.value = this -> knob_filters[i].getValue();
+      e.timestamp = this -> renderer.getSampleClock();   // start of the next block
+      this -> events.push(e);
+    }
+  }
+}
+
+// Refill an audio buffer once the DAC has finished with it. The block is
+// rendered in pieces split at the samples queued events are due, so voices
+// and the envelope are only ever changed from interrupt context and notes
+// start exactly on time. Events stay in queue order; one that is not due yet
+// holds back those behind it.
+void Synth::render(uint16_t *block, int n) {
+  uint32_t start = this -> renderer.getSampleClock();
+  uint32_t now = this -> clock ? this -> clock() : 0;
+  int done = 0;
+
+  while (done < n) {
+    int next = n;
+    for (;;) {
+      if (!this -> has_next_event) {
+        if (!this -> events.pop(this -> next_event)) {
+          break;
+        }
+        this -> has_next_event = true;
+      }
+      int32_t offset = (int32_t)(this -> next_event.timestamp - start);
+      if (offset > done) {
+        if (offset < next) {
+          next = offset;
+        }
+        break;
+      }
+      if (offset < 0 && this -> next_event.type != EVENT_PARAM) {
+        this -> late_events++;
+      }
+      applyEvent(this -> next_event);
+      this -> has_next_event = false;
+    }
+    this -> renderer.render(block + done, next - done);
+    done = next;
+  }
+
+  this -> block_end = start + n;
+  this -> block_time = now;
+  this -> block_samples = n;
+  this -> block_seq++;
+
+  if (this -> stream != 0) {
+    this -> stream -> mix(block, n);
+  }
+
+  // The VCA input is inverted: SYNTH_VCA_MAX is silence
+  if (this -> vca_top == 0) {
+    uint16_t level = this -> vca.advance(n);
+    this -> pwm_vca -> write(SYNTH_VCA_MAX - (level >> 8));
+  }
+}
+
+// Step the VCA envelope at the rate of a PWM stream instead of once per audio
+// block. top is the stream value of a fully on (closed) output.
+void Synth::streamVca(unsigned long rate, uint16_t top) {
+  this -> vca_rate = rate;
+  this -> vca_top = top;
+  writeEnvelope();
+}
+
+// Fill a stream buffer with one VCA value per PWM period. Runs from the
+// stream's DMA interrupt, which does not preempt render().
+void Synth::renderVca(uint16_t *block, int n) {
+  uint32_t top = this -> vca_top;
+  for (int i = 0; i < n; i++) {
+    uint32_t level = this -> vca.next();
+    block[i] = (uint16_t)(top - ((level * (top + 1)) >> 16));
+  }
+}
+
+void Synth::silence(uint16_t *block, int n) {
+  this -> renderer.silence(block, n);
+}
+
+void Synth::applyEvent(const SynthEvent &e) {
+  if (e.type == EVENT_NOTE_ON) {
+    startNote(e.note);
+  } else if (e.type == EVENT_NOTE_OFF) {
+    releaseNote(e.note);
+  } else {
+    applyKnob(e.note, e.value);
+  }
+}
+
+// Start a voice and restart the VCA envelope
+void Synth::startNote(uint8_t note) {
+  this -> voices.noteOn(note, this -> tuning.increment(note));
+  this -> vca.noteOn();
+}
+
+// Release a voice, and the VCA once the last held key goes up
+void Synth::releaseNote(uint8_t note) {
+  this -> voices.noteOff(note);
+
+  if (this -> voices.getHeldCount() == 0) {
+    this -> vca.noteOff();
+  }
+}
+
+// Apply a new knob reading (0 - 1023)
+void Synth::applyKnob(int knob, int val) {
+  const int max = SYNTH_VCA_MAX;
+  int div = 1024 / (max + 1);
+
+  switch (knob) {
+    // adjust cutoff frequency and Q
+    case KNOB_CUTOFF:
+      this -> cutoff = val / 4;
+      this -> pwm_cutoff -> write(this -> cutoff);
+      return;
+    case KNOB_Q:
+      this -> q = 255 - val / 4;
+      this -> pwm_q -> write(this -> q);
+      return;
+
+    // adjust ADSR envelope parameters
+    case KNOB_ATTACK:
+      this -> attack = max - (val / div);
+      break;
+    case KNOB_DECAY:
+      this -> decay = (max + 1) * div - val;
+      break;
+    case KNOB_SUSTAIN:
+      this -> sustain = max - (val / div);
+      break;
+    case KNOB_RELEASE:
+      this -> release = (max + 1) * div - val;
+      break;
+  }
+  writeEnvelope();
+}
+
+void Synth::writeEnvelope() {
+  uint16_t s = (uint16_t)(this -> sustain * ENV_LEVEL_MAX / SYNTH_VCA_MAX);
+  envelope_set_params(&(this -> vca_params), this -> attack, this -> decay, s, this -> release,
+                      this -> vca_rate);
+
+  // Each voice fades in and out with the same times as the VCA envelope
+  this -> voices.setEnvelope(this -> attack, this -> release, AUDIO_SAMPLE_RATE);
+}
+
+uint32_t Synth::getSampleClock() {
+  return this -> renderer.getSampleClock();
+}
+
+unsigned long Synth::getDroppedEvents() {
+  return this -> events.getDropped();
+}
+
+// Notes that arrived too late for the latency and started late
+unsigned long Synth::getLateEvents() {
+  return this -> late_events;
+}
+
+int Synth::getActiveVoices() {
+  return this -> voices.getActiveCount();
+}
@@ -0,0 +1,124 @@
+/*
+  synth.h
+  The synth itself, independent of the board
+
+  Owns the tuning, voices, renderer, VCA envelope and knob filters, and only
+  reaches hardware through the HAL interfaces of hal.h. Notes and knob
+  readings come in from loop() and are queued for the audio interrupt. A
+  note carries the sample time it arrived at (getSampleTime()) and starts a
+  fixed latency later, on that exact sample even in the middle of a block;
+  knob changes apply at the start of the next block. The VCA envelope is
+  either written once per audio block or, after streamVca(), rendered a
+  buffer at a time for a PWM stream. Plain C++ so the whole synth can be
+  driven by the Linux backend on a host machine.
+*/
+
+#ifndef SYNTH_H
+#define SYNTH_H
+
+#include <stdint.h>
+#include "hal.h"
+#include "tuning.h"
+#include "envelope.h"
+#include "voicePool.h"
+#include "blockRenderer.h"
+#include "eventQueue.h"
+#include "knobFilter.h"
+#include "streamPlayer.h"
+
+#define SYNTH_VCA_MAX 255     // PWM value of a closed VCA (the VCA input is inverted)
+#define SYNTH_EVENT_QUEUE 64  // Events that can wait for the next audio block
+#define SYNTH_EVENT_LATENCY (3 * AUDIO_BLOCK_SIZE)   // Samples from the arrival of a note to its onset
+
+// Knobs, in the order they are scanned and numbered in parameter events
+enum SynthKnob {
+  KNOB_CUTOFF,
+  KNOB_Q,
+  KNOB_ATTACK,
+  KNOB_DECAY,
+  KNOB_SUSTAIN,
+  KNOB_RELEASE,
+  N_KNOBS
+};
+
+class Synth {
+  public:
+    Synth(HalPwm *cutoff, HalPwm *q, HalPwm *vca);
+    void begin();
+    void setReference(double a4_hz);
+    void setWavetables(const uint16_t * const *mipsets, int count);
+    void setWaveform(int idx);
+    int getWaveform();
+    void setMorph(uint16_t position);
+    uint16_t getMorph();
+    uint32_t getWavetablesInUse();
+    void setStream(StreamPlayer *player);
+    void setClock(uint32_t (*now)());
+    void setLatency(uint32_t samples);
+    uint32_t getLatency();
+
+    // loop() side: queue work for the audio interrupt. time is the sample
+    // time the message arrived at, from getSampleTime().
+    uint32_t getSampleTime();
+    bool noteOn(uint8_t channel, uint8_t note, uint8_t velocity, uint32_t time);
+    bool noteOff(uint8_t channel, uint8_t note, uint8_t velocity, uint32_t time);
+    void updateKnobs(const uint16_t *raw);
+
+    // audio interrupt side
+    void render(uint16_t *block, int n);
+    void silence(uint16_t *block, int n);
+
+    // VCA stream: call streamVca() before starting the stream, renderVca()
+    // refills its buffers
+    void streamVca(unsigned long rate, uint16_t top);
+    void renderVca(uint16_t *block, int n);
+
+    uint32_t getSampleClock();
+    unsigned long getDroppedEvents();
+    unsigned long getLateEvents();
+    int getActiveVoices();
+
+  private:
+    bool queueNote(SynthEvent &e, uint32_t time);
+    void applyEvent(const SynthEvent &e);
+    void startNote(uint8_t note);
+    void releaseNote(uint8_t note);
+    void applyKnob(int knob, int val);
+    void writeEnvelope();
+
+    HalPwm *pwm_cutoff;
+    HalPwm *pwm_q;
+    HalPwm *pwm_vca;
+
+    TuningTable tuning;
+    VoicePool voices;
+    BlockRenderer renderer;
+    Envelope vca;
+    EnvelopeParams vca_params;
+    unsigned long vca_rate;   // envelope steps per second
+    uint16_t vca_top;         // stream value of a closed VCA, 0 when not streamed
+    EventQueue<SynthEvent, SYNTH_EVENT_QUEUE> events;
+    KnobFilter knob_filters[N_KNOBS];
+    StreamPlayer *stream;     // mixed into the voices when set
+
+    // Note scheduling
+    uint32_t latency;                // samples added to the arrival time of a note
+    uint32_t (*clock)();             // microseconds, places getSampleTime() within a block
+    SynthEvent next_event;           // popped but not due yet
+    bool has_next_event;
+    volatile unsigned long late_events;
+    volatile uint32_t block_end;     // sample clock after the last rendered block
+    volatile uint32_t block_time;    // clock() when it was rendered
+    volatile int block_samples;
+    volatile uint32_t block_seq;     // bumped after the three above are written
+
+    volatile int waveform;   // table the morph starts from (built-in: 0 sine, 1 square, 2 sawtooth)
+    int cutoff;
+    int q;
+    int attack;              // ms
+    int decay;               // ms
+    int sustain;             // 0 - SYNTH_VCA_MAX
+    int release;             // ms
+};
+
+#endif
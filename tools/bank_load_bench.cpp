@@ -0,0 +1,213 @@
+// bank_load_bench - load time of the old text tables against a binary bank
+//
+// Writes the sine, square and saw tables of 2048 samples the old way, as
+// comma-separated text with two decimals (String(double) in write_SDCard),
+// and the built-in mip sets as one binary bank (waveforms/wavetableBank.h).
+// Then loads them back repeatedly:
+//   text  - a byte per read call appended to a std::string, split with
+//           std::stringstream/getline, std::stod and converted to DAC codes,
+//           as read_SDCard did
+//   bank  - WavetableCache::open() on a LinuxFile, then every table
+//           requested and serviced into its slot, as setup() does
+// Each load must give back the DAC codes that were written. Prints the host
+// time per load and the bytes each reads, with the time those bytes take on
+// a card at -r bytes per second, which is what dominates on the board.
+//
+// Build and run from the repository root:
+//   g++ -O2 -std=gnu++11 -I. -o bank_load_bench tools/bank_load_bench.cpp wavetable.cpp wavetableData.cpp
+//       wavetableCache.cpp halLinux.cpp
+//   ./bank_load_bench [-n loads] [-r card_bytes_per_sec] [dir]
+
+#include "wavetable.h"
+#include "wavetableCache.h"
+#include "halLinux.h"
+#include "waveforms/additiveSynthesis.h"
+#include "waveforms/wavetableBank.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <sstream>
+#include <string>
+
+#define N_TABLES 3
+#define N_SAMPLES 2048
+
+static const char *names[N_TABLES] = {"sine", "square", "saw"};
+
+static std::string text_name(const char *dir, int t) {
+  return std::string(dir) + "/" + names[t] + "2048.txt";
+}
+
+// Writes the text files and the bank, and the DAC codes the text holds
+static bool write_files(const char *dir, const std::string &bank_name, uint16_t *codes) {
+  std::vector<double> vals[N_TABLES] = {makeSine(N_SAMPLES), makeSquare(N_SAMPLES), makeSaw(N_SAMPLES)};
+
+  for (int t = 0; t < N_TABLES; t++) {
+    FILE *f = fopen(text_name(dir, t).c_str(), "w");
+    if (f == NULL) {
+      fprintf(stderr, "error writing %s\n", text_name(dir, t).c_str());
+      return false;
+    }
+    for (int i = 0; i < N_SAMPLES; i++) {
+      fprintf(f, "%s%.2f", i ? "," : "", vals[t][i]);
+    }
+    fclose(f);
+
+    for (int i = 0; i < N_SAMPLES; i++) {
+      codes[t * N_SAMPLES + i] = dac_code(floor(vals[t][i] * 100 + 0.5) / 100);
+    }
+  }
+
+  WavetableBankHeader header;
+  header.magic = WT_BANK_MAGIC;
+  header.version = WT_BANK_VERSION;
+  header.table_count = N_TABLES;
+  header.table_size = MIP_TOTAL_SAMPLES;
+  header.sample_type = WT_SAMPLE_DAC_U16;
+  header.mip_max_bits = MIP_MAX_BITS;
+  header.mip_min_bits = MIP_MIN_BITS;
+  header.mip_top_bits = MIP_TOP_BITS;
+  header.crc32 = wt_crc32(0, builtin_wavetables, sizeof(builtin_wavetables));
+  FILE *f = fopen(bank_name.c_str(), "wb");
+  if (f == NULL) {
+    fprintf(stderr, "error writing %s\n", bank_name.c_str());
+    return false;
+  }
+  fwrite(&header, sizeof(header), 1, f);
+  fwrite(builtin_wavetables, sizeof(builtin_wavetables), 1, f);
+  fclose(f);
+  return true;
+}
+
+// read_SDCard() with the SD library swapped for stdio
+static long load_text(const char *dir, uint16_t *dst) {
+  long bytes = 0;
+  for (int t = 0; t < N_TABLES; t++) {
+    FILE *f = fopen(text_name(dir, t).c_str(), "r");
+    if (f == NULL) {
+      return -1;
+    }
+    std::string data;
+    int c;
+    while ((c = fgetc(f)) != EOF) {
+      data += char(c);
+    }
+    fclose(f);
+    bytes += data.size();
+
+    std::vector<double> v(N_SAMPLES, 0.0);
+    std::stringstream ss(data);
+    int idx = 0;
+    while (ss.good()) {
+      std::string substr;
+      std::getline(ss, substr, ',');
+      v[idx] = std::stod(substr);
+      idx++;
+      if (idx >= N_SAMPLES) {
+        break;
+      }
+    }
+    load_dac_codes(dst + t * N_SAMPLES, v, N_SAMPLES);
+  }
+  return bytes;
+}
+
+// The loader setup() uses, on a host file with no throughput limit; slots
+// are filled in table order
+static long load_bank(const std::string &bank_name, WavetableCache *cache, HalFile *file) {
+  if (!cache -> open(file, bank_name.c_str()) || cache -> getCount() != N_TABLES) {
+    return -1;
+  }
+  for (int t = 0; t < N_TABLES; t++) {
+    cache -> request(t);
+    while (cache -> service(0) < 0) {
+      if (!cache -> isLoading()) {
+        cache -> close();
+        return -1;
+      }
+    }
+  }
+  cache -> close();
+  return sizeof(WavetableBankHeader) + N_TABLES * MIP_TOTAL_SAMPLES * sizeof(uint16_t);
+}
+
+// Whether every table is in a slot with the built-in codes
+static bool bank_matches(WavetableCache *cache) {
+  const uint16_t *slots[WT_CACHE_SLOTS];
+  cache -> getSlots(slots);
+  for (int t = 0; t < N_TABLES; t++) {
+    bool found = false;
+    for (int s = 0; s < WT_CACHE_SLOTS; s++) {
+      found = found || (cache -> getSlotTable(s) == t &&
+                        memcmp(slots[s], builtin_wavetables[t], sizeof(builtin_wavetables[t])) == 0);
+    }
+    if (!found) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char **argv) {
+  int loads = 20;
+  double card_rate = 500000;
+  const char *dir = "/tmp";
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+      loads = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+      card_rate = atof(argv[++i]);
+    } else if (argv[i][0] != '-') {
+      dir = argv[i];
+    } else {
+      fprintf(stderr, "usage: %s [-n loads] [-r card_bytes_per_sec] [dir]\n", argv[0]);
+      return 1;
+    }
+  }
+  if (loads <= 0 || card_rate <= 0) {
+    fprintf(stderr, "loads and card rate must be positive\n");
+    return 1;
+  }
+
+  std::string bank_name = std::string(dir) + "/BENCH.WTB";
+  static uint16_t codes[N_TABLES * N_SAMPLES];
+  if (!write_files(dir, bank_name, codes)) {
+    return 1;
+  }
+
+  static uint16_t text_codes[N_TABLES * N_SAMPLES];
+  static WavetableCache cache;
+  LinuxClock clock;
+  LinuxFile file(&clock);
+  long text_bytes = 0, bank_bytes = 0;
+
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < loads; i++) {
+    text_bytes = load_text(dir, text_codes);
+  }
+  std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+  for (int i = 0; i < loads; i++) {
+    bank_bytes = load_bank(bank_name, &cache, &file);
+  }
+  std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+
+  if (text_bytes < 0 || bank_bytes < 0) {
+    fprintf(stderr, "load failed\n");
+    return 1;
+  }
+  if (memcmp(text_codes, codes, sizeof(codes)) != 0 || !bank_matches(&cache)) {
+    fprintf(stderr, "loaded tables differ from the ones written\n");
+    return 1;
+  }
+
+  double text_us = std::chrono::duration<double>(t1 - t0).count() * 1e6 / loads;
+  double bank_us = std::chrono::duration<double>(t2 - t1).count() * 1e6 / loads;
+  printf("%-5s %10.1f us per load  %7ld bytes  %8.1f ms on a %.0f B/s card\n", "text", text_us, text_bytes,
+         text_bytes * 1e3 / card_rate, card_rate);
+  printf("%-5s %10.1f us per load  %7ld bytes  %8.1f ms on a %.0f B/s card\n", "bank", bank_us, bank_bytes,
+         bank_bytes * 1e3 / card_rate, card_rate);
+  printf("host parse speedup %.0fx, %.1fx fewer bytes\n", text_us / bank_us, (double)text_bytes / bank_bytes);
+  return 0;
+}
@@ -0,0 +1,222 @@
+// envelope_test - stage timing tests and per-sample cost of Envelope
+//
+// For a range of attack, decay and release times at AUDIO_SAMPLE_RATE,
+// steps an Envelope one sample at a time and checks that:
+//   - each stage lasts its time in samples, to within one sample plus what
+//     rounding the increment to a whole position step adds over the stage
+//     (n^2 / 2^(ENV_SEGMENT_BITS + 1) for n samples, 116 at 10 s)
+//   - the attack rises and ends at ENV_LEVEL_MAX, the decay falls to the
+//     sustain level, and the release falls to 0 and goes idle
+//   - advance() over a block ends at the same level as next() over the
+//     same samples, to within ENV_BLOCK_TOLERANCE
+//   - a note-on during the release starts the attack from the level
+//     reached, without a jump
+//   - zero times finish their stage in one sample
+// Prints one line per case and exits 1 if any check fails.
+//
+// --bench times next() per sample and advance() per block over many
+// retriggered notes and prints the cost per sample of each.
+//
+// Build and run from the repository root:
+//   g++ -O2 -std=gnu++11 -I. -o envelope_test tools/envelope_test.cpp envelope.cpp
+//   ./envelope_test [--bench]
+
+#include "envelope.h"
+#include "oscillator.h"
+#include "blockRenderer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#define ENV_BLOCK_TOLERANCE 2   // Level difference allowed between advance() and next()
+
+static int failures = 0;
+
+static void check(bool ok, const char *what, long got, long want) {
+  if (!ok) {
+    printf("    FAIL %s: got %ld, expected %ld\n", what, got, want);
+    failures++;
+  }
+}
+
+static long samples_for(int ms) {
+  return (long)ms * AUDIO_SAMPLE_RATE / 1000;
+}
+
+// Samples a stage of n samples may be off by
+static long tolerance(long n) {
+  return 1 + (long)(((uint64_t)n * n + (2ULL << ENV_SEGMENT_BITS) - 1) >> (ENV_SEGMENT_BITS + 1));
+}
+
+// Step one sample at a time while the stage lasts; returns the samples it took
+static long run_stage(Envelope &env, int stage, bool rising, bool *monotonic) {
+  long n = 0;
+  uint16_t prev = env.getLevel();
+  *monotonic = true;
+  while (env.getStage() == stage && n < 100L * (long)AUDIO_SAMPLE_RATE) {
+    uint16_t l = env.next();
+    if (env.getStage() == stage && (rising ? l < prev : l > prev)) {
+      *monotonic = false;
+    }
+    prev = l;
+    n++;
+  }
+  return n;
+}
+
+static void test_timing(int attack_ms, int decay_ms, uint16_t sustain, int release_ms) {
+  EnvelopeParams p;
+  envelope_set_params(&p, attack_ms, decay_ms, sustain, release_ms, AUDIO_SAMPLE_RATE);
+  Envelope env;
+  env.setParams(&p);
+  bool monotonic;
+  int before = failures;
+
+  env.noteOn();
+  long a = run_stage(env, ENV_ATTACK, true, &monotonic);
+  long want = samples_for(attack_ms) > 1 ? samples_for(attack_ms) : 1;
+  check(labs(a - want) <= tolerance(want), "attack samples", a, want);
+  check(monotonic, "attack rises", 0, 1);
+  if (env.getStage() == ENV_DECAY || decay_ms == 0) {
+    check(env.getStage() != ENV_ATTACK, "attack ends", env.getStage(), ENV_DECAY);
+  }
+
+  long d = run_stage(env, ENV_DECAY, false, &monotonic);
+  want = samples_for(decay_ms) > 1 ? samples_for(decay_ms) : 1;
+  // a zero-length attack can run into the decay within the same sample
+  check(labs(d - want) <= tolerance(want) || (attack_ms == 0 && d == 0), "decay samples", d, want);
+  check(monotonic, "decay falls", 0, 1);
+  check(env.getStage() == ENV_SUSTAIN, "sustain reached", env.getStage(), ENV_SUSTAIN);
+  check(env.next() == sustain, "sustain level", env.getLevel(), sustain);
+
+  env.noteOff();
+  long r = run_stage(env, ENV_RELEASE, false, &monotonic);
+  want = samples_for(release_ms) > 1 ? samples_for(release_ms) : 1;
+  check(labs(r - want) <= tolerance(want), "release samples", r, want);
+  check(monotonic, "release falls", 0, 1);
+  check(!env.isActive() && env.getLevel() == 0, "idle at 0", env.getLevel(), 0);
+
+  printf("%-4s A %5d ms %7ld  D %5d ms %7ld  S %5u  R %5d ms %7ld samples\n", failures == before ? "ok" : "FAIL",
+         attack_ms, a, decay_ms, d, sustain, release_ms, r);
+}
+
+// advance(AUDIO_BLOCK_SIZE) against AUDIO_BLOCK_SIZE calls of next()
+static void test_blocks(int attack_ms, int decay_ms, uint16_t sustain, int release_ms) {
+  EnvelopeParams p;
+  envelope_set_params(&p, attack_ms, decay_ms, sustain, release_ms, AUDIO_SAMPLE_RATE);
+  Envelope by_sample, by_block;
+  by_sample.setParams(&p);
+  by_block.setParams(&p);
+  by_sample.noteOn();
+  by_block.noteOn();
+
+  long blocks = (samples_for(attack_ms + decay_ms + release_ms) + AUDIO_BLOCK_SIZE) / AUDIO_BLOCK_SIZE + 4;
+  long off_block = samples_for(attack_ms + decay_ms) / AUDIO_BLOCK_SIZE + 2;
+  int worst = 0;
+  for (long b = 0; b < blocks; b++) {
+    if (b == off_block) {
+      by_sample.noteOff();
+      by_block.noteOff();
+    }
+    uint16_t ls = 0;
+    for (int i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+      ls = by_sample.next();
+    }
+    uint16_t lb = by_block.advance(AUDIO_BLOCK_SIZE);
+    int d = abs((int)ls - (int)lb);
+    worst = d > worst ? d : worst;
+  }
+  int before = failures;
+  check(worst <= ENV_BLOCK_TOLERANCE, "block vs sample level", worst, ENV_BLOCK_TOLERANCE);
+  check(!by_block.isActive(), "block envelope idle", by_block.getStage(), ENV_IDLE);
+  printf("%-4s blocks of %d, A %d D %d R %d ms: largest difference %d\n", failures == before ? "ok" : "FAIL",
+         AUDIO_BLOCK_SIZE, attack_ms, decay_ms, release_ms, worst);
+}
+
+static void test_retrigger() {
+  EnvelopeParams p;
+  envelope_set_params(&p, 50, 100, 40000, 500, AUDIO_SAMPLE_RATE);
+  Envelope env;
+  env.setParams(&p);
+  env.noteOn();
+  env.advance(samples_for(300));
+  env.noteOff();
+  env.advance(samples_for(100));
+  uint16_t released = env.getLevel();
+  env.noteOn();
+  uint16_t first = env.next();
+
+  int before = failures;
+  check(env.getStage() == ENV_ATTACK, "retrigger stage", env.getStage(), ENV_ATTACK);
+  check(first >= released && first - released < 200, "retrigger starts from level", first, released);
+  printf("%-4s retrigger during release at level %u, next sample %u\n", failures == before ? "ok" : "FAIL",
+         released, first);
+}
+
+static void bench() {
+  EnvelopeParams p;
+  envelope_set_params(&p, 100, 200, 32768, 1000, AUDIO_SAMPLE_RATE);
+  const long samples = 100000000L;
+  const long note = samples_for(1000);
+  volatile uint32_t sink = 0;
+
+  Envelope env;
+  env.setParams(&p);
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  for (long i = 0; i < samples; i++) {
+    if (i % note == 0) {
+      env.noteOn();
+    } else if (i % note == note / 2) {
+      env.noteOff();
+    }
+    sink += env.next();
+  }
+  std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+  for (long i = 0; i < samples; i += AUDIO_BLOCK_SIZE) {
+    if (i % note < AUDIO_BLOCK_SIZE) {
+      env.noteOn();
+    } else if ((i + note / 2) % note < AUDIO_BLOCK_SIZE) {
+      env.noteOff();
+    }
+    sink += env.advance(AUDIO_BLOCK_SIZE);
+  }
+  std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+
+  double per_sample = std::chrono::duration<double>(t1 - t0).count() * 1e9 / samples;
+  double per_block = std::chrono::duration<double>(t2 - t1).count() * 1e9 / samples;
+  char name[32];
+  snprintf(name, sizeof(name), "advance(%d)", AUDIO_BLOCK_SIZE);
+  printf("%-14s %8.3f ns/sample\n", "next()", per_sample);
+  printf("%-14s %8.3f ns/sample\n", name, per_block);
+}
+
+int main(int argc, char **argv) {
+  if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+    bench();
+    return 0;
+  }
+  if (argc > 1) {
+    fprintf(stderr, "usage: %s [--bench]\n", argv[0]);
+    return 2;
+  }
+
+  static const int times[] = {0, 1, 5, 20, 100, 500, 2000, 10000};
+  static const uint16_t sustains[] = {0, 20000, ENV_LEVEL_MAX};
+  for (unsigned t = 0; t < sizeof(times) / sizeof(times[0]); t++) {
+    for (unsigned s = 0; s < sizeof(sustains) / sizeof(sustains[0]); s++) {
+      test_timing(times[t], times[(t + 3) % 8], sustains[s], times[(t + 5) % 8]);
+    }
+  }
+  test_blocks(10, 50, 30000, 200);
+  test_blocks(3, 7, 50000, 1);
+  test_blocks(1000, 2000, 10000, 3000);
+  test_retrigger();
+
+  if (failures) {
+    printf("%d checks failed\n", failures);
+    return 1;
+  }
+  printf("all checks passed\n");
+  return 0;
+}
@@ -0,0 +1,158 @@
+// fft_bench - inverse FFT synthesis of the wavetables against the direct sum
+//
+// For the square and saw amplitudes makeSquare() and makeSaw() use, at every
+// table size from 32 to 2048 samples, times additive_synthesis() (Ns *
+// n_terms calls to sin()) and fft_synthesis() (one inverse FFT) and prints
+// the largest and RMS difference of the normalized tables. Then checks that
+// the two agree within FFT_TOLERANCE for:
+//   - the square and saw above
+//   - random amplitudes with a random phase per harmonic
+//   - more than Ns / 2 harmonics, which fold back, with and without phases
+// The phase cases are compared with the direct sum written out with a phase
+// term, as additive_synthesis() has none. Prints one line per check and
+// exits 1 if any fails.
+//
+// Build and run from the repository root:
+//   g++ -O2 -std=gnu++11 -I. -o fft_bench tools/fft_bench.cpp
+//   ./fft_bench
+
+#include "waveforms/additiveSynthesis.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+
+#define MIN_BITS 5
+#define MAX_BITS 11
+#define FFT_TOLERANCE 1e-9          // on tables normalized to 0 - 1
+#define TIME_SECONDS 0.05           // least time each path is run for
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+  printf("%-4s %s\n", ok ? "ok" : "FAIL", what);
+  if (!ok) {
+    failures++;
+  }
+}
+
+// additive_synthesis() with harmonic k + 1 shifted by phase[k]
+static void direct_sum(int Ns, int n_terms, std::vector<double> &xx, std::vector<double> &a,
+                       std::vector<double> &phase) {
+  for (int k = 0; k < n_terms; k++) {
+    for (int i = 0; i < Ns; i++) {
+      xx[i] = xx[i] + a[k] * sin(2 * PI * (k + 1) * i / Ns + phase[k]);
+    }
+  }
+  normalize_waveform(xx);
+}
+
+static double max_diff(const std::vector<double> &x, const std::vector<double> &y, double *rms) {
+  double worst = 0, sum = 0;
+  for (size_t i = 0; i < x.size(); i++) {
+    double d = fabs(x[i] - y[i]);
+    worst = d > worst ? d : worst;
+    sum += d * d;
+  }
+  if (rms != NULL) {
+    *rms = sqrt(sum / x.size());
+  }
+  return worst;
+}
+
+// ms per call of f, run until TIME_SECONDS have passed
+template <typename F>
+static double time_ms(F f) {
+  long calls = 0;
+  double elapsed = 0;
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  do {
+    f();
+    calls++;
+    elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  } while (elapsed < TIME_SECONDS);
+  return elapsed * 1e3 / calls;
+}
+
+// Worst difference of the two paths over every size, for random amplitudes
+// of n_terms(Ns) harmonics, with random phases if phased
+static double random_spectra(int (*n_terms)(int), bool phased) {
+  double worst = 0;
+  for (int bits = MIN_BITS; bits <= MAX_BITS; bits++) {
+    int Ns = 1 << bits;
+    int n = n_terms(Ns);
+    std::vector<double> a(n), phase(n, 0.0);
+    for (int k = 0; k < n; k++) {
+      a[k] = (double)rand() / RAND_MAX - 0.5;
+      if (phased) {
+        phase[k] = 2 * PI * rand() / RAND_MAX;
+      }
+    }
+    std::vector<double> direct(Ns, 0.0), fast(Ns, 0.0);
+    direct_sum(Ns, n, direct, a, phase);
+    fft_synthesis(Ns, n, fast, a, phased ? &phase : NULL);
+    double d = max_diff(direct, fast, NULL);
+    worst = d > worst ? d : worst;
+  }
+  return worst;
+}
+
+static int half(int Ns) { return Ns / 2; }
+static int folded(int Ns) { return 2 * Ns + 5; }   // past Ns / 2, Ns and 3 Ns / 2
+
+int main() {
+  static const char *names[2] = {"square", "saw"};
+  double worst = 0;
+  volatile double sink = 0;
+
+  printf("%-7s %5s %11s %11s %8s %10s %10s\n", "wave", "Ns", "direct ms", "fft ms", "speedup", "max diff",
+         "rms diff");
+  for (int w = 0; w < 2; w++) {
+    for (int bits = MIN_BITS; bits <= MAX_BITS; bits++) {
+      int Ns = 1 << bits;
+      int n = Ns / 2;
+      std::vector<double> a(n, 0.0);
+      for (int k = 0; k < n; k++) {
+        a[k] = w == 0 ? ((k + 1) % 2) / (double(k) + 1) : 1 / (double(k) + 1);
+      }
+
+      std::vector<double> direct(Ns, 0.0), fast(Ns, 0.0);
+      additive_synthesis(Ns, n, direct, a);
+      fft_synthesis(Ns, n, fast, a);
+      double rms;
+      double d = max_diff(direct, fast, &rms);
+      worst = d > worst ? d : worst;
+
+      double direct_ms = time_ms([&]() {
+        std::vector<double> xx(Ns, 0.0);
+        additive_synthesis(Ns, n, xx, a);
+        sink = sink + xx[1];
+      });
+      double fft_ms = time_ms([&]() {
+        std::vector<double> xx(Ns, 0.0);
+        fft_synthesis(Ns, n, xx, a);
+        sink = sink + xx[1];
+      });
+      printf("%-7s %5d %11.4f %11.4f %7.0fx %10.2e %10.2e\n", names[w], Ns, direct_ms, fft_ms,
+             direct_ms / fft_ms, d, rms);
+    }
+  }
+  printf("\n");
+
+  srand(1);
+  check(worst < FFT_TOLERANCE, "square and saw match the direct sum");
+  double phased = random_spectra(half, true);
+  printf("     random phases: max diff %.2e\n", phased);
+  check(phased < FFT_TOLERANCE, "random amplitudes and phases match the direct sum");
+  double fold = random_spectra(folded, false);
+  double fold_phased = random_spectra(folded, true);
+  printf("     2 Ns + 5 harmonics: max diff %.2e, with phases %.2e\n", fold, fold_phased);
+  check(fold < FFT_TOLERANCE && fold_phased < FFT_TOLERANCE, "harmonics above Ns / 2 fold back as in the direct sum");
+
+  if (failures) {
+    printf("%d checks failed\n", failures);
+    return 1;
+  }
+  printf("all checks passed\n");
+  return 0;
+}
@@ -0,0 +1,154 @@
+// gen_wavetables - generate the built-in wavetables compiled into the synth
+//
+// Runs makeSine/makeSquare/makeSaw from waveforms/additiveSynthesis.h for
+// every mip level, cuts the levels past the smallest table size down to the
+// harmonics they may hold, converts the samples to DAC codes and prints a
+// C++ source file defining builtin_wavetables (declared in wavetable.h). The
+// array is const, so it is placed in flash and nothing has to be computed or
+// read from the SD card at startup.
+//
+// Regenerate wavetableData.cpp from the repository root with:
+//   g++ -O2 -std=gnu++11 -I. -o gen_wavetables tools/gen_wavetables.cpp wavetable.cpp
+//   ./gen_wavetables > wavetableData.cpp
+//
+// --check compares the tables compiled into wavetableData.cpp with the ones
+// generated now and exits non-zero if any DAC code is more than
+// CHECK_TOLERANCE apart (libm may round differently between hosts) or the
+// layout does not match. It needs the compiled tables linked in:
+//   g++ -O2 -std=gnu++11 -I. -DWAVETABLE_CHECK -o gen_wavetables tools/gen_wavetables.cpp
+//       wavetable.cpp wavetableData.cpp
+//   ./gen_wavetables --check
+
+#include "wavetable.h"
+#include "waveforms/additiveSynthesis.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CHECK_TOLERANCE 1
+
+static const char *names[BUILTIN_WAVEFORMS] = {"sine", "square", "saw"};
+
+static std::vector<double> make_waveform(int waveform, int size) {
+  switch (waveform) {
+    case 0:
+      return makeSine(size);
+    case 1:
+      return makeSquare(size);
+    default:
+      return makeSaw(size);
+  }
+}
+
+// DAC codes of one mip level of a waveform
+static std::vector<uint16_t> make_level(int waveform, int level) {
+  int size = mip_size(level);
+  std::vector<double> vals = make_waveform(waveform, size);
+  if (mip_harmonics(level) < size / 2) {
+    band_limit_waveform(vals, mip_harmonics(level));
+  }
+
+  std::vector<uint16_t> codes(size);
+  for (int i = 0; i < size; i++) {
+    codes[i] = dac_code(vals[i]);
+  }
+  return codes;
+}
+
+static void print_tables() {
+  printf("// Generated by tools/gen_wavetables.cpp - do not edit\n");
+  printf("// Band-limited mip sets (%d down to %d samples, up to harmonic %d down to %d) as DAC codes\n\n",
+         mip_size(0), mip_size(MIP_LEVELS - 1), mip_harmonics(0), mip_harmonics(MIP_LEVELS - 1));
+  printf("#include \"wavetable.h\"\n\n");
+  printf("const uint16_t builtin_wavetables[BUILTIN_WAVEFORMS][MIP_TOTAL_SAMPLES] = {\n");
+
+  for (int w = 0; w < BUILTIN_WAVEFORMS; w++) {
+    printf("  // %s\n  {\n", names[w]);
+    for (int level = 0; level < MIP_LEVELS; level++) {
+      int size = mip_size(level);
+      std::vector<uint16_t> codes = make_level(w, level);
+
+      printf("    // %d samples, harmonics 1 - %d\n", size, mip_harmonics(level));
+      for (int i = 0; i < size; i++) {
+        if (i % 16 == 0) {
+          printf("    ");
+        }
+        bool last = (level == MIP_LEVELS - 1) && (i == size - 1);
+        printf("%u%s", codes[i], last ? "" : ",");
+        if (i % 16 == 15 || i == size - 1) {
+          printf("\n");
+        } else {
+          printf(" ");
+        }
+      }
+    }
+    printf("  }%s\n", w == BUILTIN_WAVEFORMS - 1 ? "" : ",");
+  }
+
+  printf("};\n");
+}
+
+#ifdef WAVETABLE_CHECK
+// Compare builtin_wavetables with freshly generated tables level by level
+static int check_tables() {
+  int bad_levels = 0;
+  for (int w = 0; w < BUILTIN_WAVEFORMS; w++) {
+    for (int level = 0; level < MIP_LEVELS; level++) {
+      std::vector<uint16_t> codes = make_level(w, level);
+      const uint16_t *table = builtin_wavetables[w] + mip_offset(level);
+      int worst = 0, worst_at = 0;
+      for (int i = 0; i < (int)codes.size(); i++) {
+        int d = abs((int)table[i] - (int)codes[i]);
+        if (d > worst) {
+          worst = d;
+          worst_at = i;
+        }
+      }
+      if (worst > CHECK_TOLERANCE) {
+        printf("%s level %d (%d samples): sample %d is %u, generated %u\n", names[w], level,
+               (int)codes.size(), worst_at, table[worst_at], codes[worst_at]);
+        bad_levels++;
+      }
+    }
+  }
+
+  // A layout change leaves zeros after the last level of a stale file
+  for (int w = 0; w < BUILTIN_WAVEFORMS; w++) {
+    const uint16_t *last = builtin_wavetables[w] + mip_offset(MIP_LEVELS - 1);
+    bool empty = true;
+    for (int i = 0; i < mip_size(MIP_LEVELS - 1); i++) {
+      empty = empty && last[i] == 0;
+    }
+    if (empty) {
+      printf("%s: last level is empty, wavetableData.cpp is for another mip layout\n", names[w]);
+      bad_levels++;
+    }
+  }
+
+  if (bad_levels) {
+    printf("%d mip levels differ, regenerate wavetableData.cpp\n", bad_levels);
+    return 1;
+  }
+  printf("builtin_wavetables match (%d waveforms, %d levels, tolerance %d)\n", BUILTIN_WAVEFORMS, MIP_LEVELS,
+         CHECK_TOLERANCE);
+  return 0;
+}
+#endif
+
+int main(int argc, char **argv) {
+  if (argc > 1 && strcmp(argv[1], "--check") == 0) {
+#ifdef WAVETABLE_CHECK
+    return check_tables();
+#else
+    fprintf(stderr, "built without -DWAVETABLE_CHECK and wavetableData.cpp\n");
+    return 2;
+#endif
+  }
+  if (argc > 1) {
+    fprintf(stderr, "usage: %s [--check]\n", argv[0]);
+    return 2;
+  }
+
+  print_tables();
+  return 0;
+}
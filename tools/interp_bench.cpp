@@ -0,0 +1,186 @@
+// interp_bench - interpolated playback against the old truncated lookup
+//
+// SNR: plays a sine at a range of notes three ways and fits a sine to each
+// output to split it into signal and error (table and interpolation error,
+// aliasing):
+//   old path      - truncated lookup, the top bits of the phase index the
+//                   old mip chain of 2048 down to 32 samples (makeSine() as
+//                   DAC codes, picked by the old level rule)
+//   truncated     - the same lookup on the mip level VoicePool now picks
+//                   from builtin_wavetables, largest 512 samples
+//   interpolated  - the new path, wt_lerp() between neighbouring samples of
+//                   that level
+// Samples are compared before the voice mix scaling, so all three have the
+// DAC's full range. Exits 1 if the interpolated path is worse than the old
+// one at any note.
+//
+// Cost: ns per sample of both lookups on their own, and of VoicePool::mix()
+// with N_VOICES voices playing one waveform and crossfading between two.
+//
+// Build and run from the repository root:
+//   g++ -O2 -std=gnu++11 -I. -o interp_bench tools/interp_bench.cpp voicePool.cpp envelope.cpp
+//       oscillator.cpp wavetable.cpp wavetableData.cpp
+//   ./interp_bench
+
+#include "voicePool.h"
+#include "oscillator.h"
+#include "wavetable.h"
+#include "waveforms/additiveSynthesis.h"
+#include <math.h>
+#include <stdio.h>
+#include <chrono>
+#include <vector>
+
+#define SNR_SAMPLES 65536
+#define OLD_MAX_BITS 11          // log2 of the largest table of the old mip chain
+#define BENCH_SAMPLES 20000000L
+
+static uint16_t old_tables[OLD_MAX_BITS + 1][1 << OLD_MAX_BITS];
+
+static uint32_t note_increment(int note) {
+  return phase_increment(440.0 * pow(2.0, (note - 69) / 12.0), AUDIO_SAMPLE_RATE);
+}
+
+static void truncated(const uint16_t *table, int bits, uint32_t inc, std::vector<double> &out) {
+  uint32_t phase = 0;
+  for (size_t i = 0; i < out.size(); i++) {
+    out[i] = table[phase >> (32 - bits)];
+    phase += inc;
+  }
+}
+
+// The old mip_level_for_increment(), as log2 of the table size
+static int old_bits_for_increment(uint32_t inc) {
+  int bits = inc ? __builtin_clz(inc) : OLD_MAX_BITS;
+  return bits > OLD_MAX_BITS ? OLD_MAX_BITS : (bits < MIP_MIN_BITS ? MIP_MIN_BITS : bits);
+}
+
+// The lookup of mix_voice() in voicePool.cpp, without the level and mix scaling
+static void interpolated(uint32_t inc, std::vector<double> &out) {
+  int level = mip_level_for_increment(inc);
+  const uint16_t *table = builtin_wavetables[0] + mip_offset(level);
+  int shift = 32 - mip_bits(level);
+  uint32_t mask = 0xFFFFFFFFUL >> shift;
+  uint32_t phase = 0;
+  for (size_t i = 0; i < out.size(); i++) {
+    uint32_t idx = phase >> shift;
+    int32_t frac = (phase >> (shift - 15)) & 0x7FFF;
+    int32_t a0 = table[idx];
+    out[i] = wt_lerp(a0, (int32_t)table[(idx + 1) & mask] - a0, frac);
+    phase += inc;
+  }
+}
+
+// Fit a sin + b cos + c at the played frequency; the rest is error
+static double snr(const std::vector<double> &y, uint32_t inc) {
+  double w = 2 * PI * inc / 4294967296.0;
+  double s[3][3] = {{0}}, r[3] = {0};
+  for (size_t i = 0; i < y.size(); i++) {
+    double f[3] = {sin(w * i), cos(w * i), 1};
+    for (int a = 0; a < 3; a++) {
+      r[a] += f[a] * y[i];
+      for (int b = 0; b < 3; b++) {
+        s[a][b] += f[a] * f[b];
+      }
+    }
+  }
+  for (int c = 0; c < 3; c++) {
+    for (int row = c + 1; row < 3; row++) {
+      double m = s[row][c] / s[c][c];
+      for (int j = 0; j < 3; j++) {
+        s[row][j] -= m * s[c][j];
+      }
+      r[row] -= m * r[c];
+    }
+  }
+  double x[3];
+  for (int row = 2; row >= 0; row--) {
+    double v = r[row];
+    for (int j = row + 1; j < 3; j++) {
+      v -= s[row][j] * x[j];
+    }
+    x[row] = v / s[row][row];
+  }
+
+  double signal = 0, error = 0;
+  for (size_t i = 0; i < y.size(); i++) {
+    double fit = x[0] * sin(w * i) + x[1] * cos(w * i);
+    double e = y[i] - x[2] - fit;
+    signal += fit * fit;
+    error += e * e;
+  }
+  return 10 * log10(signal / error);
+}
+
+static double time_mix(uint16_t morph) {
+  const uint16_t *tables[BUILTIN_WAVEFORMS];
+  for (int w = 0; w < BUILTIN_WAVEFORMS; w++) {
+    tables[w] = builtin_wavetables[w];
+  }
+  VoicePool pool;
+  pool.setWavetables(tables, BUILTIN_WAVEFORMS);
+  pool.setMorph(morph);
+  for (int v = 0; v < N_VOICES; v++) {
+    pool.noteOn(36 + 7 * v, note_increment(36 + 7 * v));
+  }
+
+  uint16_t out[VOICE_MIX_CHUNK];
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  for (long i = 0; i < BENCH_SAMPLES; i += VOICE_MIX_CHUNK) {
+    pool.mix(out, VOICE_MIX_CHUNK);
+  }
+  std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(t1 - t0).count() * 1e9 / BENCH_SAMPLES;
+}
+
+template <typename F>
+static double time_lookup(F f) {
+  std::vector<double> out(BENCH_SAMPLES / 10);
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  f(out);
+  std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+  volatile double sink = out[out.size() / 2];
+  (void)sink;
+  return std::chrono::duration<double>(t1 - t0).count() * 1e9 / out.size();
+}
+
+int main() {
+  for (int bits = MIP_MIN_BITS; bits <= OLD_MAX_BITS; bits++) {
+    load_dac_codes(old_tables[bits], makeSine(1 << bits), 1 << bits);
+  }
+
+  static const int notes[] = {24, 36, 48, 60, 69, 84, 96, 108, 120};
+  std::vector<double> out(SNR_SAMPLES);
+  bool worse = false;
+  printf("%-5s %14s %14s %14s\n", "note", "old path", "truncated", "interpolated");
+  for (unsigned k = 0; k < sizeof(notes) / sizeof(notes[0]); k++) {
+    uint32_t inc = note_increment(notes[k]);
+    int old_bits = old_bits_for_increment(inc);
+    truncated(old_tables[old_bits], old_bits, inc, out);
+    double old_snr = snr(out, inc);
+    int level = mip_level_for_increment(inc);
+    truncated(builtin_wavetables[0] + mip_offset(level), mip_bits(level), inc, out);
+    double small_snr = snr(out, inc);
+    interpolated(inc, out);
+    double new_snr = snr(out, inc);
+    printf("%-5d %11.1f dB %11.1f dB %11.1f dB\n", notes[k], old_snr, small_snr, new_snr);
+    worse = worse || new_snr < old_snr;
+  }
+  printf("bytes per waveform: old %d, new %d\n\n", (int)(((2 << OLD_MAX_BITS) - (1 << MIP_MIN_BITS)) * sizeof(uint16_t)),
+         (int)(MIP_TOTAL_SAMPLES * sizeof(uint16_t)));
+
+  uint32_t inc = note_increment(60);
+  printf("%-34s %8.2f ns/sample\n", "truncated lookup",
+         time_lookup([&](std::vector<double> &o) { truncated(old_tables[OLD_MAX_BITS], OLD_MAX_BITS, inc, o); }));
+  printf("%-34s %8.2f ns/sample\n", "interpolated lookup",
+         time_lookup([&](std::vector<double> &o) { interpolated(inc, o); }));
+  printf("VoicePool::mix, %d voices, one table %6.2f ns/sample\n", N_VOICES, time_mix(1 << VOICE_MORPH_BITS));
+  printf("VoicePool::mix, %d voices, crossfade %6.2f ns/sample\n", N_VOICES,
+         time_mix((1 << VOICE_MORPH_BITS) + (1 << (VOICE_MORPH_BITS - 1))));
+
+  if (worse) {
+    printf("interpolated playback is below the old path at some notes\n");
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,80 @@
+// kernel_bench - old and new per-sample wavetable kernels on the host
+//
+// The old noteISR read a double table and scaled it to a DAC code on every
+// sample (wavetable[w][downsample * counter] * (pow(2,11) - 1), then the
+// modulo step of counter). The new one reads a uint16_t DAC code that was
+// converted once at startup. Both kernels write to a volatile sink, like the
+// DAC register, over the same table size and are timed separately; the
+// codes they produce are compared and the table memory of each is printed.
+// A host has a double precision FPU, so the gap here is far smaller than on
+// the Cortex-M4F, where the old multiply is a software double routine.
+//
+// Build and run from the repository root:
+//   g++ -O2 -std=gnu++11 -I. -o kernel_bench tools/kernel_bench.cpp wavetable.cpp
+//   ./kernel_bench [samples]
+
+#include "wavetable.h"
+#include "waveforms/additiveSynthesis.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+
+#define OLD_N_WAVEFORMS 3
+#define OLD_N_SAMPLES 2048
+
+static double old_table[OLD_N_WAVEFORMS][OLD_N_SAMPLES];
+static uint16_t new_table[OLD_N_WAVEFORMS][OLD_N_SAMPLES];
+static volatile uint16_t dac;
+
+int main(int argc, char **argv) {
+  long samples = argc > 1 ? atol(argv[1]) : 100000000L;
+  if (samples <= 0) {
+    fprintf(stderr, "usage: %s [samples]\n", argv[0]);
+    return 1;
+  }
+
+  std::vector<double> vals[OLD_N_WAVEFORMS] = {makeSine(OLD_N_SAMPLES), makeSquare(OLD_N_SAMPLES),
+                                               makeSaw(OLD_N_SAMPLES)};
+  for (int w = 0; w < OLD_N_WAVEFORMS; w++) {
+    for (int i = 0; i < OLD_N_SAMPLES; i++) {
+      old_table[w][i] = vals[w][i];
+    }
+    load_dac_codes(new_table[w], vals[w], OLD_N_SAMPLES);
+  }
+
+  // Same codes from both, apart from rounding: the old kernel truncated
+  int worst = 0;
+  for (int w = 0; w < OLD_N_WAVEFORMS; w++) {
+    for (int i = 0; i < OLD_N_SAMPLES; i++) {
+      int d = abs((int)(uint16_t)(old_table[w][i] * (pow(2, 11) - 1)) - new_table[w][i]);
+      worst = d > worst ? d : worst;
+    }
+  }
+
+  int waveform = 2;
+  int downsample = 1;
+  int counter = 0;
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  for (long i = 0; i < samples; i++) {
+    dac = old_table[waveform][downsample * counter] * (pow(2, 11) - 1);
+    counter = (counter + 1) % (OLD_N_SAMPLES / downsample);
+  }
+  std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+
+  uint32_t index = 0;
+  for (long i = 0; i < samples; i++) {
+    dac = new_table[waveform][index];
+    index = (index + 1) & (OLD_N_SAMPLES - 1);
+  }
+  std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+
+  double old_ns = std::chrono::duration<double>(t1 - t0).count() * 1e9 / samples;
+  double new_ns = std::chrono::duration<double>(t2 - t1).count() * 1e9 / samples;
+  printf("%-28s %8.2f ns/sample  table %6lu bytes\n", "double * (pow(2,11) - 1)", old_ns,
+         (unsigned long)sizeof(old_table));
+  printf("%-28s %8.2f ns/sample  table %6lu bytes\n", "uint16_t DAC code", new_ns,
+         (unsigned long)sizeof(new_table));
+  printf("speedup %.1fx, largest code difference %d\n", old_ns / new_ns, worst);
+  return 0;
+}
@@ -0,0 +1,126 @@
+// knob_test - KnobFilter smoothing, hysteresis and change detection
+//
+// Feeds KnobFilters from the LinuxAdc mock, with the six knobs set to fixed
+// positions plus a seeded random noise of a few LSBs, and checks that:
+//   - the first scan publishes every knob
+//   - noise within the hysteresis band publishes nothing
+//   - a step settles within the hysteresis band of the new position in
+//     KNOB_SETTLE_SCANS scans, publishing rising values only, and no more
+//     of them than steps of more than the band fit in the move
+//   - both ends of the range are reached exactly
+//   - readings above the range are clamped
+//   - only the knobs that moved are in the change mask
+// Prints one line per check and exits 1 if any fails.
+//
+// Build and run from the repository root:
+//   g++ -O2 -std=gnu++11 -I. -o knob_test tools/knob_test.cpp knobFilter.cpp halLinux.cpp
+//   ./knob_test
+
+#include "knobFilter.h"
+#include "halLinux.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define KNOBS 6
+#define KNOB_SETTLE_SCANS 100     // Scans a full-scale step may take to settle
+
+static LinuxAdc adc;
+static KnobFilter filters[KNOBS];
+static int positions[KNOBS];
+static int noise = 0;
+static int failures = 0;
+
+// One scan of the mock ADC into the filters; returns the change mask
+static uint32_t scan() {
+  for (int k = 0; k < KNOBS; k++) {
+    int v = positions[k] + (noise ? rand() % (2 * noise + 1) - noise : 0);
+    adc.set(k, v < 0 ? 0 : (v > 4095 ? 4095 : v));
+  }
+  uint16_t raw[KNOBS];
+  adc.readAll(raw);
+  return knob_update_all(filters, raw, KNOBS);
+}
+
+static void check(bool ok, const char *what) {
+  printf("%-4s %s\n", ok ? "ok" : "FAIL", what);
+  if (!ok) {
+    failures++;
+  }
+}
+
+// Move knob 0 to target and scan until its value is within band of it.
+// Returns the scans it took, or -1 if it did not settle; counts what was
+// published.
+static int step_to(int target, int band, int *published, bool *monotonic) {
+  int from = filters[0].getValue();
+  int last = from;
+  positions[0] = target;
+  *published = 0;
+  *monotonic = true;
+  for (int n = 1; n <= KNOB_SETTLE_SCANS; n++) {
+    if (scan() & 1) {
+      int v = filters[0].getValue();
+      if ((target > from && v < last) || (target < from && v > last)) {
+        *monotonic = false;
+      }
+      last = v;
+      (*published)++;
+    }
+    if (abs(filters[0].getValue() - target) <= band) {
+      return n;
+    }
+  }
+  return -1;
+}
+
+int main() {
+  static const int pins[KNOBS] = {0, 1, 2, 3, 4, 5};
+  static const int start[KNOBS] = {512, 0, 1023, 256, 768, 100};
+  adc.begin(pins, KNOBS);
+  srand(1);
+  for (int k = 0; k < KNOBS; k++) {
+    positions[k] = start[k];
+  }
+
+  check(scan() == (1UL << KNOBS) - 1, "first scan publishes every knob");
+
+  noise = KNOB_HYSTERESIS;
+  int published = 0;
+  for (int i = 0; i < 10000; i++) {
+    published += __builtin_popcount(scan());
+  }
+  printf("     %d values published in 10000 scans of +-%d LSB noise\n", published, noise);
+  check(published == 0, "noise within the hysteresis band publishes nothing");
+
+  noise = 0;
+  bool monotonic;
+  int scans = step_to(818, KNOB_HYSTERESIS, &published, &monotonic);
+  printf("     step 512 -> 818: settled at %u in %d scans, %d values published\n", filters[0].getValue(), scans,
+         published);
+  check(scans > 0 && monotonic && published <= (818 - 512) / (KNOB_HYSTERESIS + 1),
+        "a step settles, rising, with few updates");
+
+  scans = step_to(1023, 0, &published, &monotonic);
+  check(scans > 0 && monotonic, "reaches the top of the range exactly");
+  scans = step_to(0, 0, &published, &monotonic);
+  check(scans > 0 && monotonic, "reaches the bottom of the range exactly");
+
+  KnobFilter clamp;
+  clamp.update(4095);
+  check(clamp.getValue() == 1023, "readings above the range are clamped");
+
+  positions[0] = 300;
+  positions[3] = 900;
+  uint32_t mask = 0;
+  for (int i = 0; i < KNOB_SETTLE_SCANS; i++) {
+    mask |= scan();
+  }
+  check(mask == ((1UL << 0) | (1UL << 3)), "only the knobs that moved are in the change mask");
+
+  if (failures) {
+    printf("%d checks failed\n", failures);
+    return 1;
+  }
+  printf("all checks passed\n");
+  return 0;
+}
@@ -0,0 +1,518 @@
+// midi_bench - MidiParser fuzz test and throughput
+//
+// Fuzz: builds random MIDI streams a message at a time, together with the
+// handler calls and statistics MidiParser should produce for them: channel
+// messages with and without running status, real-time bytes dropped in
+// anywhere (also inside other messages and SysEx), system common messages,
+// SysEx that ends normally, is cut short or overflows MIDI_SYSEX_SIZE, and
+// broken input - stray data bytes, undefined status bytes and messages cut
+// short by the next status. Each stream is parsed whole, and polled through
+// LinuxMidiIn in random read sizes, and both must match exactly. Streams of
+// random bytes are also parsed, checking only that every handler argument
+// is in range and that every byte is counted.
+//
+// Benchmark: parses a generated stream of controller sweeps with clock and
+// notes, and any recorded raw MIDI captures given with -f, by poll() in
+// passes of MIDI_POLL_MAX bytes as loop() does, and prints messages and
+// bytes per second against what a 31250 baud port can deliver.
+//
+// Prints one line per check and exits 1 if any fails.
+//
+// Build and run from the repository root:
+//   g++ -O2 -std=gnu++11 -I. -o midi_bench tools/midi_bench.cpp midiParser.cpp halLinux.cpp
+//   ./midi_bench [-n streams] [-s seed] [-f capture.bin]...
+
+#include "midiParser.h"
+#include "halLinux.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+#define FUZZ_MESSAGES 2000      // messages in each generated stream
+#define MIDI_POLL_MAX 128       // bytes parsed per pass of loop(), as in the sketch
+#define MIDI_WIRE_BYTES 3125    // bytes per second at 31250 baud
+
+// One handler call
+struct Event {
+  uint8_t kind;       // channel message type, 0xF0 SysEx, or the status of a system message
+  uint8_t a, b, c;
+  int length;         // SysEx bytes
+  uint32_t sum;       // SysEx contents
+  bool complete;
+
+  bool operator==(const Event &o) const {
+    return kind == o.kind && a == o.a && b == o.b && c == o.c && length == o.length && sum == o.sum &&
+           complete == o.complete;
+  }
+};
+
+static std::vector<Event> *events;
+static bool in_range = true;
+
+static Event make_event(uint8_t kind, uint8_t a, uint8_t b, uint8_t c) {
+  Event e;
+  e.kind = kind;
+  e.a = a;
+  e.b = b;
+  e.c = c;
+  e.length = 0;
+  e.sum = 0;
+  e.complete = true;
+  return e;
+}
+
+static uint32_t sysex_sum(const uint8_t *data, int n) {
+  uint32_t sum = 0;
+  for (int i = 0; i < n; i++) {
+    sum = sum * 31 + data[i];
+  }
+  return sum;
+}
+
+template <int TYPE>
+static void on_channel(uint8_t channel, uint8_t data1, uint8_t data2) {
+  in_range = in_range && channel >= 1 && channel <= 16 && data1 < 0x80 && data2 < 0x80;
+  events -> push_back(make_event(TYPE, channel, data1, data2));
+}
+
+static void on_realtime(uint8_t status) {
+  in_range = in_range && status >= 0xF8 && status != 0xF9 && status != 0xFD;
+  events -> push_back(make_event(status, 0, 0, 0));
+}
+
+static void on_common(uint8_t status, uint8_t data1, uint8_t data2) {
+  in_range = in_range && status >= 0xF1 && status <= 0xF6 && data1 < 0x80 && data2 < 0x80;
+  events -> push_back(make_event(status, data1, data2, 0));
+}
+
+static void on_sysex(const uint8_t *data, int n, bool complete) {
+  in_range = in_range && n >= 0 && n <= MIDI_SYSEX_SIZE;
+  for (int i = 0; i < n && in_range; i++) {
+    in_range = data[i] < 0x80;
+  }
+  Event e = make_event(0xF0, 0, 0, 0);
+  e.length = n;
+  e.sum = sysex_sum(data, n);
+  e.complete = complete;
+  events -> push_back(e);
+}
+
+static void set_handlers(MidiParser &p) {
+  p.setHandler(MIDI_NOTE_OFF, on_channel<MIDI_NOTE_OFF>);
+  p.setHandler(MIDI_NOTE_ON, on_channel<MIDI_NOTE_ON>);
+  p.setHandler(MIDI_POLY_PRESSURE, on_channel<MIDI_POLY_PRESSURE>);
+  p.setHandler(MIDI_CONTROL_CHANGE, on_channel<MIDI_CONTROL_CHANGE>);
+  p.setHandler(MIDI_PROGRAM_CHANGE, on_channel<MIDI_PROGRAM_CHANGE>);
+  p.setHandler(MIDI_CHANNEL_PRESSURE, on_channel<MIDI_CHANNEL_PRESSURE>);
+  p.setHandler(MIDI_PITCH_BEND, on_channel<MIDI_PITCH_BEND>);
+  p.setRealtimeHandler(on_realtime);
+  p.setCommonHandler(on_common);
+  p.setSysExHandler(on_sysex);
+}
+
+// A generated stream and what parsing it should give
+struct Stream {
+  std::vector<uint8_t> bytes;
+  std::vector<Event> events;
+  MidiParserStats stats;
+};
+
+static int rnd(int n) {
+  return rand() % n;
+}
+
+// Builds a stream while keeping track of the parser state it leaves
+class Generator {
+  public:
+    Generator(Stream *s, bool broken) {
+      this -> s = s;
+      this -> broken = broken;
+      this -> running = 0;
+      this -> cut = false;
+      this -> sysex_open = false;
+      memset(&(s -> stats), 0, sizeof(s -> stats));
+    }
+
+    void message() {
+      this -> piece.clear();
+      this -> piece_events.clear();
+      this -> piece_at.clear();
+      int r = rnd(100);
+      bool open = this -> cut || this -> sysex_open;
+      if (open) {
+        r = rnd(60);   // something that starts with a status byte
+      }
+      if (r < 40) {
+        channel(!open && rnd(4) != 0);
+      } else if (r < 48) {
+        common();
+      } else if (r < 55) {
+        sysex();
+      } else if (r < 60 && this -> broken) {
+        undefined_status();
+      } else if (r < 80) {
+        channel(false);
+      } else if (r < 90 && this -> broken && this -> running == 0) {
+        data_byte(rnd(0x80));
+        this -> s -> stats.stray_bytes++;
+      } else {
+        channel(true);
+      }
+      realtime();
+      flush();
+    }
+
+    // Tune request, so nothing is left open at the end
+    void finish() {
+      this -> piece.clear();
+      this -> piece_events.clear();
+      this -> piece_at.clear();
+      status_byte(0xF6);
+      add_event(make_event(0xF6, 0, 0, 0));
+      this -> running = 0;
+      flush();
+    }
+
+  private:
+    // An event completed by the last byte of the piece
+    void add_event(const Event &e) {
+      this -> piece_events.push_back(e);
+      this -> piece_at.push_back(this -> piece.size() - 1);
+      this -> s -> stats.messages++;
+    }
+
+    // A status byte ends an open SysEx or a message cut short
+    void status_byte(uint8_t b) {
+      this -> piece.push_back(b);
+      this -> s -> stats.bytes++;
+      if (this -> sysex_open) {
+        bool eox = b == 0xF7;
+        Event e = make_event(0xF0, 0, 0, 0);
+        int n = (int)this -> sysex_data.size() < MIDI_SYSEX_SIZE ? this -> sysex_data.size() : MIDI_SYSEX_SIZE;
+        e.length = n;
+        e.sum = sysex_sum(this -> sysex_data.data(), n);
+        e.complete = eox && (int)this -> sysex_data.size() <= MIDI_SYSEX_SIZE;
+        add_event(e);
+        if (!eox) {
+          this -> s -> stats.truncated++;
+        }
+        this -> sysex_open = false;
+      } else if (this -> cut) {
+        this -> s -> stats.truncated++;
+      }
+      this -> cut = false;
+    }
+
+    void data_byte(uint8_t b) {
+      this -> piece.push_back(b);
+      this -> s -> stats.bytes++;
+    }
+
+    void channel(bool running_ok) {
+      static const uint8_t types[] = {0x8, 0x9, 0x9, 0xA, 0xB, 0xB, 0xC, 0xD, 0xE};
+      uint8_t status = this -> running;
+      if (!running_ok || status == 0) {
+        status = (types[rnd(sizeof(types))] << 4) | rnd(16);
+        status_byte(status);
+      }
+      int type = status >> 4;
+      int needed = (type == MIDI_PROGRAM_CHANGE || type == MIDI_CHANNEL_PRESSURE) ? 1 : 2;
+      uint8_t d1 = rnd(0x80);
+      uint8_t d2 = needed > 1 ? (rnd(8) == 0 ? 0 : rnd(0x80)) : 0;
+      this -> running = status;
+
+      // cut short by the next status byte
+      if (this -> broken && needed == 2 && rnd(10) == 0) {
+        data_byte(d1);
+        this -> cut = true;
+        return;
+      }
+      data_byte(d1);
+      if (needed > 1) {
+        data_byte(d2);
+      }
+      if (type == MIDI_NOTE_ON && d2 == 0) {
+        type = MIDI_NOTE_OFF;
+      }
+      add_event(make_event(type, (status & 0x0F) + 1, d1, d2));
+    }
+
+    void common() {
+      static const uint8_t statuses[] = {0xF1, 0xF2, 0xF3, 0xF6};
+      uint8_t status = statuses[rnd(4)];
+      status_byte(status);
+      uint8_t d1 = status == 0xF6 ? 0 : rnd(0x80);
+      uint8_t d2 = status == 0xF2 ? rnd(0x80) : 0;
+      if (status != 0xF6) {
+        data_byte(d1);
+      }
+      if (status == 0xF2) {
+        data_byte(d2);
+      }
+      add_event(make_event(status, d1, d2, 0));
+      this -> running = 0;
+    }
+
+    // Ends with EOX, or is left open for the next status byte to cut short
+    void sysex() {
+      status_byte(0xF0);
+      this -> running = 0;
+      int n = rnd(4) == 0 ? rnd(2 * MIDI_SYSEX_SIZE) : rnd(MIDI_SYSEX_SIZE / 2);
+      this -> sysex_data.clear();
+      for (int i = 0; i < n; i++) {
+        this -> sysex_data.push_back(rnd(0x80));
+        data_byte(this -> sysex_data.back());
+      }
+      if (n > MIDI_SYSEX_SIZE) {
+        this -> s -> stats.sysex_overflows++;
+      }
+      this -> sysex_open = true;
+      if (!this -> broken || rnd(4) != 0) {
+        status_byte(0xF7);
+      }
+    }
+
+    // EOX outside a SysEx and the undefined 0xF4 and 0xF5 drop running status
+    void undefined_status() {
+      static const uint8_t statuses[] = {0xF4, 0xF5, 0xF7};
+      status_byte(statuses[rnd(this -> sysex_open ? 2 : 3)]);
+      this -> s -> stats.stray_bytes++;
+      this -> running = 0;
+    }
+
+    // A real-time byte somewhere in the piece; the undefined ones only count
+    // as bytes
+    void realtime() {
+      if (this -> piece.empty() || rnd(3) != 0) {
+        return;
+      }
+      static const uint8_t statuses[] = {0xF8, 0xF8, 0xF8, 0xFA, 0xFB, 0xFC, 0xFE, 0xFF, 0xF9, 0xFD};
+      uint8_t status = statuses[rnd(this -> broken ? 10 : 8)];
+      size_t at = rnd(this -> piece.size() + 1);
+      this -> piece.insert(this -> piece.begin() + at, status);
+      this -> s -> stats.bytes++;
+      if (status == 0xF9 || status == 0xFD) {
+        return;
+      }
+      // it goes before the events completed by the bytes after it
+      size_t e = 0;
+      while (e < this -> piece_at.size() && this -> piece_at[e] < at) {
+        e++;
+      }
+      this -> piece_events.insert(this -> piece_events.begin() + e, make_event(status, 0, 0, 0));
+      this -> s -> stats.messages++;
+    }
+
+    void flush() {
+      this -> s -> bytes.insert(this -> s -> bytes.end(), this -> piece.begin(), this -> piece.end());
+      this -> s -> events.insert(this -> s -> events.end(), this -> piece_events.begin(), this -> piece_events.end());
+    }
+
+    Stream *s;
+    bool broken;
+    uint8_t running;        // running status the parser holds, 0 for none
+    bool cut;               // a message is waiting for a data byte that does not come
+    bool sysex_open;        // a SysEx is waiting for EOX or another status byte
+    std::vector<uint8_t> sysex_data;
+    std::vector<uint8_t> piece;
+    std::vector<Event> piece_events;
+    std::vector<size_t> piece_at;   // byte of the piece that completes each event
+};
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+  printf("%-4s %s\n", ok ? "ok" : "FAIL", what);
+  if (!ok) {
+    failures++;
+  }
+}
+
+static bool same_stats(const MidiParserStats &a, const MidiParserStats &b) {
+  return a.messages == b.messages && a.bytes == b.bytes && a.stray_bytes == b.stray_bytes &&
+         a.truncated == b.truncated && a.sysex_overflows == b.sysex_overflows;
+}
+
+// Parse a stream whole and through the port; returns whether both match it
+static bool run_stream(const Stream &s, int seed) {
+  std::vector<Event> whole, polled;
+  MidiParserStats whole_stats, polled_stats;
+
+  MidiParser p;
+  set_handlers(p);
+  events = &whole;
+  p.parse(s.bytes.data(), s.bytes.size());
+  p.getStats(&whole_stats);
+
+  // the port gets the bytes in random bursts and is polled in random sizes
+  MidiParser q;
+  set_handlers(q);
+  events = &polled;
+  LinuxMidiIn in;
+  size_t sent = 0;
+  while (sent < s.bytes.size() || in.available() > 0) {
+    size_t n = rnd(40);
+    if (n > s.bytes.size() - sent) {
+      n = s.bytes.size() - sent;
+    }
+    in.send(s.bytes.data() + sent, n);
+    sent += n;
+    q.poll(&in, 1 + rnd(2 * MIDI_POLL_CHUNK), 0);
+  }
+  q.getStats(&polled_stats);
+
+  bool ok = whole == s.events && same_stats(whole_stats, s.stats) && polled == whole &&
+            same_stats(polled_stats, whole_stats);
+  if (!ok) {
+    size_t i = 0;
+    while (i < whole.size() && i < s.events.size() && whole[i] == s.events[i]) {
+      i++;
+    }
+    printf("     seed %d: %u events, expected %u, first difference at %u; stray %lu/%lu truncated %lu/%lu\n",
+           seed, (unsigned)whole.size(), (unsigned)s.events.size(), (unsigned)i, whole_stats.stray_bytes,
+           s.stats.stray_bytes, whole_stats.truncated, s.stats.truncated);
+  }
+  return ok;
+}
+
+static void fuzz(int streams, int seed) {
+  bool good = true, broken = true;
+  long bytes = 0;
+  for (int i = 0; i < streams; i++) {
+    for (int b = 0; b < 2; b++) {
+      srand(seed + i);
+      Stream s;
+      Generator g(&s, b != 0);
+      for (int m = 0; m < FUZZ_MESSAGES; m++) {
+        g.message();
+      }
+      g.finish();
+      bytes += s.bytes.size();
+      if (!run_stream(s, seed + i)) {
+        (b ? broken : good) = false;
+      }
+    }
+  }
+  printf("     %d streams of %d messages, %ld bytes\n", 2 * streams, FUZZ_MESSAGES, bytes);
+  check(good, "well-formed streams parse to the messages sent, whole or polled");
+  check(broken, "broken streams give the expected messages, drops and counts");
+
+  // Random bytes, a quarter of them status bytes
+  std::vector<Event> log;
+  events = &log;
+  MidiParser p;
+  set_handlers(p);
+  srand(seed);
+  std::vector<uint8_t> noise(1 << 16);
+  unsigned long total = 0;
+  in_range = true;
+  for (int i = 0; i < streams; i++) {
+    for (size_t k = 0; k < noise.size(); k++) {
+      noise[k] = rnd(4) == 0 ? 0x80 | rnd(0x80) : rnd(0x80);
+    }
+    p.parse(noise.data(), noise.size());
+    total += noise.size();
+    log.clear();
+  }
+  MidiParserStats stats;
+  p.getStats(&stats);
+  check(in_range && stats.bytes == total, "random bytes: handler arguments in range, every byte counted");
+}
+
+// Parse bytes through the port in loop() sized passes
+static void bench(const char *name, const std::vector<uint8_t> &bytes) {
+  std::vector<Event> log;
+  events = &log;
+  MidiParser p;
+  set_handlers(p);
+  LinuxMidiIn in;
+
+  int rounds = bytes.size() ? (int)(20000000UL / bytes.size()) + 1 : 0;
+  std::chrono::steady_clock::duration spent(0);
+  for (int r = 0; r < rounds; r++) {
+    in.send(bytes.data(), bytes.size());
+    log.clear();
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    while (p.poll(&in, MIDI_POLL_MAX, 0) > 0) {
+    }
+    spent += std::chrono::steady_clock::now() - t0;
+  }
+  MidiParserStats stats;
+  p.getStats(&stats);
+  double seconds = std::chrono::duration<double>(spent).count();
+  printf("%-20s %9lu bytes %8.2f M messages/s %8.2f MB/s %6.1f ns/byte, %.0fx the wire\n", name,
+         (unsigned long)bytes.size(), stats.messages / seconds / 1e6, stats.bytes / seconds / 1e6,
+         seconds * 1e9 / stats.bytes, stats.bytes / seconds / MIDI_WIRE_BYTES);
+}
+
+// Controller sweeps on two channels with MIDI clock and a note every 16
+static std::vector<uint8_t> dense_stream() {
+  std::vector<uint8_t> s;
+  for (int i = 0; i < 100000; i++) {
+    s.push_back(0xB0 | (i & 1));
+    s.push_back(1 + (i & 1));
+    s.push_back(i & 0x7F);
+    if (i % 8 == 0) {
+      s.push_back(0xF8);
+    }
+    if (i % 16 == 0) {
+      s.push_back(0x90);
+      s.push_back(36 + i % 48);
+      s.push_back(i % 32 == 0 ? 100 : 0);
+    }
+  }
+  return s;
+}
+
+static bool read_file(const char *name, std::vector<uint8_t> &bytes) {
+  FILE *f = fopen(name, "rb");
+  if (f == NULL) {
+    return false;
+  }
+  int c;
+  while ((c = fgetc(f)) != EOF) {
+    bytes.push_back(c);
+  }
+  fclose(f);
+  return true;
+}
+
+int main(int argc, char **argv) {
+  int streams = 50;
+  int seed = 1;
+  std::vector<const char *> files;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+      streams = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+      seed = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+      files.push_back(argv[++i]);
+    } else {
+      fprintf(stderr, "usage: %s [-n streams] [-s seed] [-f capture.bin]...\n", argv[0]);
+      return 2;
+    }
+  }
+
+  fuzz(streams, seed);
+  printf("\n");
+
+  bench("generated", dense_stream());
+  for (size_t i = 0; i < files.size(); i++) {
+    std::vector<uint8_t> bytes;
+    if (!read_file(files[i], bytes)) {
+      fprintf(stderr, "can't read %s\n", files[i]);
+      return 2;
+    }
+    bench(files[i], bytes);
+  }
+
+  if (failures) {
+    printf("%d checks failed\n", failures);
+    return 1;
+  }
+  printf("all checks passed\n");
+  return 0;
+}
@@ -0,0 +1,325 @@
+// onset_test - MIDI arrival times and note onsets through MidiParser
+//
+// Bytes reach a LinuxMidiIn at 31250 baud on the virtual clock while the
+// audio interrupt renders blocks and stamps the port as the sketch does, and
+// loop() polls the parser between interrupts except while it is stalled.
+// Each byte's true arrival is the sample the DAC was playing when it came
+// in. Checks that:
+//   - with no stalls every note message is dated exactly
+//   - with stalls of up to MIDI_STAMPS - 2 blocks, messages are never dated
+//     early and at most AUDIO_BLOCK_SIZE samples late
+//   - with longer stalls they are still never dated early
+//   - a note that arrives during a stall, which ends before the note is due,
+//     starts in the DAC output SYNTH_EVENT_LATENCY samples after the time it
+//     was given, so its onset is off by no more than its date
+// Prints one line per check and exits 1 if any fails.
+//
+// Build and run from the repository root:
+//   g++ -O2 -std=gnu++11 -I. -o onset_test tools/onset_test.cpp midiParser.cpp synth.cpp halLinux.cpp
+//       tuning.cpp envelope.cpp voicePool.cpp blockRenderer.cpp knobFilter.cpp oscillator.cpp
+//       wavetable.cpp wavetableData.cpp streamPlayer.cpp
+//   ./onset_test
+
+#include "midiParser.h"
+#include "synth.h"
+#include "halLinux.h"
+#include "oscillator.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#define MIDI_POLL_MAX 128       // bytes parsed per pass of loop(), as in the sketch
+#define MIDI_BYTE_SAMPLES (AUDIO_SAMPLE_RATE * 10 / 31250)          // samples per MIDI byte
+#define BYTE_PERIOD ((uint64_t)MIDI_BYTE_SAMPLES * AUDIO_TIMER_PERIOD) // the same in clock units
+#define BLOCK_PERIOD ((uint64_t)AUDIO_BLOCK_SIZE * AUDIO_TIMER_PERIOD)
+#define TEST_MESSAGES 5000
+
+struct WireByte {
+  uint64_t time;
+  uint8_t value;
+};
+
+// A note message as the handler saw it
+struct Dated {
+  uint32_t byte;       // number of its last byte
+  uint32_t time;       // getTime()
+};
+
+static LinuxClock sim_clock;
+static LinuxAudioOut dac_out(&sim_clock);
+static LinuxPwm pwm5(&sim_clock);
+static LinuxPwm pwm6(&sim_clock);
+static LinuxPwm pwm7(&sim_clock);
+static LinuxMidiIn midi_in;
+static uint16_t audio_buffers[2][AUDIO_BLOCK_SIZE];
+
+static Synth *synth;
+static MidiParser *midi;
+static std::vector<uint32_t> arrived;   // sample each byte arrived at
+static std::vector<Dated> dated;
+static std::vector<uint64_t> stalls;    // clock times loop() stops and starts again, in pairs
+static int failures = 0;
+
+// The UART: puts each byte into the port at its time
+class MidiWire : public LinuxDevice {
+  public:
+    MidiWire(LinuxClock *clock) {
+      clock -> attach(this);
+      this -> next = 0;
+    }
+
+    void start(const std::vector<WireByte> &bytes) {
+      this -> bytes = bytes;
+      this -> next = 0;
+      this -> running = !bytes.empty();
+      this -> next_due = this -> running ? bytes[0].time : 0;
+    }
+
+    void fire() {
+      midi_in.send(&(this -> bytes[this -> next].value), 1);
+      arrived.push_back(synth -> getSampleTime());
+      this -> next++;
+      if (this -> next < this -> bytes.size()) {
+        this -> next_due = this -> bytes[this -> next].time;
+      } else {
+        this -> running = false;
+      }
+    }
+
+  private:
+    std::vector<WireByte> bytes;
+    size_t next;
+};
+
+static MidiWire wire(&sim_clock);
+
+static uint32_t sim_micros() {
+  return sim_clock.now() / 100;
+}
+
+// audioBlockISR() of synth-control.ino
+static void audio_block(uint16_t *block, int n) {
+  synth -> render(block, n);
+  midi -> stamp(&midi_in, synth -> getSampleTime());
+}
+
+// loop() of synth-control.ino, unless it is stalled
+static void idle() {
+  uint64_t now = sim_clock.now();
+  for (size_t i = 0; i + 1 < stalls.size(); i += 2) {
+    if (now >= stalls[i] && now < stalls[i + 1]) {
+      return;
+    }
+  }
+  midi -> poll(&midi_in, MIDI_POLL_MAX, synth -> getSampleTime());
+}
+
+static void date_message() {
+  MidiParserStats stats;
+  midi -> getStats(&stats);
+  Dated d;
+  d.byte = stats.bytes - 1;
+  d.time = midi -> getTime();
+  dated.push_back(d);
+}
+
+static void note_on(uint8_t channel, uint8_t note, uint8_t velocity) {
+  date_message();
+  synth -> noteOn(channel, note, velocity, midi -> getTime());
+}
+
+static void note_off(uint8_t channel, uint8_t note, uint8_t velocity) {
+  date_message();
+  synth -> noteOff(channel, note, velocity, midi -> getTime());
+}
+
+static void check(bool ok, const char *what) {
+  printf("%-4s %s\n", ok ? "ok" : "FAIL", what);
+  if (!ok) {
+    failures++;
+  }
+}
+
+// A fresh synth and parser with audio running
+static void start() {
+  delete synth;
+  delete midi;
+  synth = new Synth(&pwm5, &pwm6, &pwm7);
+  midi = new MidiParser();
+  synth -> setClock(sim_micros);
+  synth -> begin();
+  synth -> silence(audio_buffers[0], AUDIO_BLOCK_SIZE);
+  synth -> silence(audio_buffers[1], AUDIO_BLOCK_SIZE);
+  midi -> setByteTime(MIDI_BYTE_SAMPLES);
+  midi -> setHandler(MIDI_NOTE_ON, note_on);
+  midi -> setHandler(MIDI_NOTE_OFF, note_off);
+
+  while (midi_in.read() >= 0) {
+  }
+  arrived.clear();
+  dated.clear();
+  stalls.clear();
+  dac_out.output.clear();
+  dac_out.start(audio_buffers[0], audio_buffers[1], AUDIO_BLOCK_SIZE, audio_block);
+  sim_clock.setIdle(idle);
+}
+
+// Messages back to back or after a gap of up to max_gap samples: notes, some
+// with running status, controllers and clock
+static std::vector<WireByte> dense_stream(int messages, int max_gap) {
+  std::vector<WireByte> bytes;
+  uint64_t t = sim_clock.now() + BLOCK_PERIOD;
+  uint8_t running = 0;
+  for (int m = 0; m < messages; m++) {
+    uint8_t msg[3];
+    int n = 0;
+    int r = rand() % 10;
+    if (r < 6) {
+      uint8_t status = (r < 4 ? 0x90 : 0x80) | (rand() % 2);
+      if (status != running || rand() % 2 == 0) {
+        msg[n++] = status;
+      }
+      msg[n++] = 36 + rand() % 48;
+      msg[n++] = rand() % 128;
+      running = status;
+    } else if (r < 8) {
+      msg[n++] = 0xB0;
+      msg[n++] = rand() % 120;
+      msg[n++] = rand() % 128;
+      running = 0xB0;
+    } else {
+      msg[n++] = 0xF8;
+    }
+    t += (uint64_t)(rand() % (max_gap + 1)) * AUDIO_TIMER_PERIOD;
+    for (int i = 0; i < n; i++) {
+      WireByte b;
+      b.time = t;
+      b.value = msg[i];
+      bytes.push_back(b);
+      t += BYTE_PERIOD;
+    }
+  }
+  return bytes;
+}
+
+// Stalls of up to max_blocks blocks, at random times over the stream
+static void add_stalls(const std::vector<WireByte> &bytes, int max_blocks) {
+  uint64_t t = bytes.front().time;
+  while (t < bytes.back().time) {
+    t += BLOCK_PERIOD * (1 + rand() % 20) + rand() % BLOCK_PERIOD;
+    uint64_t length = BLOCK_PERIOD * (rand() % (max_blocks + 1)) + rand() % BLOCK_PERIOD;
+    if (length > BLOCK_PERIOD * max_blocks) {
+      length = BLOCK_PERIOD * max_blocks;
+    }
+    stalls.push_back(t);
+    stalls.push_back(t + length);
+    t += length;
+  }
+}
+
+// Run a stream through the parser; returns the error range of the dates
+static void run_dates(int max_gap, int stall_blocks, int32_t *lo, int32_t *hi) {
+  start();
+  std::vector<WireByte> bytes = dense_stream(TEST_MESSAGES, max_gap);
+  if (stall_blocks > 0) {
+    add_stalls(bytes, stall_blocks);
+  }
+  wire.start(bytes);
+  sim_clock.run(bytes.back().time - sim_clock.now() + 2 * BLOCK_PERIOD);
+  unsigned stall_count = stalls.size() / 2;
+  stalls.clear();   // let loop() catch up with the last bytes
+  sim_clock.run(2 * BLOCK_PERIOD);
+
+  *lo = 0x7FFFFFFF;
+  *hi = -0x7FFFFFFF;
+  for (size_t i = 0; i < dated.size(); i++) {
+    int32_t error = (int32_t)(dated[i].time - arrived[dated[i].byte]);
+    *lo = error < *lo ? error : *lo;
+    *hi = error > *hi ? error : *hi;
+  }
+  printf("     %u note messages, %u stalls of up to %d blocks: dated %d to %d samples late\n",
+         (unsigned)dated.size(), stall_count, stall_blocks, *lo, *hi);
+}
+
+// One note at a time, 3 s apart so each ends in silence (the release is
+// 1 s), each arriving during a stall that ends before it is due to be
+// rendered; returns whether every onset is where its date puts it
+static bool run_onsets(int notes, int32_t *lo, int32_t *hi) {
+  start();
+  const uint32_t spacing = 3 * AUDIO_SAMPLE_RATE;
+  const uint32_t hold = AUDIO_SAMPLE_RATE / 2;
+  std::vector<WireByte> bytes;
+  uint64_t t0 = sim_clock.now() + BLOCK_PERIOD;
+  for (int k = 0; k < notes; k++) {
+    uint64_t t = t0 + ((uint64_t)k * spacing + rand() % 4096) * AUDIO_TIMER_PERIOD;
+    uint8_t msg[6] = {0x90, 69, 100, 0x80, 69, 0};
+    for (int i = 0; i < 6; i++) {
+      WireByte b;
+      b.time = t + i * BYTE_PERIOD + (i >= 3 ? (uint64_t)hold * AUDIO_TIMER_PERIOD : 0);
+      b.value = msg[i];
+      bytes.push_back(b);
+    }
+    // the first note is polled at once, the others after a stall
+    if (k > 0) {
+      stalls.push_back(t - BLOCK_PERIOD * (rand() % 4) - rand() % BLOCK_PERIOD);
+      stalls.push_back(t + 2 * BYTE_PERIOD + rand() % (BLOCK_PERIOD / 2));
+    }
+  }
+  wire.start(bytes);
+  sim_clock.run(bytes.back().time - sim_clock.now() + (uint64_t)spacing * AUDIO_TIMER_PERIOD);
+
+  // the first sample off the silent level after each note on
+  const std::vector<uint16_t> &out = dac_out.output;
+  uint16_t silent = out[0];
+  int32_t offset = 0;
+  bool placed = true;
+  *lo = 0x7FFFFFFF;
+  *hi = -0x7FFFFFFF;
+  for (size_t i = 0; i < dated.size(); i += 2) {
+    uint32_t due = dated[i].time + SYNTH_EVENT_LATENCY;
+    size_t from = i == 0 ? 0 : dated[i - 1].time + SYNTH_EVENT_LATENCY + 3 * hold;
+    size_t onset = from;
+    while (onset < out.size() && out[onset] == silent) {
+      onset++;
+    }
+    // the output index of a sample clock value, from the first note
+    if (i == 0) {
+      offset = (int32_t)(onset - due);
+    }
+    placed = placed && (int32_t)(onset - due) == offset;
+    int32_t error = (int32_t)(dated[i].time - arrived[dated[i].byte]);
+    *lo = error < *lo ? error : *lo;
+    *hi = error > *hi ? error : *hi;
+  }
+  printf("     %u notes: onsets %d to %d samples after arrival plus the latency, %lu late\n",
+         (unsigned)dated.size() / 2, *lo, *hi, synth -> getLateEvents());
+  return placed && synth -> getLateEvents() == 0 && synth -> getDroppedEvents() == 0;
+}
+
+int main() {
+  srand(1);
+  int32_t lo, hi;
+
+  run_dates(200, 0, &lo, &hi);
+  check(lo == 0 && hi == 0, "no stalls: every message dated exactly");
+
+  run_dates(200, MIDI_STAMPS - 2, &lo, &hi);
+  check(lo >= 0 && hi <= AUDIO_BLOCK_SIZE, "short stalls: dated 0 to one block late");
+
+  run_dates(0, MIDI_STAMPS - 2, &lo, &hi);
+  check(lo >= 0 && hi <= AUDIO_BLOCK_SIZE, "short stalls, bytes back to back: dated 0 to one block late");
+
+  run_dates(200, 8 * MIDI_STAMPS, &lo, &hi);
+  check(lo >= 0, "long stalls: never dated early");
+
+  bool placed = run_onsets(40, &lo, &hi);
+  check(placed, "onsets land SYNTH_EVENT_LATENCY after the message date, none late");
+  check(lo >= 0 && hi <= AUDIO_BLOCK_SIZE, "onsets after a stall are 0 to one block late");
+
+  if (failures) {
+    printf("%d checks failed\n", failures);
+    return 1;
+  }
+  printf("all checks passed\n");
+  return 0;
+}
@@ -0,0 +1,135 @@
+// osc_bench - pitch accuracy and per-sample cost of the phase-accumulator oscillator
+//
+// For every MIDI note, compares the frequency the oscillator actually plays
+// (the rounded 32-bit phase increment at AUDIO_SAMPLE_RATE) with the equal
+// tempered one, and does the same for the per-note timer period of the old
+// TC_Midi path (a 2048-sample table stepped through with the downsample
+// ladder, the period cut to the TC prescaler and compare value). Prints the
+// error in cents of both per octave and the worst of each.
+//
+// Then times PhaseOscillator::nextIndex plus the table read from the mip
+// level each note plays, over every note, and prints the cost per sample.
+//
+// Build and run from the repository root:
+//   g++ -O2 -std=gnu++11 -I. -o osc_bench tools/osc_bench.cpp oscillator.cpp
+//       wavetable.cpp wavetableData.cpp
+//   ./osc_bench [seconds_per_note]
+
+#include "oscillator.h"
+#include "wavetable.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+
+#define OLD_N_SAMPLES 2048
+#define OLD_GCLK0_HZ 120000000.0
+
+static double note_frequency(int note) {
+  return 440.0 * pow(2.0, (note - 69) / 12.0);
+}
+
+static double cents(double actual, double ideal) {
+  return 1200.0 * log2(actual / ideal);
+}
+
+// Frequency the old noteISR played: one table step per timer period, the
+// period given in 10s of ns and rounded by the timer to whole prescaled
+// GCLK0 ticks as in tc_period_settings(). The ladder is MyHandleNoteOn's,
+// where notes up to 54 miss the first branch and step by 4.
+static double old_frequency(int note) {
+  int downsample;
+  if (note > 54 && note < 67) {
+    downsample = 2;
+  } else if (note < 79) {
+    downsample = 4;
+  } else if (note < 91) {
+    downsample = 8;
+  } else if (note < 103) {
+    downsample = 16;
+  } else if (note < 115) {
+    downsample = 32;
+  } else {
+    downsample = 64;
+  }
+  double freq = note_frequency(note);
+  unsigned long period = (unsigned long)(1.0 / (freq * OLD_N_SAMPLES / downsample) * 100000000.0);
+
+  int prescaler = 1;
+  if (period > 300000) {
+    prescaler = 1024;
+  } else if (period > 80000) {
+    prescaler = 256;
+  } else if (period > 20000) {
+    prescaler = 64;
+  } else if (period > 10000) {
+    prescaler = 16;
+  } else if (period > 5000) {
+    prescaler = 8;
+  } else if (period > 2500) {
+    prescaler = 4;
+  } else if (period > 1000) {
+    prescaler = 2;
+  }
+  int compare = (int)(OLD_GCLK0_HZ / (prescaler / ((float)period / 100000000))) - 1;
+  double step_seconds = (compare + 1) * prescaler / OLD_GCLK0_HZ;
+  return 1.0 / (step_seconds * OLD_N_SAMPLES / downsample);
+}
+
+int main(int argc, char **argv) {
+  double seconds = argc > 1 ? atof(argv[1]) : 1.0;
+  if (seconds <= 0) {
+    fprintf(stderr, "usage: %s [seconds_per_note]\n", argv[0]);
+    return 1;
+  }
+
+  printf("phase increment resolution %.6f Hz\n\n", (double)AUDIO_SAMPLE_RATE / 4294967296.0);
+  printf("%-6s %12s %12s\n", "notes", "dds cents", "timer cents");
+  double worst_dds = 0, worst_old = 0;
+  int worst_dds_note = 0, worst_old_note = 0;
+  for (int octave = 0; octave < 11; octave++) {
+    double row_dds = 0, row_old = 0;
+    for (int note = octave * 12; note < octave * 12 + 12 && note < 128; note++) {
+      double ideal = note_frequency(note);
+      uint32_t inc = phase_increment(ideal, AUDIO_SAMPLE_RATE);
+      double dds = fabs(cents(inc * (double)AUDIO_SAMPLE_RATE / 4294967296.0, ideal));
+      double old = fabs(cents(old_frequency(note), ideal));
+      row_dds = dds > row_dds ? dds : row_dds;
+      row_old = old > row_old ? old : row_old;
+      if (dds > worst_dds) {
+        worst_dds = dds;
+        worst_dds_note = note;
+      }
+      if (old > worst_old) {
+        worst_old = old;
+        worst_old_note = note;
+      }
+    }
+    int last = octave * 12 + 11 < 127 ? octave * 12 + 11 : 127;
+    printf("%3d-%-3d %11.5f %12.3f\n", octave * 12, last, row_dds, row_old);
+  }
+  printf("worst   %11.5f (note %d) %7.3f (note %d)\n\n", worst_dds, worst_dds_note, worst_old, worst_old_note);
+
+  // Cost per sample: step the oscillator over the table each note plays
+  unsigned long samples_per_note = (unsigned long)(seconds * AUDIO_SAMPLE_RATE);
+  uint32_t sum = 0;
+  unsigned long samples = 0;
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  for (int note = 0; note < 128; note++) {
+    PhaseOscillator osc;
+    osc.setFrequency(note_frequency(note));
+    int level = mip_level_for_increment(osc.getIncrement());
+    const uint16_t *table = builtin_wavetables[2] + mip_offset(level);
+    int bits = mip_bits(level);
+    for (unsigned long i = 0; i < samples_per_note; i++) {
+      sum += table[osc.nextIndex(bits)];
+    }
+    samples += samples_per_note;
+  }
+  std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+  double elapsed = std::chrono::duration<double>(t1 - t0).count();
+
+  printf("%lu samples in %.3f s: %.2f ns per sample, %.0f x real time (checksum %08X)\n",
+         samples, elapsed, elapsed * 1e9 / samples, samples / elapsed / AUDIO_SAMPLE_RATE, sum);
+  return 0;
+}
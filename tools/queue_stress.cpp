@@ -0,0 +1,104 @@
+// queue_stress - hammer EventQueue from two threads
+//
+// A producer thread pushes numbered SynthEvents, retrying whenever the queue
+// is full, while a consumer thread pops them as fast as it can, standing in
+// for loop() and the audio interrupt. Every field of every event is derived
+// from its number, so the consumer checks that each arrives exactly once,
+// in order and untorn. It runs with the synth's queue size and with a
+// 4-entry queue that is full or empty almost all the time, and checks that
+// the drop count matches the pushes refused. Exits 1 on any error.
+//
+// Build and run from the repository root (with -fsanitize=thread to also
+// let TSan check the memory ordering):
+//   g++ -O2 -std=gnu++11 -pthread -I. -o queue_stress tools/queue_stress.cpp
+//   ./queue_stress [events]
+
+#include "eventQueue.h"
+#include "synth.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <thread>
+
+static SynthEvent make_event(uint32_t i) {
+  SynthEvent e;
+  e.timestamp = i;
+  e.type = i % 3;
+  e.channel = (i >> 2) & 0x0F;
+  e.note = (i >> 6) & 0x7F;
+  e.velocity = (i * 7) & 0x7F;
+  e.value = (uint16_t)(i ^ (i >> 16));
+  return e;
+}
+
+static bool same_event(const SynthEvent &a, const SynthEvent &b) {
+  return a.timestamp == b.timestamp && a.type == b.type && a.channel == b.channel && a.note == b.note &&
+         a.velocity == b.velocity && a.value == b.value;
+}
+
+template <int N>
+static int stress(const char *name, uint32_t events) {
+  static EventQueue<SynthEvent, N> queue;
+  unsigned long refused = 0;
+  unsigned long errors = 0;
+
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  std::thread producer([&] {
+    for (uint32_t i = 0; i < events;) {
+      if (queue.push(make_event(i))) {
+        i++;
+      } else {
+        refused++;
+        std::this_thread::yield();
+      }
+    }
+  });
+  std::thread consumer([&] {
+    SynthEvent e;
+    uint32_t next = 0;
+    while (next < events) {
+      if (!queue.pop(e)) {
+        std::this_thread::yield();
+        continue;
+      }
+      if (!same_event(e, make_event(next))) {
+        if (errors < 10) {
+          printf("%s: event %u arrived as %u (or torn)\n", name, next, e.timestamp);
+        }
+        errors++;
+        next = e.timestamp;
+      }
+      next++;
+    }
+  });
+  producer.join();
+  consumer.join();
+  std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+
+  SynthEvent extra;
+  if (queue.pop(extra)) {
+    printf("%s: queue not empty at the end\n", name);
+    errors++;
+  }
+  if (queue.getDropped() != refused) {
+    printf("%s: %lu drops counted, %lu pushes refused\n", name, queue.getDropped(), refused);
+    errors++;
+  }
+
+  double seconds = std::chrono::duration<double>(t1 - t0).count();
+  printf("%-10s %u events in %.3f s (%.1f M/s), %lu pushes refused, %lu errors\n", name, events, seconds,
+         events / seconds / 1e6, refused, errors);
+  return errors ? 1 : 0;
+}
+
+int main(int argc, char **argv) {
+  long events = argc > 1 ? atol(argv[1]) : 5000000L;
+  if (events <= 0) {
+    fprintf(stderr, "usage: %s [events]\n", argv[0]);
+    return 2;
+  }
+
+  int r = stress<SYNTH_EVENT_QUEUE>("synth size", events);
+  r |= stress<4>("4 entries", events);
+  return r;
+}
@@ -0,0 +1,801 @@
+// render_midi - render a Standard MIDI File through the synth on the host
+//
+// Plays the note events of a MIDI file, plus optional knob automation, into
+// Synth running on the Linux HAL backend. Events are queued at the sample
+// they fall on, stamped with it as the MIDI handlers stamp them on the board,
+// so every note starts exactly SYNTH_EVENT_LATENCY samples after its time in
+// the file.
+// The DAC stream (left) and the pwm7 VCA control voltage (right) are written
+// to a 16-bit stereo WAV at AUDIO_SAMPLE_RATE.
+//
+// Prints samples rendered per second, percentiles of the cost of each audio
+// block callback, and CRC-32 checksums of the DAC and VCA output so a change
+// in speed or in output shows up between runs.
+//
+// Knob automation is a text file with one "<seconds> <knob> <value>" per line,
+// knob being cutoff, q, attack, decay, sustain or release (or its number) and
+// value a raw 0 - 1023 ADC reading. Knobs start at mid-scale.
+//
+// -s mixes in a raw 16-bit mono sample file through StreamPlayer, read from a
+// host file throttled to -r bytes per second of simulated time (the SD card),
+// and reports the blocks read and any underruns.
+//
+// -b plays the waveforms of a wavetable bank (tools/txt2bank.cpp) through
+// WavetableCache, read from the same throttled card, instead of the built-in
+// ones. Program changes in the MIDI file select a bank table, and the cache
+// hits, misses and load latency are reported.
+//
+// --bench renders the built-in dense, sparse and fast-retrigger sequences and
+// prints one line per sequence; --gen writes one of them as a MIDI file.
+//
+// Built with -DPROFILE_ENABLED (and profiler.cpp) it also prints the
+// profiler.h statistics of the simulated handlers, in nanoseconds.
+//
+// Build and run from the repository root:
+//   g++ -O2 -std=gnu++11 -I. -o render_midi tools/render_midi.cpp synth.cpp halLinux.cpp
+//       tuning.cpp envelope.cpp voicePool.cpp blockRenderer.cpp knobFilter.cpp
+//       controlScheduler.cpp oscillator.cpp wavetable.cpp wavetableData.cpp profiler.cpp
+//       streamPlayer.cpp wavetableCache.cpp
+//   ./render_midi [-o out.wav] [-k knobs.txt] [-t tail_seconds] [-s sample.raw] [-b bank.wtb]
+//       [-r bytes_per_sec] song.mid
+//   ./render_midi --bench
+//   ./render_midi --gen dense|sparse|retrigger out.mid
+
+#include "halLinux.h"
+#include "synth.h"
+#include "controlScheduler.h"
+#include "oscillator.h"
+#include "wavetable.h"
+#include "profiler.h"
+#include "wavetableCache.h"
+#include "waveforms/wavetableBank.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+// A note, program or knob change at a time in seconds
+struct TimedEvent {
+  double time;
+  uint8_t status;   // MIDI status byte, or 0 for a knob change
+  uint8_t data1;    // note, or knob number
+  uint16_t data2;   // velocity, or knob value
+};
+
+static bool event_before(const TimedEvent &a, const TimedEvent &b) {
+  return a.time < b.time;
+}
+
+// ---- Standard MIDI File reading ----
+
+struct SmfEvent {
+  uint32_t tick;
+  uint8_t status;
+  uint8_t data1;
+  uint8_t data2;
+};
+
+struct SmfTempo {
+  uint32_t tick;
+  uint32_t us_per_quarter;
+};
+
+static bool smf_event_before(const SmfEvent &a, const SmfEvent &b) {
+  return a.tick < b.tick;
+}
+
+static bool smf_tempo_before(const SmfTempo &a, const SmfTempo &b) {
+  return a.tick < b.tick;
+}
+
+static uint32_t read_be(const uint8_t *p, int n) {
+  uint32_t v = 0;
+  for (int i = 0; i < n; i++) {
+    v = (v << 8) | p[i];
+  }
+  return v;
+}
+
+static bool read_vlq(const uint8_t *&p, const uint8_t *end, uint32_t &v) {
+  v = 0;
+  for (int i = 0; i < 4 && p < end; i++) {
+    uint8_t b = *p++;
+    v = (v << 7) | (b & 0x7F);
+    if ((b & 0x80) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Parse one MTrk chunk, keeping note on/off, program and tempo changes
+static bool parse_track(const uint8_t *p, const uint8_t *end,
+                        std::vector<SmfEvent> &events, std::vector<SmfTempo> &tempos) {
+  uint32_t tick = 0;
+  uint8_t running = 0;
+
+  while (p < end) {
+    uint32_t delta;
+    if (!read_vlq(p, end, delta) || p >= end) {
+      return false;
+    }
+    tick += delta;
+
+    uint8_t status = *p;
+    if (status & 0x80) {
+      p++;
+    } else if (running != 0) {
+      status = running;   // running status: the byte is already data
+    } else {
+      return false;
+    }
+
+    if (status == 0xFF) {
+      // Meta event
+      if (p >= end) {
+        return false;
+      }
+      uint8_t type = *p++;
+      uint32_t len;
+      if (!read_vlq(p, end, len) || p + len > end) {
+        return false;
+      }
+      if (type == 0x51 && len == 3) {
+        SmfTempo t = {tick, read_be(p, 3)};
+        tempos.push_back(t);
+      }
+      p += len;
+      if (type == 0x2F) {
+        break;   // end of track
+      }
+    } else if (status == 0xF0 || status == 0xF7) {
+      // SysEx, skipped
+      uint32_t len;
+      if (!read_vlq(p, end, len) || p + len > end) {
+        return false;
+      }
+      p += len;
+      running = 0;
+    } else {
+      int n = ((status & 0xF0) == 0xC0 || (status & 0xF0) == 0xD0) ? 1 : 2;
+      if (p + n > end) {
+        return false;
+      }
+      SmfEvent e = {tick, status, p[0], (uint8_t)(n > 1 ? p[1] : 0)};
+      p += n;
+      running = status;
+
+      uint8_t kind = status & 0xF0;
+      if (kind == 0x80 || kind == 0x90 || kind == 0xC0) {
+        events.push_back(e);
+      }
+    }
+  }
+  return true;
+}
+
+// Read the note and program events of a MIDI file, timed in seconds
+static bool parse_smf(const std::vector<uint8_t> &data, std::vector<TimedEvent> &out) {
+  const uint8_t *p = data.empty() ? NULL : &data[0];
+  const uint8_t *end = p + data.size();
+
+  if (data.size() < 14 || memcmp(p, "MThd", 4) != 0) {
+    fprintf(stderr, "not a MIDI file\n");
+    return false;
+  }
+  uint32_t header_len = read_be(p + 4, 4);
+  int n_tracks = read_be(p + 10, 2);
+  uint16_t division = read_be(p + 12, 2);
+  p += 8 + header_len;
+
+  std::vector<SmfEvent> events;
+  std::vector<SmfTempo> tempos;
+  for (int t = 0; t < n_tracks && p + 8 <= end; t++) {
+    uint32_t len = read_be(p + 4, 4);
+    const uint8_t *body = p + 8;
+    if (body + len > end) {
+      fprintf(stderr, "track %d is truncated\n", t);
+      return false;
+    }
+    if (memcmp(p, "MTrk", 4) == 0 && !parse_track(body, body + len, events, tempos)) {
+      fprintf(stderr, "track %d is malformed\n", t);
+      return false;
+    }
+    p = body + len;
+  }
+
+  std::stable_sort(events.begin(), events.end(), smf_event_before);
+  std::stable_sort(tempos.begin(), tempos.end(), smf_tempo_before);
+
+  // Ticks to seconds, following the tempo map
+  double seconds_per_tick;
+  if (division & 0x8000) {
+    int fps = -(int8_t)(division >> 8);
+    seconds_per_tick = 1.0 / (fps * (division & 0xFF));
+  } else {
+    seconds_per_tick = 0.5 / division;   // 120 bpm until the first tempo event
+  }
+
+  size_t ti = 0;
+  uint32_t last_tick = 0;
+  double now = 0;
+  for (size_t i = 0; i < events.size(); i++) {
+    const SmfEvent &e = events[i];
+    while (ti < tempos.size() && tempos[ti].tick <= e.tick) {
+      now += (tempos[ti].tick - last_tick) * seconds_per_tick;
+      last_tick = tempos[ti].tick;
+      if (!(division & 0x8000)) {
+        seconds_per_tick = tempos[ti].us_per_quarter * 1e-6 / division;
+      }
+      ti++;
+    }
+    now += (e.tick - last_tick) * seconds_per_tick;
+    last_tick = e.tick;
+
+    TimedEvent te = {now, e.status, e.data1, e.data2};
+    out.push_back(te);
+  }
+  return true;
+}
+
+// ---- Benchmark sequences ----
+
+static void put_be(std::vector<uint8_t> &out, uint32_t v, int n) {
+  for (int i = n - 1; i >= 0; i--) {
+    out.push_back((v >> (8 * i)) & 0xFF);
+  }
+}
+
+static void put_vlq(std::vector<uint8_t> &out, uint32_t v) {
+  uint8_t bytes[4];
+  int n = 0;
+  do {
+    bytes[n++] = v & 0x7F;
+    v >>= 7;
+  } while (v != 0 && n < 4);
+  while (n > 1) {
+    out.push_back(bytes[--n] | 0x80);
+  }
+  out.push_back(bytes[0]);
+}
+
+// Format 0 file, 480 ticks per quarter at 120 bpm, from (tick, status, d1, d2)
+static std::vector<uint8_t> make_smf(std::vector<SmfEvent> events) {
+  std::vector<uint8_t> track;
+  uint32_t last = 0;
+
+  std::stable_sort(events.begin(), events.end(), smf_event_before);
+  for (size_t i = 0; i < events.size(); i++) {
+    put_vlq(track, events[i].tick - last);
+    last = events[i].tick;
+    track.push_back(events[i].status);
+    track.push_back(events[i].data1);
+    track.push_back(events[i].data2);
+  }
+  put_vlq(track, 0);
+  track.push_back(0xFF);
+  track.push_back(0x2F);
+  track.push_back(0x00);
+
+  std::vector<uint8_t> out;
+  out.insert(out.end(), (const uint8_t *)"MThd", (const uint8_t *)"MThd" + 4);
+  put_be(out, 6, 4);
+  put_be(out, 0, 2);
+  put_be(out, 1, 2);
+  put_be(out, 480, 2);
+  out.insert(out.end(), (const uint8_t *)"MTrk", (const uint8_t *)"MTrk" + 4);
+  put_be(out, track.size(), 4);
+  out.insert(out.end(), track.begin(), track.end());
+  return out;
+}
+
+static void add_note(std::vector<SmfEvent> &ev, uint32_t on, uint32_t off, uint8_t note) {
+  SmfEvent a = {on, 0x90, note, 100};
+  SmfEvent b = {off, 0x80, note, 0};
+  ev.push_back(a);
+  ev.push_back(b);
+}
+
+// dense: 8-note chords on every 16th for 10 s, more notes than voices
+// sparse: one note every 2 s for 20 s
+// retrigger: the same note every 30 ms for 10 s
+static bool make_bench(const std::string &name, std::vector<uint8_t> &out) {
+  std::vector<SmfEvent> ev;
+
+  if (name == "dense") {
+    for (uint32_t t = 0; t < 20 * 480; t += 120) {
+      for (int v = 0; v < 8; v++) {
+        add_note(ev, t, t + 110, 48 + ((t / 120) % 12) + v * 5);
+      }
+    }
+  } else if (name == "sparse") {
+    for (uint32_t t = 0; t < 40 * 480; t += 4 * 480) {
+      add_note(ev, t, t + 480, 60 + (t / 1920) % 12);
+    }
+  } else if (name == "retrigger") {
+    for (uint32_t t = 0; t + 29 < 20 * 480; t += 29) {   // 29 ticks ~ 30 ms at 120 bpm
+      add_note(ev, t, t + 14, 64);
+    }
+  } else {
+    return false;
+  }
+  out = make_smf(ev);
+  return true;
+}
+
+// ---- Knob automation ----
+
+static const char *knob_names[N_KNOBS] = {"cutoff", "q", "attack", "decay", "sustain", "release"};
+
+static bool read_knobs(const char *filename, std::vector<TimedEvent> &out) {
+  FILE *f = fopen(filename, "r");
+  if (f == NULL) {
+    fprintf(stderr, "error opening %s\n", filename);
+    return false;
+  }
+
+  char line[256];
+  int line_no = 0;
+  while (fgets(line, sizeof(line), f) != NULL) {
+    line_no++;
+    char name[32];
+    double t;
+    int value;
+    if (line[0] == '#' || sscanf(line, "%lf %31s %d", &t, name, &value) != 3) {
+      continue;
+    }
+
+    int knob = -1;
+    for (int k = 0; k < N_KNOBS; k++) {
+      if (strcmp(name, knob_names[k]) == 0) {
+        knob = k;
+      }
+    }
+    if (knob < 0) {
+      knob = atoi(name);
+      if (knob < 0 || knob >= N_KNOBS || (name[0] < '0' || name[0] > '9')) {
+        fprintf(stderr, "%s:%d: unknown knob %s\n", filename, line_no, name);
+        fclose(f);
+        return false;
+      }
+    }
+    TimedEvent e = {t, 0, (uint8_t)knob, (uint16_t)(value < 0 ? 0 : value > 1023 ? 1023 : value)};
+    out.push_back(e);
+  }
+  fclose(f);
+  return true;
+}
+
+// ---- Simulated board ----
+
+// The VCA stream on pin 7 as set up by synth-control.ino and pwmHandler.h
+#define VCA_BLOCK_SIZE 64
+#define VCA_PWM_RATE 46875
+#define VCA_PWM_TOP 1023
+
+static LinuxClock sim_clock;
+static LinuxAudioOut dac_out(&sim_clock);
+static LinuxTimer control_timer(&sim_clock);
+static LinuxAdc knob_adc;
+static LinuxPwm pwm5(&sim_clock);
+static LinuxPwm pwm6(&sim_clock);
+static LinuxPwm pwm7(&sim_clock);
+static LinuxPwmStream vca_out(&sim_clock, VCA_PWM_RATE, VCA_PWM_TOP);
+
+static LinuxFile stream_file(&sim_clock);
+static const char *stream_name = NULL;
+static LinuxFile bank_file(&sim_clock);
+static const char *bank_name = NULL;
+
+static Synth *synth;
+static StreamPlayer *player;
+static WavetableCache *bank;
+static ControlScheduler *control;
+static uint16_t audio_buffers[2][AUDIO_BLOCK_SIZE];
+static uint16_t vca_buffers[2][VCA_BLOCK_SIZE];
+static std::vector<uint32_t> callback_ns;
+
+static void audio_block(uint16_t *block, int n) {
+  PROFILE_SCOPE(PROF_DMAC0);
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  synth -> render(block, n);
+  std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+  callback_ns.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+}
+
+static void vca_block(uint16_t *block, int n) {
+  PROFILE_SCOPE(PROF_DMAC4);
+  synth -> renderVca(block, n);
+}
+
+static void knob_scan() {
+  uint16_t raw[N_KNOBS];
+  knob_adc.readAll(raw);
+  synth -> updateKnobs(raw);
+}
+
+static void control_tick() {
+  PROFILE_SCOPE(PROF_TC2);
+  control -> tick();
+}
+
+// Microseconds of simulated time, for the cache load latency and the synth's
+// sample time
+static uint32_t sim_micros() {
+  return sim_clock.now() / 100;
+}
+
+// loop() of synth-control.ino
+static void idle() {
+  player -> fill(1);
+  int slot = bank -> service(synth -> getWavetablesInUse());
+  if (slot >= 0) {
+    synth -> setWaveform(slot);
+  }
+  control -> run();
+}
+
+struct RenderResult {
+  unsigned long samples;
+  double seconds;
+  uint32_t dac_crc;
+  uint32_t vca_crc;
+  uint32_t p50, p90, p99, max;
+  unsigned long dropped;
+  unsigned long late;
+  unsigned long stream_blocks;
+  unsigned long underruns;
+  unsigned long underrun_samples;
+  int low_water;
+  WavetableCacheStats cache;
+};
+
+static uint32_t percentile(const std::vector<uint32_t> &sorted, double p) {
+  if (sorted.empty()) {
+    return 0;
+  }
+  return sorted[(size_t)(p * (sorted.size() - 1) + 0.5)];
+}
+
+// The VCA stream resampled to one value per audio sample, taking the PWM
+// period each sample falls in
+static std::vector<uint16_t> vca_samples(unsigned long n) {
+  std::vector<uint16_t> out(n, vca_out.getTop());
+  const std::vector<uint16_t> &values = vca_out.output;
+
+  for (unsigned long i = 0; i < n; i++) {
+    uint64_t k = (uint64_t)i * AUDIO_TIMER_PERIOD * vca_out.getRate() / 100000000UL;
+    if (k < values.size()) {
+      out[i] = values[k];
+    }
+  }
+  return out;
+}
+
+// Play events into a freshly started synth and run tail seconds past the last one
+static RenderResult render(std::vector<TimedEvent> events, double tail, std::vector<uint16_t> *vca) {
+  synth = new Synth(&pwm5, &pwm6, &pwm7);
+  synth -> setClock(sim_micros);
+  control = new ControlScheduler();
+  player = new StreamPlayer();
+  bank = new WavetableCache();
+
+  dac_out.output.clear();
+  vca_out.output.clear();
+  callback_ns.clear();
+
+  int pins[N_KNOBS] = {0};
+  knob_adc.begin(pins, N_KNOBS);
+  for (int k = 0; k < N_KNOBS; k++) {
+    knob_adc.set(k, 512);
+  }
+
+  uint64_t start = sim_clock.now();
+  synth -> begin();
+  synth -> silence(audio_buffers[0], AUDIO_BLOCK_SIZE);
+  synth -> silence(audio_buffers[1], AUDIO_BLOCK_SIZE);
+  synth -> setStream(player);
+  if (stream_name != NULL && !player -> start(&stream_file, stream_name, false)) {
+    fprintf(stderr, "can't stream %s\n", stream_name);
+  }
+  if (bank_name != NULL) {
+    // as setup() does: table 0 is loaded before audio starts
+    int slot = -1;
+    bank -> setClock(sim_micros);
+    if (bank -> open(&bank_file, bank_name)) {
+      bank -> request(0);
+      while (slot < 0 && bank -> isLoading()) {
+        slot = bank -> service(0);
+      }
+    }
+    if (slot >= 0) {
+      const uint16_t *slots[WT_CACHE_SLOTS];
+      bank -> getSlots(slots);
+      synth -> setWavetables(slots, WT_CACHE_SLOTS);
+      synth -> setWaveform(slot);
+    } else {
+      fprintf(stderr, "can't load a wavetable from %s\n", bank_name);
+    }
+  }
+  synth -> streamVca(vca_out.getRate(), vca_out.getTop());
+  synth -> renderVca(vca_buffers[0], VCA_BLOCK_SIZE);
+  synth -> renderVca(vca_buffers[1], VCA_BLOCK_SIZE);
+  vca_out.start(vca_buffers[0], vca_buffers[1], VCA_BLOCK_SIZE, vca_block);
+  dac_out.start(audio_buffers[0], audio_buffers[1], AUDIO_BLOCK_SIZE, audio_block);
+  control -> addTask(knob_scan, 1, 1);
+  control_timer.start(CONTROL_TICK_PERIOD, control_tick);
+  sim_clock.setIdle(idle);
+
+  std::stable_sort(events.begin(), events.end(), event_before);
+
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  double end_time = 0;
+  for (size_t i = 0; i < events.size(); i++) {
+    const TimedEvent &e = events[i];
+    uint64_t due = start + (uint64_t)(e.time * AUDIO_SAMPLE_RATE + 0.5) * AUDIO_TIMER_PERIOD;
+    if (due > sim_clock.now()) {
+      sim_clock.run(due - sim_clock.now());
+    }
+
+    uint8_t kind = e.status & 0xF0;
+    uint8_t channel = e.status & 0x0F;
+    if (e.status == 0) {
+      knob_adc.set(e.data1, e.data2);
+    } else if (kind == 0xC0) {
+      if (bank -> getCount() > 0) {
+        if (e.data1 < bank -> getCount()) {
+          bank -> request(e.data1);
+        }
+      } else {
+        synth -> setWaveform(e.data1);
+      }
+    } else if (kind == 0x90 && e.data2 > 0) {
+      PROFILE_SCOPE(PROF_MIDI_NOTE_ON);
+      synth -> noteOn(channel, e.data1, e.data2, synth -> getSampleTime());
+    } else {
+      PROFILE_SCOPE(PROF_MIDI_NOTE_OFF);
+      synth -> noteOff(channel, e.data1, e.data2, synth -> getSampleTime());
+    }
+    end_time = e.time;
+  }
+  sim_clock.run((uint64_t)((end_time + tail) * AUDIO_SAMPLE_RATE) * AUDIO_TIMER_PERIOD + start - sim_clock.now());
+  std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+
+  dac_out.stop();
+  vca_out.stop();
+  control_timer.stop();
+
+  RenderResult r;
+  r.samples = dac_out.output.size();
+  r.seconds = std::chrono::duration<double>(t1 - t0).count();
+  r.dropped = synth -> getDroppedEvents();
+  r.late = synth -> getLateEvents();
+  r.stream_blocks = player -> getBlocksRead();
+  r.underruns = player -> getUnderruns();
+  r.underrun_samples = player -> getUnderrunSamples();
+  r.low_water = player -> getLowWater();
+  bank -> getStats(&r.cache);
+
+  std::vector<uint16_t> v = vca_samples(r.samples);
+  r.dac_crc = wt_crc32(0, r.samples ? &dac_out.output[0] : NULL, r.samples * sizeof(uint16_t));
+  r.vca_crc = wt_crc32(0, r.samples ? &v[0] : NULL, r.samples * sizeof(uint16_t));
+
+  std::vector<uint32_t> sorted = callback_ns;
+  std::sort(sorted.begin(), sorted.end());
+  r.p50 = percentile(sorted, 0.50);
+  r.p90 = percentile(sorted, 0.90);
+  r.p99 = percentile(sorted, 0.99);
+  r.max = sorted.empty() ? 0 : sorted.back();
+
+  if (vca != NULL) {
+    vca -> swap(v);
+  }
+  player -> stop();
+  bank_file.close();
+  delete synth;
+  delete control;
+  delete player;
+  delete bank;
+  return r;
+}
+
+static void print_result(const char *name, const RenderResult &r) {
+  printf("%-10s %9lu samples %12.0f samples/s  block ns p50 %6u p90 %6u p99 %6u max %7u  "
+         "dac crc %08X vca crc %08X",
+         name, r.samples, r.samples / r.seconds, r.p50, r.p90, r.p99, r.max, r.dac_crc, r.vca_crc);
+  if (r.dropped) {
+    printf("  dropped %lu", r.dropped);
+  }
+  if (r.late) {
+    printf("  late %lu", r.late);
+  }
+  if (stream_name != NULL) {
+    printf("  stream blocks %lu underruns %lu (%lu samples) low water %d",
+           r.stream_blocks, r.underruns, r.underrun_samples, r.low_water);
+  }
+  if (bank_name != NULL) {
+    printf("  wavetable hits %lu misses %lu errors %lu load us mean %.0f max %u",
+           r.cache.hits, r.cache.misses, r.cache.errors,
+           r.cache.loads ? (double)r.cache.total_latency / r.cache.loads : 0.0, r.cache.max_latency);
+  }
+  printf("\n");
+}
+
+#ifdef PROFILE_ENABLED
+static void print_profile() {
+  static const char *names[PROF_SLOTS] = {"TC0", "TC1", "TC2", "TC3", "TC4", "TC5",
+                                          "DMAC0", "DMAC1", "DMAC2", "DMAC3", "DMAC4",
+                                          "note on", "note off"};
+  printf("%-9s %9s %8s %8s %9s %9s %9s  log2 histogram\n",
+         "handler", "calls", "min", "max", "mean", "preempted", "nested");
+  for (int s = 0; s < PROF_SLOTS; s++) {
+    ProfileStats st;
+    profiler_get(s, &st);
+    if (st.count == 0) {
+      continue;
+    }
+    printf("%-9s %9u %8u %8u %9.0f %9u %9u ", names[s], st.count, st.min, st.max,
+           (double)st.total / st.count, st.preempted, st.nested);
+    for (int b = 0; b < PROFILE_BUCKETS; b++) {
+      if (st.histogram[b]) {
+        printf(" %d:%u", b, st.histogram[b]);
+      }
+    }
+    printf("\n");
+  }
+}
+#endif
+
+// ---- Files ----
+
+static bool read_file(const char *filename, std::vector<uint8_t> &data) {
+  FILE *f = fopen(filename, "rb");
+  if (f == NULL) {
+    fprintf(stderr, "error opening %s\n", filename);
+    return false;
+  }
+  uint8_t buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+    data.insert(data.end(), buf, buf + n);
+  }
+  fclose(f);
+  return true;
+}
+
+static bool write_file(const char *filename, const std::vector<uint8_t> &data) {
+  FILE *f = fopen(filename, "wb");
+  if (f == NULL || fwrite(data.data(), 1, data.size(), f) != data.size()) {
+    fprintf(stderr, "error writing %s\n", filename);
+    if (f != NULL) {
+      fclose(f);
+    }
+    return false;
+  }
+  fclose(f);
+  return true;
+}
+
+static void put_le(std::vector<uint8_t> &out, uint32_t v, int n) {
+  for (int i = 0; i < n; i++) {
+    out.push_back((v >> (8 * i)) & 0xFF);
+  }
+}
+
+// Stereo 16-bit WAV: DAC output on the left, VCA level on the right
+static bool write_wav(const char *filename, const std::vector<uint16_t> &dac, const std::vector<uint16_t> &vca) {
+  uint32_t frames = dac.size();
+  std::vector<uint8_t> out;
+
+  out.insert(out.end(), (const uint8_t *)"RIFF", (const uint8_t *)"RIFF" + 4);
+  put_le(out, 36 + frames * 4, 4);
+  out.insert(out.end(), (const uint8_t *)"WAVEfmt ", (const uint8_t *)"WAVEfmt " + 8);
+  put_le(out, 16, 4);
+  put_le(out, 1, 2);                        // PCM
+  put_le(out, 2, 2);                        // channels
+  put_le(out, AUDIO_SAMPLE_RATE, 4);
+  put_le(out, AUDIO_SAMPLE_RATE * 4, 4);    // bytes per second
+  put_le(out, 4, 2);                        // bytes per frame
+  put_le(out, 16, 2);
+  out.insert(out.end(), (const uint8_t *)"data", (const uint8_t *)"data" + 4);
+  put_le(out, frames * 4, 4);
+
+  for (uint32_t i = 0; i < frames; i++) {
+    int16_t left = (int16_t)(((int32_t)dac[i] - DAC_MID_CODE) * 32);
+    int16_t right = (int16_t)((vca_out.getTop() - vca[i]) * 32767 / vca_out.getTop());   // pwm7 is inverted
+    put_le(out, (uint16_t)left, 2);
+    put_le(out, (uint16_t)right, 2);
+  }
+  return write_file(filename, out);
+}
+
+static void usage() {
+  fprintf(stderr, "usage: render_midi [-o out.wav] [-k knobs.txt] [-t tail_seconds]\n"
+                  "                   [-s sample.raw] [-b bank.wtb] [-r bytes_per_sec] song.mid\n"
+                  "       render_midi --bench\n"
+                  "       render_midi --gen dense|sparse|retrigger out.mid\n");
+}
+
+int main(int argc, char **argv) {
+  const char *wav = NULL;
+  const char *knobs = NULL;
+  const char *midi = NULL;
+  double tail = 2.0;
+
+  if (argc == 2 && strcmp(argv[1], "--bench") == 0) {
+    const char *names[] = {"dense", "sparse", "retrigger"};
+    for (int i = 0; i < 3; i++) {
+      std::vector<uint8_t> data;
+      std::vector<TimedEvent> events;
+      make_bench(names[i], data);
+      parse_smf(data, events);
+      PROFILE_INIT();
+      print_result(names[i], render(events, tail, NULL));
+#ifdef PROFILE_ENABLED
+      print_profile();
+#endif
+    }
+    return 0;
+  }
+
+  if (argc == 4 && strcmp(argv[1], "--gen") == 0) {
+    std::vector<uint8_t> data;
+    if (!make_bench(argv[2], data)) {
+      usage();
+      return 1;
+    }
+    return write_file(argv[3], data) ? 0 : 1;
+  }
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+      wav = argv[++i];
+    } else if (strcmp(argv[i], "-k") == 0 && i + 1 < argc) {
+      knobs = argv[++i];
+    } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+      tail = atof(argv[++i]);
+    } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+      stream_name = argv[++i];
+    } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+      unsigned long rate = strtoul(argv[++i], NULL, 10);
+      stream_file.setThroughput(rate);
+      bank_file.setThroughput(rate);
+    } else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+      bank_name = argv[++i];
+    } else if (argv[i][0] != '-' && midi == NULL) {
+      midi = argv[i];
+    } else {
+      usage();
+      return 1;
+    }
+  }
+  if (midi == NULL) {
+    usage();
+    return 1;
+  }
+
+  std::vector<uint8_t> data;
+  std::vector<TimedEvent> events;
+  if (!read_file(midi, data) || !parse_smf(data, events)) {
+    return 1;
+  }
+  if (knobs != NULL && !read_knobs(knobs, events)) {
+    return 1;
+  }
+
+  std::vector<uint16_t> vca;
+  PROFILE_INIT();
+  RenderResult r = render(events, tail, &vca);
+  print_result(midi, r);
+#ifdef PROFILE_ENABLED
+  print_profile();
+#endif
+
+  if (wav != NULL && !write_wav(wav, dac_out.output, vca)) {
+    return 1;
+  }
+  return 0;
+}
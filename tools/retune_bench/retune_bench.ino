@@ -0,0 +1,95 @@
+// retune_bench - cycle cost of TC_Timer::retune() against setPeriod() on the board
+//
+// Runs TC4 with a counting callback and changes its period over and over
+// through each path, timing every call with the DWT cycle counter:
+//   setPeriod        - the full path: stop, prescaler writes with sync waits,
+//                      COUNT rescaled, restart
+//   retune           - the same prescaler, so only CCBUF is written
+//   retune, new div  - a prescaler change, which falls back to setPeriod
+// For each it prints the min, mean and max cycles per call, and the timer
+// ticks counted against the ticks the elapsed time should have given, which
+// shows the periods lost while the timer was stopped.
+//
+// Build from the repository root with the root on the library path, so the
+// timer library is found through its header and SAMD51_InterruptTimer.cpp is
+// compiled and linked, then watch the serial port at 115200:
+//   arduino-cli compile --fqbn adafruit:samd:adafruit_grandcentral_m4 --library . tools/retune_bench
+//   arduino-cli upload --fqbn adafruit:samd:adafruit_grandcentral_m4 -p <port> tools/retune_bench
+//   arduino-cli monitor -p <port> -c baudrate=115200
+
+#include "SAMD51_InterruptTimer.h"
+
+#define BENCH_CALLS 2000
+#define CPU_HZ 120000000UL
+#define PERIOD_A 2000UL    // 20 us, DIV2
+#define PERIOD_B 2010UL    // same prescaler as PERIOD_A
+#define PERIOD_C 6000UL    // 60 us, DIV8
+
+TC_Timer timer(4);
+volatile unsigned long ticks = 0;
+
+void tick() {
+  ticks++;
+}
+
+// Alternate between two periods through f and report the cost per call
+void bench(const char *name, void (TC_Timer::*f)(unsigned long), unsigned long a, unsigned long b) {
+  const double cycles_per_unit = CPU_HZ / 100000000.0;   // periods are in 10s of ns
+  uint32_t min = 0xFFFFFFFF, max = 0;
+  uint64_t total = 0;
+  double expected = 0;
+
+  timer.setPeriod(a);
+  ticks = 0;
+  uint32_t last = DWT->CYCCNT;
+  for (int i = 0; i < BENCH_CALLS; i++) {
+    unsigned long period = (i & 1) ? b : a;
+
+    noInterrupts();
+    uint32_t t0 = DWT->CYCCNT;
+    (timer.*f)(period);
+    uint32_t t1 = DWT->CYCCNT;
+    interrupts();
+
+    uint32_t cycles = t1 - t0;
+    min = cycles < min ? cycles : min;
+    max = cycles > max ? cycles : max;
+    total += cycles;
+
+    // Let a few periods go by at the new period and add what they should count
+    while (DWT->CYCCNT - t1 < 4 * period * cycles_per_unit) {}
+    uint32_t now = DWT->CYCCNT;
+    expected += (now - last) / (period * cycles_per_unit);
+    last = now;
+  }
+
+  Serial.print(name);
+  Serial.print(": cycles min ");
+  Serial.print(min);
+  Serial.print(" mean ");
+  Serial.print((double)total / BENCH_CALLS, 1);
+  Serial.print(" max ");
+  Serial.print(max);
+  Serial.print("  ticks ");
+  Serial.print(ticks);
+  Serial.print(" of ");
+  Serial.println(expected, 0);
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial) {}
+
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  timer.startTimer(PERIOD_A, tick);
+  bench("setPeriod       ", &TC_Timer::setPeriod, PERIOD_A, PERIOD_B);
+  bench("retune          ", &TC_Timer::retune, PERIOD_A, PERIOD_B);
+  bench("retune, new div ", &TC_Timer::retune, PERIOD_A, PERIOD_C);
+  timer.stopTimer();
+}
+
+void loop() {
+}
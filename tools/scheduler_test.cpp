@@ -0,0 +1,152 @@
+// scheduler_test - ControlScheduler on the virtual clock
+//
+// Ticks a ControlScheduler from a LinuxTimer at CONTROL_TICK_PERIOD, with
+// run() called as loop() would be after every tick, and checks that:
+//   - every task runs first at its phase and then exactly every period
+//   - tasks of the same period with different phases never share a tick
+//   - after loop() stalls, a late task runs once, the whole periods it
+//     missed are counted, and it goes back onto its original tick grid
+//   - a full table and a null task are refused
+// Prints one line per check and exits 1 if any fails.
+//
+// Build and run from the repository root:
+//   g++ -O2 -std=gnu++11 -I. -o scheduler_test tools/scheduler_test.cpp controlScheduler.cpp halLinux.cpp
+//   ./scheduler_test
+
+#include "controlScheduler.h"
+#include "halLinux.h"
+#include <stdio.h>
+#include <vector>
+
+#define TEST_TASKS 4
+
+static ControlScheduler *scheduler;
+static std::vector<uint32_t> ran[TEST_TASKS];
+static uint64_t stall_from, stall_until;   // clock times when loop() does not run
+static LinuxClock *sim_clock;
+static int failures = 0;
+
+static void task0() { ran[0].push_back(scheduler -> getTicks()); }
+static void task1() { ran[1].push_back(scheduler -> getTicks()); }
+static void task2() { ran[2].push_back(scheduler -> getTicks()); }
+static void task3() { ran[3].push_back(scheduler -> getTicks()); }
+static void (*const task_functions[TEST_TASKS])() = {task0, task1, task2, task3};
+
+static void tick() {
+  scheduler -> tick();
+}
+
+static void loop_pass() {
+  uint64_t now = sim_clock -> now();
+  if (now >= stall_from && now < stall_until) {
+    return;
+  }
+  scheduler -> run();
+}
+
+static void check(bool ok, const char *what) {
+  printf("%-4s %s\n", ok ? "ok" : "FAIL", what);
+  if (!ok) {
+    failures++;
+  }
+}
+
+// Whether the runs of a task before tick until fall on phase + k * period
+static bool on_grid(const std::vector<uint32_t> &runs, uint32_t period, uint32_t phase, uint32_t until) {
+  for (size_t i = 0; i < runs.size(); i++) {
+    if (runs[i] >= until) {
+      break;
+    }
+    if (runs[i] != phase + i * period) {
+      printf("     run %u at tick %u, expected %u\n", (unsigned)i, runs[i], (unsigned)(phase + i * period));
+      return false;
+    }
+  }
+  return true;
+}
+
+int main() {
+  LinuxClock clock;
+  LinuxTimer timer(&clock);
+  ControlScheduler s;
+  sim_clock = &clock;
+  scheduler = &s;
+
+  static const uint32_t periods[TEST_TASKS] = {1, 10, 10, 25};
+  static const uint32_t phases[TEST_TASKS] = {0, 0, 5, 7};
+  int ids[TEST_TASKS];
+  for (int t = 0; t < TEST_TASKS; t++) {
+    ids[t] = s.addTask(task_functions[t], periods[t], phases[t]);
+  }
+
+  // loop() runs once at tick 0, then after every tick up to 1000
+  stall_from = stall_until = 0;
+  s.run();
+  clock.setIdle(loop_pass);
+  timer.start(CONTROL_TICK_PERIOD, tick);
+  clock.run(1000ULL * CONTROL_TICK_PERIOD);
+
+  // Nothing is late, so run n lands on tick phase + n * period
+  bool grid = true;
+  for (int t = 0; t < TEST_TASKS; t++) {
+    grid = grid && on_grid(ran[t], periods[t], phases[t], 1001);
+    grid = grid && ran[t].size() == (1000 - phases[t]) / periods[t] + 1;
+    grid = grid && s.getMisses(ids[t]) == 0;
+  }
+  check(grid, "tasks run at their phase and then every period, no misses");
+
+  bool apart = true;
+  for (size_t i = 0; i < ran[1].size(); i++) {
+    for (size_t j = 0; j < ran[2].size(); j++) {
+      apart = apart && ran[1][i] != ran[2][j];
+    }
+  }
+  check(apart, "same-period tasks with different phases never share a tick");
+
+  // Stall loop() for the 62 ticks after this one
+  uint32_t runs_before[TEST_TASKS];
+  for (int t = 0; t < TEST_TASKS; t++) {
+    runs_before[t] = s.getRuns(ids[t]);
+    ran[t].clear();
+  }
+  uint32_t stall_tick = s.getTicks();
+  stall_from = clock.now();
+  stall_until = stall_from + 63ULL * CONTROL_TICK_PERIOD;
+  clock.run(200ULL * CONTROL_TICK_PERIOD);
+
+  bool once = true, counted = true, regrid = true;
+  for (int t = 0; t < TEST_TASKS; t++) {
+    // the first run after the stall, then back on phase + k * period
+    uint32_t resume = ran[t].empty() ? 0 : ran[t][0];
+    once = once && ran[t].size() >= 2 && ran[t][1] > resume;
+    uint32_t due = phases[t];
+    while (due <= stall_tick) {
+      due += periods[t];
+    }
+    uint32_t late = resume - due;
+    counted = counted && s.getMisses(ids[t]) == late / periods[t];
+    for (size_t i = 1; i < ran[t].size(); i++) {
+      regrid = regrid && (ran[t][i] - phases[t]) % periods[t] == 0 && ran[t][i] - ran[t][i - 1] <= periods[t];
+    }
+    printf("     task %d: period %u, resumed at tick %u, %u misses, %u runs\n", t, periods[t], resume,
+           s.getMisses(ids[t]), s.getRuns(ids[t]) - runs_before[t]);
+  }
+  check(once, "a late task runs once, not in a burst");
+  check(counted, "missed whole periods are counted");
+  check(regrid, "late tasks go back onto their tick grid");
+
+  ControlScheduler full;
+  bool refused = full.addTask(0, 1, 0) < 0;
+  for (int i = 0; i < CONTROL_MAX_TASKS; i++) {
+    refused = refused && full.addTask(task0, 1, 0) == i;
+  }
+  refused = refused && full.addTask(task0, 1, 0) < 0;
+  check(refused, "null task and task past CONTROL_MAX_TASKS are refused");
+
+  if (failures) {
+    printf("%d checks failed\n", failures);
+    return 1;
+  }
+  printf("all checks passed\n");
+  return 0;
+}
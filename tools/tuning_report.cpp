@@ -0,0 +1,107 @@
+// tuning_report - cents error of every note of the tuning table
+//
+// For each MIDI note prints the frequency the phase increment plays at
+// AUDIO_SAMPLE_RATE and its error in cents against equal temperament, for
+// the compile-time default_tuning and for a TuningTable rebuilt at run time
+// with the given reference pitch (and optional per pitch class offsets,
+// which the expected frequency includes). Ends with the worst error of each
+// and exits 1 if either is above the limit, or if the rebuilt table at
+// 440 Hz differs from default_tuning.
+//
+// Build and run from the repository root:
+//   g++ -O2 -std=gnu++11 -I. -o tuning_report tools/tuning_report.cpp tuning.cpp oscillator.cpp
+//   ./tuning_report [-a a4_hz] [-o c,c#,d,...,b cents] [-l max_cents] [-q]
+
+#include "tuning.h"
+#include "oscillator.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *pitch_names[12] = {"C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B"};
+
+static double played(uint32_t increment) {
+  return increment * (double)AUDIO_SAMPLE_RATE / 4294967296.0;
+}
+
+static double cents(double actual, double expected) {
+  return 1200.0 * log2(actual / expected);
+}
+
+int main(int argc, char **argv) {
+  double a4 = TUNING_A4_HZ;
+  float offsets[12] = {0};
+  double limit = 0.01;
+  bool quiet = false;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-a") == 0 && i + 1 < argc) {
+      a4 = atof(argv[++i]);
+    } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+      char *p = argv[++i];
+      for (int c = 0; c < 12; c++) {
+        offsets[c] = strtof(p, &p);
+        if (*p == ',') {
+          p++;
+        }
+      }
+    } else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc) {
+      limit = atof(argv[++i]);
+    } else if (strcmp(argv[i], "-q") == 0) {
+      quiet = true;
+    } else {
+      fprintf(stderr, "usage: %s [-a a4_hz] [-o c,c#,d,...,b cents] [-l max_cents] [-q]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (a4 <= 0) {
+    fprintf(stderr, "reference pitch must be positive\n");
+    return 2;
+  }
+
+  TuningTable tuning;
+  tuning.rebuild();
+  int mismatched = 0;
+  for (int n = 0; n < TUNING_NOTES; n++) {
+    if (tuning.increment(n) != default_tuning[n]) {
+      printf("note %d: default_tuning %u, rebuilt at %.1f Hz %u\n", n, default_tuning[n], TUNING_A4_HZ,
+             tuning.increment(n));
+      mismatched++;
+    }
+  }
+
+  tuning.setReference(a4);
+  tuning.setOffsets(offsets);
+
+  if (!quiet) {
+    printf("%-4s %-5s %14s %11s %14s %11s\n", "note", "name", "default Hz", "cents", "rebuilt Hz", "cents");
+  }
+  double worst_default = 0, worst_rebuilt = 0;
+  int worst_default_note = 0, worst_rebuilt_note = 0;
+  for (int n = 0; n < TUNING_NOTES; n++) {
+    double equal = TUNING_A4_HZ * pow(2.0, (n - TUNING_A4_NOTE) / 12.0);
+    double expected = a4 * pow(2.0, ((n - TUNING_A4_NOTE) * 100.0 + offsets[n % 12]) / 1200.0);
+    double e_default = cents(played(default_tuning[n]), equal);
+    double e_rebuilt = cents(played(tuning.increment(n)), expected);
+    if (!quiet) {
+      printf("%-4d %-2s%-3d %14.6f %+11.6f %14.6f %+11.6f\n", n, pitch_names[n % 12], n / 12 - 1,
+             played(default_tuning[n]), e_default, played(tuning.increment(n)), e_rebuilt);
+    }
+    if (fabs(e_default) > worst_default) {
+      worst_default = fabs(e_default);
+      worst_default_note = n;
+    }
+    if (fabs(e_rebuilt) > worst_rebuilt) {
+      worst_rebuilt = fabs(e_rebuilt);
+      worst_rebuilt_note = n;
+    }
+  }
+
+  printf("worst error: default %.6f cents (note %d), rebuilt at %.2f Hz %.6f cents (note %d), limit %.6f\n",
+         worst_default, worst_default_note, a4, worst_rebuilt, worst_rebuilt_note, limit);
+  if (mismatched) {
+    printf("%d notes of default_tuning differ from the run-time table\n", mismatched);
+  }
+  return (mismatched || worst_default > limit || worst_rebuilt > limit) ? 1 : 0;
+}
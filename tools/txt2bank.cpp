@@ -0,0 +1,91 @@
+// txt2bank - convert the comma-separated wavetable files into a binary bank
+//
+// Reads <dir>/<name><size>.txt for every mip level (e.g. saw2048.txt down to
+// saw32.txt, as written by waveforms/compute_waveforms_sd.ino) for each
+// waveform name, converts the samples to DAC codes and writes a bank file
+// that setup() can read straight into the wavetable array. The levels past
+// the smallest table size are made from the 32-sample file with the
+// harmonics above the level's limit removed.
+//
+// Build and run on the host from the repository root:
+//   g++ -O2 -std=gnu++11 -I. -o txt2bank tools/txt2bank.cpp wavetable.cpp
+//   ./txt2bank WAVES.WTB <sd card dir> sine square saw
+
+#include "wavetable.h"
+#include "waveforms/additiveSynthesis.h"
+#include "waveforms/wavetableBank.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+// Read up to n comma-separated doubles from a text file
+static bool read_txt(const std::string &filename, int n, std::vector<double> &vals) {
+  FILE *f = fopen(filename.c_str(), "r");
+  if (f == NULL) {
+    fprintf(stderr, "error opening %s\n", filename.c_str());
+    return false;
+  }
+
+  vals.assign(n, 0.0);
+  int idx = 0;
+  while (idx < n && fscanf(f, " %lf ,", &vals[idx]) == 1) {
+    idx++;
+  }
+  fclose(f);
+
+  if (idx < n) {
+    fprintf(stderr, "%s: expected %d values, read %d\n", filename.c_str(), n, idx);
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char **argv) {
+  if (argc < 4) {
+    fprintf(stderr, "usage: %s <out.wtb> <dir> <name> [name...]\n", argv[0]);
+    return 1;
+  }
+
+  int table_count = argc - 3;
+  std::vector<uint16_t> samples((size_t)table_count * MIP_TOTAL_SAMPLES);
+
+  for (int t = 0; t < table_count; t++) {
+    uint16_t *mipset = &samples[(size_t)t * MIP_TOTAL_SAMPLES];
+    for (int level = 0; level < MIP_LEVELS; level++) {
+      int size = mip_size(level);
+      std::string filename = std::string(argv[2]) + "/" + argv[3 + t] + std::to_string(size) + ".txt";
+      std::vector<double> vals;
+      if (!read_txt(filename, size, vals)) {
+        return 1;
+      }
+      if (mip_harmonics(level) < size / 2) {
+        band_limit_waveform(vals, mip_harmonics(level));
+      }
+      load_dac_codes(mipset + mip_offset(level), vals, size);
+    }
+  }
+
+  WavetableBankHeader header;
+  header.magic = WT_BANK_MAGIC;
+  header.version = WT_BANK_VERSION;
+  header.table_count = table_count;
+  header.table_size = MIP_TOTAL_SAMPLES;
+  header.sample_type = WT_SAMPLE_DAC_U16;
+  header.mip_max_bits = MIP_MAX_BITS;
+  header.mip_min_bits = MIP_MIN_BITS;
+  header.mip_top_bits = MIP_TOP_BITS;
+  header.crc32 = wt_crc32(0, samples.data(), samples.size() * sizeof(uint16_t));
+
+  FILE *out = fopen(argv[1], "wb");
+  if (out == NULL) {
+    fprintf(stderr, "error opening %s for writing\n", argv[1]);
+    return 1;
+  }
+  fwrite(&header, sizeof(header), 1, out);
+  fwrite(samples.data(), sizeof(uint16_t), samples.size(), out);
+  fclose(out);
+
+  printf("wrote %d tables of %d samples to %s\n", table_count, MIP_TOTAL_SAMPLES, argv[1]);
+  return 0;
+}
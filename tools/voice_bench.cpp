@@ -0,0 +1,102 @@
+// voice_bench - VoicePool mixing cost and the voice count a sample rate allows
+//
+// Mixes AUDIO_BLOCK_SIZE blocks from a VoicePool with 0 to N_VOICES notes
+// held (spread over the keyboard so every mip level is used) and times each
+// count. A straight line fitted through the timings gives the fixed cost per
+// sample and the cost of each voice per sample, and from those the number of
+// voices that fit in one sample period at the given rate, using the given
+// share of the CPU. The figures are for the host CPU; run it with the board's
+// relative speed in mind.
+//
+// Build and run from the repository root:
+//   g++ -O2 -std=gnu++11 -I. -o voice_bench tools/voice_bench.cpp voicePool.cpp
+//       envelope.cpp oscillator.cpp wavetable.cpp wavetableData.cpp
+//   ./voice_bench [--rate hz] [--cpu fraction] [--samples n]
+
+#include "voicePool.h"
+#include "blockRenderer.h"
+#include "oscillator.h"
+#include "wavetable.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+static double time_voices(int voices, long samples, uint32_t *sum) {
+  const uint16_t *tables[BUILTIN_WAVEFORMS];
+  for (int w = 0; w < BUILTIN_WAVEFORMS; w++) {
+    tables[w] = builtin_wavetables[w];
+  }
+  VoicePool pool;
+  pool.setWavetables(tables, BUILTIN_WAVEFORMS);
+  pool.setMorph(1 << VOICE_MORPH_BITS);   // square, with no crossfade
+  for (int v = 0; v < voices; v++) {
+    int note = 24 + v * 12;
+    pool.noteOn(note, phase_increment(440.0 * pow(2.0, (note - 69) / 12.0), AUDIO_SAMPLE_RATE));
+  }
+
+  uint16_t out[AUDIO_BLOCK_SIZE];
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  for (long i = 0; i < samples; i += AUDIO_BLOCK_SIZE) {
+    pool.mix(out, AUDIO_BLOCK_SIZE);
+    *sum += out[i & (AUDIO_BLOCK_SIZE - 1)];
+  }
+  std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(t1 - t0).count() * 1e9 / samples;
+}
+
+int main(int argc, char **argv) {
+  double rate = AUDIO_SAMPLE_RATE;
+  double cpu = 1.0;
+  long samples = 10000000L;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc) {
+      rate = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--cpu") == 0 && i + 1 < argc) {
+      cpu = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--samples") == 0 && i + 1 < argc) {
+      samples = atol(argv[++i]);
+    } else {
+      fprintf(stderr, "usage: %s [--rate hz] [--cpu fraction] [--samples n]\n", argv[0]);
+      return 1;
+    }
+  }
+  if (rate <= 0 || cpu <= 0 || samples < AUDIO_BLOCK_SIZE) {
+    fprintf(stderr, "rate, cpu and samples must be positive\n");
+    return 1;
+  }
+
+  double ns[N_VOICES + 1];
+  uint32_t sum = 0;
+  printf("%-7s %12s\n", "voices", "ns/sample");
+  for (int v = 0; v <= N_VOICES; v++) {
+    ns[v] = time_voices(v, samples, &sum);
+    printf("%-7d %12.2f\n", v, ns[v]);
+  }
+
+  // Least squares fit ns = base + per_voice * voices
+  double mx = N_VOICES / 2.0, my = 0;
+  for (int v = 0; v <= N_VOICES; v++) {
+    my += ns[v];
+  }
+  my /= N_VOICES + 1;
+  double sxy = 0, sxx = 0;
+  for (int v = 0; v <= N_VOICES; v++) {
+    sxy += (v - mx) * (ns[v] - my);
+    sxx += (v - mx) * (v - mx);
+  }
+  double per_voice = sxy / sxx;
+  double base = my - per_voice * mx;
+
+  double budget = 1e9 / rate * cpu;
+  printf("\nbase %.2f ns/sample, %.2f ns per voice per sample (checksum %08X)\n", base, per_voice, sum);
+  if (per_voice <= 0) {
+    printf("voice cost too small to measure, raise --samples\n");
+    return 0;
+  }
+  printf("%.0f Hz, %.0f%% of the CPU: %.2f ns per sample, up to %ld voices\n", rate, cpu * 100, budget,
+         (long)floor((budget - base) / per_voice));
+  return 0;
+}
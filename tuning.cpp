@@ -0,0 +1,73 @@
+#include "tuning.h"
+#include "oscillator.h"
+#include <math.h>
+
+// Compile-time 2^(d/12), built from exact octaves and at most 11 semitone steps
+constexpr double semitone_ratio(int n) {
+  return n == 0 ? 1.0 : 1.0594630943592952646 * semitone_ratio(n - 1);
+}
+
+constexpr double octave_ratio(int n) {
+  return n == 0 ? 1.0 : (n > 0 ? 2.0 * octave_ratio(n - 1) : 0.5 * octave_ratio(n + 1));
+}
+
+constexpr int octaves_from_a4(int note) {
+  return note >= TUNING_A4_NOTE ? (note - TUNING_A4_NOTE) / 12
+                                : -((TUNING_A4_NOTE - note + 11) / 12);
+}
+
+constexpr double note_ratio(int note) {
+  return octave_ratio(octaves_from_a4(note)) *
+         semitone_ratio(note - TUNING_A4_NOTE - 12 * octaves_from_a4(note));
+}
+
+constexpr uint32_t note_increment(int note) {
+  return (uint32_t)(TUNING_A4_HZ * note_ratio(note) * 4294967296.0 / AUDIO_SAMPLE_RATE + 0.5);
+}
+
+#define TUNE4(n) note_increment(n), note_increment(n + 1), note_increment(n + 2), note_increment(n + 3)
+#define TUNE16(n) TUNE4(n), TUNE4(n + 4), TUNE4(n + 8), TUNE4(n + 12)
+
+constexpr uint32_t default_tuning[TUNING_NOTES] = {
+  TUNE16(0), TUNE16(16), TUNE16(32), TUNE16(48),
+  TUNE16(64), TUNE16(80), TUNE16(96), TUNE16(112)
+};
+
+TuningTable::TuningTable() {
+  for (int n = 0; n < TUNING_NOTES; n++) {
+    this -> table[n] = default_tuning[n];
+  }
+  for (int i = 0; i < 12; i++) {
+    this -> offsets[i] = 0;
+  }
+  this -> reference = TUNING_A4_HZ;
+}
+
+void TuningTable::setReference(double a4_hz) {
+  this -> reference = a4_hz;
+  rebuild();
+}
+
+double TuningTable::getReference() {
+  return this -> reference;
+}
+
+// Offsets from equal temperament in cents for each pitch class (C, C#, ... B)
+void TuningTable::setOffsets(const float cents[12]) {
+  for (int i = 0; i < 12; i++) {
+    this -> offsets[i] = cents[i];
+  }
+  rebuild();
+}
+
+double TuningTable::getFrequency(uint8_t note) {
+  double cents = 100.0 * (int(note) - TUNING_A4_NOTE) + this -> offsets[note % 12];
+  return this -> reference * pow(2.0, cents / 1200.0);
+}
+
+// Recompute every note for the current reference pitch and offsets
+void TuningTable::rebuild() {
+  for (int n = 0; n < TUNING_NOTES; n++) {
+    this -> table[n] = phase_increment(getFrequency(n), AUDIO_SAMPLE_RATE);
+  }
+}
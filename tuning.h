@@ -0,0 +1,43 @@
+/*
+  tuning.h
+  MIDI note to phase increment tuning table
+
+  Every note's phase increment is looked up from a 128-entry table, so a
+  note-on costs one load instead of a pow() and a division. The equal
+  tempered table for A4 = 440 Hz at AUDIO_SAMPLE_RATE is computed by the
+  compiler; changing the reference pitch or the per-note offsets rebuilds the
+  RAM copy outside of the note-on path.
+*/
+
+#ifndef TUNING_H
+#define TUNING_H
+
+#include <stdint.h>
+
+#define TUNING_NOTES 128
+#define TUNING_A4_NOTE 69
+#define TUNING_A4_HZ 440.0       // Default reference pitch
+
+// Equal-tempered increments for A4 = TUNING_A4_HZ, generated at compile time
+extern const uint32_t default_tuning[TUNING_NOTES];
+
+class TuningTable {
+  public:
+    TuningTable();
+    void setReference(double a4_hz);
+    double getReference();
+    void setOffsets(const float cents[12]);
+    void rebuild();
+    double getFrequency(uint8_t note);
+
+    inline uint32_t increment(uint8_t note) {
+      return this -> table[note & 0x7F];
+    }
+
+  private:
+    uint32_t table[TUNING_NOTES];
+    double reference;
+    float offsets[12];   // cents per pitch class, C first
+};
+
+#endif
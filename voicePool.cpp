@@ -0,0 +1,289 @@
+#include "voicePool.h"
+#include "wavetable.h"
+
+VoicePool::VoicePool() {
+  for (int v = 0; v < N_VOICES; v++) {
+    this -> phase[v] = 0;
+    this -> increment[v] = 0;
+    this -> table_offset[v] = 0;
+    this -> table_shift[v] = 32 - MIP_MAX_BITS;
+    this -> envelope[v].setParams(&(this -> envelope_params));
+    this -> morph[v] = 0;
+    this -> note[v] = 0;
+    this -> started[v] = 0;
+  }
+  for (int w = 0; w < VOICE_MAX_WAVETABLES; w++) {
+    this -> wavetables[w] = 0;
+  }
+  this -> wavetable_count = 0;
+  this -> morph_target = 0;
+  this -> allocations = 0;
+  envelope_set_params(&(this -> envelope_params), 0, 0, ENV_LEVEL_MAX, 0, 1);
+}
+
+// Pick a voice for a new note: the voice already playing this note, then a
+// free voice, then the quietest released voice, then the oldest voice.
+int VoicePool::allocate(uint8_t n) {
+  int quietest = -1;
+  int oldest = 0;
+
+  for (int v = 0; v < N_VOICES; v++) {
+    if (this -> envelope[v].isActive() && this -> note[v] == n) {
+      return v;
+    }
+  }
+
+  for (int v = 0; v < N_VOICES; v++) {
+    if (!this -> envelope[v].isActive()) {
+      return v;
+    }
+    if (this -> envelope[v].getStage() == ENV_RELEASE) {
+      if (quietest < 0 || this -> envelope[v].getLevel() < this -> envelope[quietest].getLevel()) {
+        quietest = v;
+      }
+    }
+    if ((int32_t)(this -> started[v] - this -> started[oldest]) < 0) {
+      oldest = v;
+    }
+  }
+
+  if (quietest >= 0) {
+    return quietest;
+  }
+  return oldest;
+}
+
+// Start a note and return the voice it was given
+int VoicePool::noteOn(uint8_t n, uint32_t inc) {
+  int v = allocate(n);
+  int mip = mip_level_for_increment(inc);
+
+  if (!this -> envelope[v].isActive()) {
+    this -> phase[v] = 0;
+    this -> morph[v] = this -> morph_target;
+  }
+  this -> increment[v] = inc;
+  this -> table_offset[v] = mip_offset(mip);
+  this -> table_shift[v] = 32 - mip_bits(mip);
+  this -> note[v] = n;
+  this -> started[v] = ++(this -> allocations);
+  this -> envelope[v].noteOn();
+
+  return v;
+}
+
+void VoicePool::noteOff(uint8_t n) {
+  for (int v = 0; v < N_VOICES; v++) {
+    if (this -> note[v] == n) {
+      this -> envelope[v].noteOff();
+    }
+  }
+}
+
+void VoicePool::allNotesOff() {
+  for (int v = 0; v < N_VOICES; v++) {
+    this -> envelope[v].noteOff();
+  }
+}
+
+// Fade times of every voice. Voices only fade in and out (no decay, full
+// sustain); the VCA envelope shapes the rest.
+void VoicePool::setEnvelope(int attack_ms, int release_ms, unsigned long sample_rate) {
+  envelope_set_params(&(this -> envelope_params), attack_ms, 0, ENV_LEVEL_MAX, release_ms, sample_rate);
+}
+
+// Mip sets the morph position moves across, copied so the caller's array
+// can go away. Call before audio starts.
+void VoicePool::setWavetables(const uint16_t * const *mipsets, int count) {
+  if (count > VOICE_MAX_WAVETABLES) {
+    count = VOICE_MAX_WAVETABLES;
+  }
+  for (int w = 0; w < count; w++) {
+    this -> wavetables[w] = mipsets[w];
+  }
+  this -> wavetable_count = count;
+  setMorph(this -> morph_target);
+}
+
+// Move to a new morph position. Playing voices pick it up at the start of
+// their next cycle; safe to call from any context.
+void VoicePool::setMorph(uint16_t position) {
+  uint16_t max = 0;
+  if (this -> wavetable_count > 0) {
+    max = (this -> wavetable_count - 1) << VOICE_MORPH_BITS;
+  }
+  this -> morph_target = position < max ? position : max;
+}
+
+uint16_t VoicePool::getMorph() {
+  return this -> morph_target;
+}
+
+int VoicePool::getWavetableCount() {
+  return this -> wavetable_count;
+}
+
+// Bit w is set for every wavetable that is played now or may be played
+// without another setMorph(): the pair under the target and the pair each
+// sounding voice has latched. Voices only ever move to the target, so a
+// table outside the mask stays unused until the next setMorph().
+uint32_t VoicePool::getWavetablesInUse() {
+  const uint16_t fade = (1 << VOICE_MORPH_BITS) - 1;
+  uint16_t target = this -> morph_target;
+  uint32_t mask = 1UL << (target >> VOICE_MORPH_BITS);
+  if (target & fade) {
+    mask |= 2UL << (target >> VOICE_MORPH_BITS);
+  }
+  for (int v = 0; v < N_VOICES; v++) {
+    if (this -> envelope[v].isActive()) {
+      uint16_t m = this -> morph[v];
+      mask |= 1UL << (m >> VOICE_MORPH_BITS);
+      if (m & fade) {
+        mask |= 2UL << (m >> VOICE_MORPH_BITS);
+      }
+    }
+  }
+  return mask;
+}
+
+// Voices that are producing sound
+int VoicePool::getActiveCount() {
+  int count = 0;
+  for (int v = 0; v < N_VOICES; v++) {
+    if (this -> envelope[v].isActive()) {
+      count++;
+    }
+  }
+  return count;
+}
+
+// Voices whose key is still held down
+int VoicePool::getHeldCount() {
+  int count = 0;
+  for (int v = 0; v < N_VOICES; v++) {
+    if (this -> envelope[v].isHeld()) {
+      count++;
+    }
+  }
+  return count;
+}
+
+// Add n samples of one voice to acc, interpolated between table entries and,
+// when blend is not zero, crossfaded from table_a towards table_b (blend is
+// Q15). The phase and envelope level are carried on to the next call.
+static void mix_voice(int32_t *acc, int n, const uint16_t *table_a, const uint16_t *table_b,
+                      int32_t blend, int shift, uint32_t &ph, uint32_t inc, int32_t &lvl, int32_t step) {
+  const int32_t mid = DAC_MID_CODE;
+  const uint32_t mask = 0xFFFFFFFFUL >> shift;   // table length - 1
+  const int frac_shift = shift - 15;
+  uint32_t p = ph;
+  int32_t l = lvl;
+
+  if (blend == 0) {
+    for (int i = 0; i < n; i++) {
+      uint32_t idx = p >> shift;
+      int32_t frac = (p >> frac_shift) & 0x7FFF;
+      int32_t a0 = table_a[idx];
+      int32_t s = wt_lerp(a0, (int32_t)table_a[(idx + 1) & mask] - a0, frac) - mid;
+      acc[i] += (s * l) >> 16;
+      l += step;
+      p += inc;
+    }
+  } else {
+    for (int i = 0; i < n; i++) {
+      uint32_t idx = p >> shift;
+      uint32_t next = (idx + 1) & mask;
+      int32_t frac = (p >> frac_shift) & 0x7FFF;
+      int32_t a0 = table_a[idx];
+      int32_t b0 = table_b[idx];
+      int32_t a = wt_lerp(a0, (int32_t)table_a[next] - a0, frac);
+      int32_t b = wt_lerp(b0, (int32_t)table_b[next] - b0, frac);
+      int32_t s = wt_lerp(a, b - a, blend) - mid;
+      acc[i] += (s * l) >> 16;
+      l += step;
+      p += inc;
+    }
+  }
+
+  ph = p;
+  lvl = l;
+}
+
+// Mix n samples of all active voices into out as DAC codes
+void VoicePool::mix(uint16_t *out, int n) {
+  while (n > 0) {
+    int chunk = n < VOICE_MIX_CHUNK ? n : VOICE_MIX_CHUNK;
+    mixChunk(out, chunk);
+    out += chunk;
+    n -= chunk;
+  }
+}
+
+void VoicePool::mixChunk(uint16_t *out, int n) {
+  const int32_t mid = DAC_MID_CODE;
+  const int last = this -> wavetable_count - 1;
+  const uint16_t target = this -> morph_target;
+  int32_t acc[VOICE_MIX_CHUNK];
+
+  for (int i = 0; i < n; i++) {
+    acc[i] = 0;
+  }
+
+  for (int v = 0; v < N_VOICES && last >= 0; v++) {
+    Envelope &env = this -> envelope[v];
+    if (!env.isActive()) {
+      continue;
+    }
+
+    int shift = this -> table_shift[v];
+    uint32_t ph = this -> phase[v];
+    uint32_t inc = this -> increment[v];
+
+    // The envelope is stepped once per chunk and ramped linearly across it
+    int32_t lvl = env.getLevel();
+    int32_t step = ((int32_t)env.advance(n) - lvl) / n;
+
+    int i = 0;
+    while (i < n) {
+      // Play up to the end of the current cycle, or of the chunk, on the
+      // position latched for this cycle
+      int count = n - i;
+      bool wraps = false;
+      if (this -> morph[v] != target) {
+        if (ph == 0) {
+          this -> morph[v] = target;
+        } else if (inc != 0) {
+          uint32_t to_wrap = ~ph / inc + 1;
+          if (to_wrap <= (uint32_t)count) {
+            count = to_wrap;
+            wraps = true;
+          }
+        }
+      }
+
+      int w = this -> morph[v] >> VOICE_MORPH_BITS;
+      int32_t blend = (this -> morph[v] & ((1 << VOICE_MORPH_BITS) - 1)) << (15 - VOICE_MORPH_BITS);
+      const uint16_t *table_a = this -> wavetables[w] + this -> table_offset[v];
+      const uint16_t *table_b = this -> wavetables[w < last ? w + 1 : w] + this -> table_offset[v];
+      mix_voice(acc + i, count, table_a, table_b, blend, shift, ph, inc, lvl, step);
+      i += count;
+
+      if (wraps) {
+        // the phase has just wrapped, start the next cycle at the new position
+        this -> morph[v] = target;
+      }
+    }
+
+    this -> phase[v] = ph;
+  }
+
+  for (int i = 0; i < n; i++) {
+    int32_t s = mid + (acc[i] >> VOICE_MIX_SHIFT);
+    if (s < 0) {
+      s = 0;
+    } else if (s > DAC_MAX_CODE) {
+      s = DAC_MAX_CODE;
+    }
+    out[i] = (uint16_t)s;
+  }
+}
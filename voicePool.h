@@ -0,0 +1,67 @@
+/*
+  voicePool.h
+  Fixed-size polyphonic voice pool
+
+  Voice state is kept as a struct of arrays (phase, increment, mip table
+  and envelope per voice) so the mixer can walk each voice with its state held
+  in registers. When all voices are busy a new note steals the quietest
+  released voice, or the oldest voice if none are releasing.
+
+  Samples are interpolated between table entries. The morph position picks
+  a pair of adjacent wavetables and a crossfade between them; a voice only
+  takes up a new position where its phase wraps, so waveform changes never
+  cut into the middle of a cycle.
+  Plain C++ so it can also be built and measured on a host machine.
+*/
+
+#ifndef VOICEPOOL_H
+#define VOICEPOOL_H
+
+#include <stdint.h>
+#include "envelope.h"
+
+#define N_VOICES 8              // Number of simultaneous voices
+#define VOICE_MIX_SHIFT 2       // Mix headroom: the sum of all voices is divided by 2^VOICE_MIX_SHIFT
+#define VOICE_MIX_CHUNK 64      // Samples mixed per pass over the voices
+#define VOICE_MAX_WAVETABLES 8  // Wavetables the morph position can move across
+#define VOICE_MORPH_BITS 8      // Morph position is wavetable * 2^VOICE_MORPH_BITS + crossfade
+
+class VoicePool {
+  public:
+    VoicePool();
+    int noteOn(uint8_t note, uint32_t increment);
+    void noteOff(uint8_t note);
+    void allNotesOff();
+    void setEnvelope(int attack_ms, int release_ms, unsigned long sample_rate);
+    void setWavetables(const uint16_t * const *mipsets, int count);
+    void setMorph(uint16_t position);
+    uint16_t getMorph();
+    int getWavetableCount();
+    uint32_t getWavetablesInUse();
+    int getActiveCount();
+    int getHeldCount();
+    void mix(uint16_t *out, int n);
+
+  private:
+    int allocate(uint8_t note);
+    void mixChunk(uint16_t *out, int n);
+
+    // Voice state, one entry per voice
+    uint32_t phase[N_VOICES];
+    uint32_t increment[N_VOICES];
+    uint16_t table_offset[N_VOICES];   // mip level table within the mip set
+    uint8_t table_shift[N_VOICES];     // phase shift that indexes that table
+    Envelope envelope[N_VOICES];       // attack/release fade, stepped once per chunk
+    uint16_t morph[N_VOICES];          // morph position of the cycle being played
+    uint8_t note[N_VOICES];
+    uint32_t started[N_VOICES];   // allocation order, used to find the oldest voice
+
+    uint32_t allocations;
+    EnvelopeParams envelope_params;
+
+    const uint16_t *wavetables[VOICE_MAX_WAVETABLES];   // mip sets, in morph order
+    int wavetable_count;
+    volatile uint16_t morph_target;    // voices move here at their next cycle
+};
+
+#endif
@@ -35,27 +35,29 @@ std::vector<double> read_SDCard(String filename, int N) {
         std::stringstream ss(data);
 
         int idx = 0;
-        Serial.println("string streaming");
         while (ss.good()) {
             std::string substr;
             std::getline(ss, substr, ',');
             v[idx] = std::stod(substr);
-            Serial.print(std::stod(substr));
-            Serial.print(" ");
             idx++;
 
             if (idx >= N) {
               break;
             }
         }
-        Serial.println("");
+        Serial.print("read ");
+        Serial.print(idx);
+        Serial.println(" values");
 
+#ifdef SD_VERBOSE
+        // Echo every value, slow for the larger tables
         Serial.print("v: ");
         for (int i = 0; i < v.size(); i++) {
           Serial.print(v[i]);
           Serial.print(" ");
         }
         Serial.println("");
+#endif
 
         // close the file:
         myFile.close();
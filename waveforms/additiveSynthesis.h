@@ -0,0 +1,187 @@
+// Additive synthesis of the band-limited wavetables
+//
+// Shared by waveforms/compute_waveforms_sd.ino, which writes the tables to
+// the SD card, tools/gen_wavetables.cpp, which generates the built-in
+// tables compiled into the synth, and the host tools that compare against
+// them. Header only, so every function is inline. Only uses the C++
+// standard library.
+
+#ifndef ADDITIVESYNTHESIS_H
+#define ADDITIVESYNTHESIS_H
+
+#include <math.h>
+#include <vector>
+
+#ifndef PI
+#define PI 3.1415926535897932384626433832795
+#endif
+
+// Scale a waveform to between 0 and 1
+inline void normalize_waveform(std::vector<double> &xx) {
+  if (xx.empty()) {
+    return;
+  }
+  double min = xx[0];
+  double max = xx[0];
+  for (size_t i = 1; i < xx.size(); i++) {
+    if (xx[i] < min) {
+      min = xx[i];
+    } else if (xx[i] > max) {
+      max = xx[i];
+    }
+  }
+
+  for (size_t i = 0; i < xx.size(); i++) {
+    xx[i] = (xx[i] - min) / (max - min);
+  }
+}
+
+// Add n_terms sine harmonics with amplitudes a to xx and normalize.
+// Direct sum, costs Ns * n_terms calls to sin().
+inline void additive_synthesis(int Ns, int n_terms, std::vector<double> &xx, std::vector<double> &a) {
+  for (int k = 0; k < n_terms; k++) {
+    // add the current harmonic
+    for (int i = 0; i < Ns; i++) {
+      xx[i] = xx[i] + a[k] * sin(2 * PI * (k+1) * i / Ns);
+    }
+  }
+
+  normalize_waveform(xx);
+}
+
+// In-place radix-2 FFT of the complex sequence (re, im), whose length must be
+// a power of two. inverse = true computes sum(X[k] * e^(+j 2 pi k n / N))
+// without the 1/N scale.
+inline void fft(std::vector<double> &re, std::vector<double> &im, bool inverse) {
+  int n = re.size();
+
+  // bit-reversal permutation
+  for (int i = 1, j = 0; i < n; i++) {
+    int bit = n >> 1;
+    for (; j & bit; bit >>= 1) {
+      j ^= bit;
+    }
+    j ^= bit;
+    if (i < j) {
+      double t = re[i]; re[i] = re[j]; re[j] = t;
+      t = im[i]; im[i] = im[j]; im[j] = t;
+    }
+  }
+
+  for (int len = 2; len <= n; len <<= 1) {
+    double angle = (inverse ? 2 : -2) * PI / len;
+    double w_re = cos(angle);
+    double w_im = sin(angle);
+    for (int start = 0; start < n; start += len) {
+      double u_re = 1;
+      double u_im = 0;
+      for (int k = 0; k < len / 2; k++) {
+        int a = start + k;
+        int b = a + len / 2;
+        double t_re = re[b] * u_re - im[b] * u_im;
+        double t_im = re[b] * u_im + im[b] * u_re;
+        re[b] = re[a] - t_re;
+        im[b] = im[a] - t_im;
+        re[a] += t_re;
+        im[a] += t_im;
+
+        double next_re = u_re * w_re - u_im * w_im;
+        u_im = u_re * w_im + u_im * w_re;
+        u_re = next_re;
+      }
+    }
+  }
+}
+
+// Same result as additive_synthesis(), computed from the harmonic spectrum
+// with one inverse FFT in O(Ns log Ns). Harmonic k+1 is
+// a[k] * sin(2 pi (k+1) i / Ns + phase[k]); phase may be NULL for all zeros.
+// Ns must be a power of two.
+inline void fft_synthesis(int Ns, int n_terms, std::vector<double> &xx, std::vector<double> &a,
+                          std::vector<double> *phase = NULL) {
+  std::vector<double> re(Ns, 0.0);
+  std::vector<double> im(Ns, 0.0);
+
+  // a sin(x + p) = (a e^(jp) / 2j) e^(jx) + conj(a e^(jp) / 2j) e^(-jx), so each
+  // harmonic adds a conjugate pair of bins. Harmonics above Ns / 2 fold back
+  // exactly as they do in the direct sum.
+  for (int k = 0; k < n_terms; k++) {
+    double p = phase != NULL ? (*phase)[k] : 0.0;
+    double c_re = 0.5 * a[k] * sin(p);
+    double c_im = -0.5 * a[k] * cos(p);
+    int pos = (k + 1) % Ns;
+    int neg = (Ns - pos) % Ns;
+    re[pos] += c_re;
+    im[pos] += c_im;
+    re[neg] += c_re;
+    im[neg] -= c_im;
+  }
+
+  fft(re, im, true);
+
+  for (int i = 0; i < Ns; i++) {
+    xx[i] = xx[i] + re[i];
+  }
+
+  normalize_waveform(xx);
+}
+
+// Remove every harmonic above the given one from a waveform whose length
+// is a power of two, and normalize it again
+inline void band_limit_waveform(std::vector<double> &xx, int harmonics) {
+  int Ns = xx.size();
+  std::vector<double> re(xx);
+  std::vector<double> im(Ns, 0.0);
+
+  fft(re, im, false);
+  for (int k = harmonics + 1; k < Ns - harmonics; k++) {
+    re[k] = 0;
+    im[k] = 0;
+  }
+  fft(re, im, true);
+
+  for (int i = 0; i < Ns; i++) {
+    xx[i] = re[i] / Ns;
+  }
+  normalize_waveform(xx);
+}
+
+inline std::vector<double> makeSine(int Ns) {
+  std::vector<double> sinevec(Ns, 0.0);
+  for (int i = 0; i < Ns; i++) {
+    double angle = 2 * PI / Ns * i;
+    sinevec[i] = 0.5 * sin(angle) + 0.5;
+  }
+
+  return sinevec;
+}
+
+inline std::vector<double> makeSquare(int Ns) {
+  std::vector<double> sqrvec(Ns, 0.0);
+
+  int n_terms = Ns / 2;    
+  std::vector<double> a_sqr(n_terms, 0.0);
+  for (int k = 0; k < n_terms; k++) {
+    a_sqr[k] = ((k + 1) % 2) / (double(k) + 1);
+  }  
+
+  fft_synthesis(Ns, n_terms, sqrvec, a_sqr);
+
+  return sqrvec;
+}
+
+inline std::vector<double> makeSaw(int Ns) {
+  std::vector<double> sawvec(Ns, 0.0);
+
+  int n_terms = Ns / 2;
+  std::vector<double> a_saw(n_terms, 0.0);
+  for (int k = 0; k < n_terms; k++) {
+    a_saw[k] = 1 / (double(k) + 1);
+  }
+
+  fft_synthesis(Ns, n_terms, sawvec, a_saw);
+
+  return sawvec;
+}
+
+#endif
@@ -1,4 +1,5 @@
 #include "SDHandling.h"
+#include "additiveSynthesis.h"
 #include <vector>
 
 #define N_SAMPLES 2048
@@ -8,73 +9,6 @@ const int chipSelect = SDCARD_SS_PIN;
 
 int mode = 1; // 0: read; 1: write
 
-void additive_synthesis(int Ns, int n_terms, std::vector<double> &xx, std::vector<double> &a) {
-  for (int k = 0; k < n_terms; k++) {
-    // add the current harmonic
-    for (int i = 0; i < Ns; i++) {
-      xx[i] = xx[i] + a[k] * sin(2 * PI * (k+1) * i / Ns);
-    }
-  }
-
-  // normalize to between 0 and 1
-  double min, max;
-  for (int i = 0; i < xx.size(); i++) {
-    if (i == 0) {
-      min = xx[i];
-      max = xx[i];
-    } else {
-      if (xx[i] < min) {
-        min = xx[i];
-      } else if (xx[i] > max) {
-        max = xx[i];
-      }
-    }
-  }
-
-  for (int i = 0; i < xx.size(); i++) {
-    xx[i] = (xx[i] - min) / (max - min);
-  }
-}
-
-std::vector<double> makeSine(int Ns) {
-  std::vector<double> sinevec(Ns, 0.0);
-  for (int i = 0; i < Ns; i++) {
-    double angle = 2 * PI / Ns * i;
-    sinevec[i] = 0.5 * sin(angle) + 0.5;
-  }
-
-  return sinevec;
-}
-
-std::vector<double> makeSquare(int Ns) {
-  std::vector<double> sqrvec(Ns, 0.0);
-
-  int n_terms = Ns / 2;    
-  std::vector<double> a_sqr(n_terms, 0.0);
-  for (int k = 0; k < n_terms; k++) {
-    a_sqr[k] = ((k + 1) % 2) / (double(k) + 1);
-  }  
-
-  additive_synthesis(Ns, n_terms, sqrvec, a_sqr);
-
-  return sqrvec;
-}
-
-std::vector<double> makeSaw(int Ns) {
-  std::vector<double> sawvec(Ns, 0.0);
-
-  int n_terms = Ns / 2;
-  std::vector<double> a_saw(n_terms, 0.0);
-  for (int k = 0; k < n_terms; k++) {
-    a_saw[k] = 1 / (double(k) + 1);
-  }
-
-  additive_synthesis(Ns, n_terms, sawvec, a_saw);
-
-  return sawvec;
-}
- 
-
 void setup()
 {
   Serial.begin(9600);
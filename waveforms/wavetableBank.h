@@ -0,0 +1,62 @@
+// Binary wavetable bank format
+//
+// A bank file is a WavetableBankHeader followed by table_count tables of
+// table_size packed little-endian samples. With sample_type
+// WT_SAMPLE_DAC_U16 the samples are DAC codes, so a bank can be read from
+// the SD card straight into the wavetable array. Each table is a full mip
+// set (largest level first) as described in wavetable.h.
+//
+// Banks are written from the .txt tables by tools/txt2bank.cpp.
+
+#ifndef WAVETABLEBANK_H
+#define WAVETABLEBANK_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define WT_BANK_MAGIC 0x4B425457UL   // "WTBK" as little-endian bytes
+#define WT_BANK_VERSION 2            // 2: mip sets go on past the smallest table size
+
+#define WT_SAMPLE_DAC_U16 1          // uint16_t DAC codes
+
+struct WavetableBankHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t table_count;    // number of tables (waveforms) in the bank
+  uint32_t table_size;     // samples per table
+  uint8_t sample_type;     // WT_SAMPLE_*
+  uint8_t mip_max_bits;    // log2 of the largest mip level in each table
+  uint8_t mip_min_bits;    // log2 of the smallest mip level in each table
+  uint8_t mip_top_bits;    // log2 of twice the harmonics of the last mip level
+  uint32_t crc32;          // CRC-32 of all sample data after the header
+};
+
+static_assert(sizeof(WavetableBankHeader) == 20, "bank header must be packed");
+
+// Update a CRC-32 (IEEE 802.3) with len bytes of data. Start with crc = 0.
+inline uint32_t wt_crc32(uint32_t crc, const void *data, size_t len) {
+  static const uint32_t nibble_table[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+    0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+    0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+  };
+  const uint8_t *p = (const uint8_t *)data;
+
+  crc = ~crc;
+  for (size_t i = 0; i < len; i++) {
+    crc = (crc >> 4) ^ nibble_table[(crc ^ p[i]) & 0x0F];
+    crc = (crc >> 4) ^ nibble_table[(crc ^ (p[i] >> 4)) & 0x0F];
+  }
+  return ~crc;
+}
+
+// Check that a header describes a bank of DAC-code tables of table_size samples
+inline bool wt_bank_header_valid(const WavetableBankHeader &h, uint32_t table_size) {
+  return h.magic == WT_BANK_MAGIC &&
+         h.version == WT_BANK_VERSION &&
+         h.sample_type == WT_SAMPLE_DAC_U16 &&
+         h.table_size == table_size;
+}
+
+#endif
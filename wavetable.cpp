@@ -0,0 +1,38 @@
+#include "wavetable.h"
+
+uint16_t dac_code(double val) {
+  if (val <= 0) {
+    return 0;
+  } else if (val >= 1) {
+    return DAC_MAX_CODE;
+  }
+  return (uint16_t)(val * DAC_MAX_CODE);
+}
+
+int mip_level_for_increment(uint32_t increment) {
+  if (increment == 0) {
+    return 0;
+  }
+
+  // A table of 2^bits samples advances increment * 2^bits / 2^32 samples per
+  // output sample; keep that at or below one so its top harmonic (half the
+  // table length) is under Nyquist. Past the smallest table the level's
+  // harmonics keep halving the same way.
+  int bits = __builtin_clz(increment);
+  if (bits > MIP_MAX_BITS) {
+    bits = MIP_MAX_BITS;
+  } else if (bits < MIP_TOP_BITS) {
+    bits = MIP_TOP_BITS;
+  }
+  return MIP_MAX_BITS - bits;
+}
+
+void load_dac_codes(uint16_t *table, const std::vector<double> &vals, int n) {
+  for (int i = 0; i < n; i++) {
+    if (i < (int)vals.size()) {
+      table[i] = dac_code(vals[i]);
+    } else {
+      table[i] = 0;
+    }
+  }
+}
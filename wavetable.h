@@ -0,0 +1,85 @@
+/*
+  wavetable.h
+  Wavetable storage helpers
+
+  Waveforms are generated as doubles between 0 and 1 and converted to DAC
+  codes ahead of time, so the audio ISR only has to look up a sample and
+  write it out.
+
+  Each waveform is kept as a mip set: band-limited tables of 512, 256, ...
+  32 samples stored back to back, largest first. A table of N samples holds
+  harmonics up to N/2, so a note plays from the largest table whose highest
+  harmonic stays below Nyquist. Playback interpolates between neighbouring
+  samples, which is what lets the largest table stay this small.
+
+  Above the range of the 32-sample table (about MIDI note 91 at 50 kHz) the
+  chain goes on with more 32-sample levels holding 8, 4, 2 and finally only
+  the first harmonic, so every pitch up to Nyquist gets a table that does
+  not alias.
+*/
+
+#ifndef WAVETABLE_H
+#define WAVETABLE_H
+
+#include <stdint.h>
+#include <vector>
+
+#define DAC_MAX_CODE 2047   // Full-scale DAC code, 2^11 - 1
+#define DAC_MID_CODE 1024   // DAC code for zero signal when voices are mixed
+
+#define MIP_MAX_BITS 9          // log2 of the largest table size (512)
+#define MIP_MIN_BITS 5          // log2 of the smallest table size (32)
+#define MIP_TOP_BITS 1          // log2 of twice the harmonics of the last level (sine only)
+#define MIP_LEVELS (MIP_MAX_BITS - MIP_TOP_BITS + 1)
+#define MIP_SMALL_LEVEL (MIP_MAX_BITS - MIP_MIN_BITS)   // First level of the smallest table size
+#define MIP_TOTAL_SAMPLES ((2 << MIP_MAX_BITS) - (1 << MIP_MIN_BITS) + \
+                           ((MIP_MIN_BITS - MIP_TOP_BITS) << MIP_MIN_BITS))   // Samples in one mip set
+
+// Size, log2 size, highest harmonic and offset within a mip set of a mip
+// level (0 is the largest table)
+inline int mip_bits(int level) {
+  return level < MIP_SMALL_LEVEL ? MIP_MAX_BITS - level : MIP_MIN_BITS;
+}
+
+inline int mip_size(int level) {
+  return 1 << mip_bits(level);
+}
+
+inline int mip_harmonics(int level) {
+  return 1 << (MIP_MAX_BITS - level - 1);
+}
+
+inline int mip_offset(int level) {
+  if (level <= MIP_SMALL_LEVEL) {
+    return (2 << MIP_MAX_BITS) - (2 << (MIP_MAX_BITS - level));
+  }
+  return (2 << MIP_MAX_BITS) - (2 << MIP_MIN_BITS) + ((level - MIP_SMALL_LEVEL) << MIP_MIN_BITS);
+}
+
+// Mip level that plays a phase increment without aliasing
+int mip_level_for_increment(uint32_t increment);
+
+// s0 + d * frac / 2^15, with frac between 0 and 32767. Used for interpolating
+// between table samples and for crossfading; a single SMLAWB on the Cortex-M4.
+inline int32_t wt_lerp(int32_t s0, int32_t d, int32_t frac) {
+#ifdef __ARM_FEATURE_DSP
+  int32_t r;
+  __asm__ ("smlawb %0, %1, %2, %3" : "=r" (r) : "r" (d * 2), "r" (frac), "r" (s0));
+  return r;
+#else
+  return s0 + ((d * 2 * frac) >> 16);
+#endif
+}
+
+// Built-in sine, square and saw mip sets, generated by tools/gen_wavetables.cpp
+// into wavetableData.cpp and stored in flash
+#define BUILTIN_WAVEFORMS 3
+extern const uint16_t builtin_wavetables[BUILTIN_WAVEFORMS][MIP_TOTAL_SAMPLES];
+
+// Convert a sample between 0 and 1 to a DAC code
+uint16_t dac_code(double val);
+
+// Convert the first n samples of vals to DAC codes and store them in table
+void load_dac_codes(uint16_t *table, const std::vector<double> &vals, int n);
+
+#endif
@@ -0,0 +1,225 @@
+#include "wavetableCache.h"
+#include "waveforms/wavetableBank.h"
+#include <string.h>
+
+#define WT_TABLE_BYTES (MIP_TOTAL_SAMPLES * sizeof(uint16_t))
+
+WavetableCache::WavetableCache() {
+  for (int s = 0; s < WT_CACHE_SLOTS; s++) {
+    this -> slot_table[s] = -1;
+    this -> slot_used[s] = 0;
+  }
+  this -> uses = 0;
+  this -> file = 0;
+  this -> data_offset = 0;
+  this -> table_count = 0;
+  this -> requested = -1;
+  this -> request_seq = 0;
+  this -> handled_seq = 0;
+  this -> pending = -1;
+  this -> load_slot = -1;
+  this -> load_pos = 0;
+  this -> request_time = 0;
+  this -> clock = 0;
+  memset(&(this -> stats), 0, sizeof(this -> stats));
+}
+
+// Time source for the load latency, e.g. micros() on the board
+void WavetableCache::setClock(uint32_t (*now)()) {
+  this -> clock = now;
+}
+
+// Open a bank and check that its tables are mip sets of this build and that
+// the file holds all of them. The file stays open for the loads.
+bool WavetableCache::open(HalFile *file, const char *name) {
+  WavetableBankHeader header;
+
+  if (!file -> open(name)) {
+    return false;
+  }
+  if (file -> read(&header, sizeof(header)) != (int)sizeof(header) ||
+      !wt_bank_header_valid(header, MIP_TOTAL_SAMPLES) ||
+      header.mip_max_bits != MIP_MAX_BITS || header.mip_min_bits != MIP_MIN_BITS ||
+      header.mip_top_bits != MIP_TOP_BITS || header.table_count == 0 ||
+      file -> size() != sizeof(header) + (uint32_t)header.table_count * WT_TABLE_BYTES) {
+    file -> close();
+    return false;
+  }
+
+  this -> file = file;
+  this -> data_offset = sizeof(header);
+  this -> table_count = header.table_count;
+  for (int s = 0; s < WT_CACHE_SLOTS; s++) {
+    this -> slot_table[s] = -1;
+  }
+  this -> pending = -1;
+  this -> load_slot = -1;
+  return true;
+}
+
+// Stop loading and close the bank; service() does nothing until the next open()
+void WavetableCache::close() {
+  if (this -> file != 0) {
+    this -> file -> close();
+    this -> file = 0;
+  }
+  this -> pending = -1;
+  this -> load_slot = -1;
+  this -> handled_seq = this -> request_seq;
+}
+
+// Tables in the open bank
+int WavetableCache::getCount() {
+  return this -> table_count;
+}
+
+// Addresses of the slots, in slot order, for VoicePool::setWavetables()
+void WavetableCache::getSlots(const uint16_t **slots) {
+  for (int s = 0; s < WT_CACHE_SLOTS; s++) {
+    slots[s] = this -> slots[s];
+  }
+}
+
+// Ask for a table; service() picks it up. A newer request replaces one that
+// has not been served yet.
+void WavetableCache::request(int table) {
+  this -> requested = table;
+  this -> request_seq++;
+}
+
+// Work on the latest request. busy has bit s set for every slot the voices
+// may still be reading, which are never replaced. Returns the slot holding
+// the requested table once it is ready (once per request), otherwise -1.
+int WavetableCache::service(uint32_t busy) {
+  if (this -> file == 0) {
+    return -1;
+  }
+
+  uint32_t seq = this -> request_seq;
+  if (seq != this -> handled_seq) {
+    int table = this -> requested;
+    this -> handled_seq = seq;
+    this -> request_time = this -> clock ? this -> clock() : 0;
+
+    int s = find(table);
+    if (s >= 0) {
+      // a load in progress for an older request is dropped, its slot is empty
+      this -> pending = -1;
+      this -> stats.hits++;
+      touch(s);
+      return s;
+    }
+    if (table < 0 || table >= this -> table_count) {
+      this -> pending = -1;
+      return -1;
+    }
+
+    // Miss: start over in the slot of an abandoned load, or find a new one
+    this -> stats.misses++;
+    this -> pending = table;
+    this -> load_pos = 0;
+    if (this -> load_slot >= 0 && !(busy & (1UL << this -> load_slot))) {
+      if (!this -> file -> seek(this -> data_offset + (uint32_t)table * WT_TABLE_BYTES)) {
+        this -> stats.errors++;
+        this -> pending = -1;
+        return -1;
+      }
+    } else {
+      this -> load_slot = -1;
+    }
+  }
+
+  if (this -> pending < 0) {
+    return -1;
+  }
+
+  if (this -> load_slot < 0) {
+    int s = victim(busy);
+    if (s < 0) {
+      return -1;   // every slot is playing, wait for voices to move on
+    }
+    this -> slot_table[s] = -1;
+    this -> load_slot = s;
+    if (!this -> file -> seek(this -> data_offset + (uint32_t)this -> pending * WT_TABLE_BYTES)) {
+      this -> stats.errors++;
+      this -> pending = -1;
+      return -1;
+    }
+  }
+
+  uint32_t n = WT_TABLE_BYTES - this -> load_pos;
+  if (n > WT_CACHE_CHUNK) {
+    n = WT_CACHE_CHUNK;
+  }
+  // The bank is not rate limited, so a read that returns nothing is the end
+  // of a truncated file. Either way the half-loaded slot stays empty.
+  int got = this -> file -> read((uint8_t *)this -> slots[this -> load_slot] + this -> load_pos, n);
+  if (got <= 0) {
+    this -> stats.errors++;
+    this -> pending = -1;
+    this -> load_slot = -1;
+    return -1;
+  }
+  this -> load_pos += got;
+  if (this -> load_pos < WT_TABLE_BYTES) {
+    return -1;
+  }
+
+  int s = this -> load_slot;
+  this -> slot_table[s] = this -> pending;
+  touch(s);
+  this -> pending = -1;
+  this -> load_slot = -1;
+
+  uint32_t latency = (this -> clock ? this -> clock() : 0) - this -> request_time;
+  this -> stats.loads++;
+  this -> stats.last_latency = latency;
+  this -> stats.total_latency += latency;
+  if (latency > this -> stats.max_latency) {
+    this -> stats.max_latency = latency;
+  }
+  return s;
+}
+
+bool WavetableCache::isLoading() {
+  return this -> pending >= 0 || this -> request_seq != this -> handled_seq;
+}
+
+// Table held by a slot, -1 when it is empty or being loaded
+int WavetableCache::getSlotTable(int slot) {
+  return this -> slot_table[slot];
+}
+
+void WavetableCache::getStats(WavetableCacheStats *stats) {
+  *stats = this -> stats;
+}
+
+int WavetableCache::find(int table) {
+  for (int s = 0; s < WT_CACHE_SLOTS; s++) {
+    if (this -> slot_table[s] == table && table >= 0) {
+      return s;
+    }
+  }
+  return -1;
+}
+
+// Empty slot if there is one, otherwise the least recently used idle slot
+int WavetableCache::victim(uint32_t busy) {
+  int best = -1;
+  for (int s = 0; s < WT_CACHE_SLOTS; s++) {
+    if (busy & (1UL << s)) {
+      continue;
+    }
+    if (this -> slot_table[s] < 0) {
+      return s;
+    }
+    if (best < 0 || (int32_t)(this -> slot_used[s] - this -> slot_used[best]) < 0) {
+      best = s;
+    }
+  }
+  return best;
+}
+
+void WavetableCache::touch(int slot) {
+  this -> slot_used[slot] = ++(this -> uses);
+}
@@ -0,0 +1,81 @@
+/*
+  wavetableCache.h
+  RAM cache of wavetables loaded on demand from a bank file
+
+  A bank on the SD card (waveforms/wavetableBank.h) can hold far more mip
+  sets than fit in RAM, so only WT_CACHE_SLOTS of them are kept, and the
+  least recently used one that no voice is playing is replaced on a miss.
+  request() only records which table is wanted, so it can be called from
+  the waveform button interrupt. service() runs from loop(): a hit is
+  returned at once, a miss is read one chunk per call while the current
+  table keeps playing, and the slot is returned once it is complete. The
+  caller then points the synth at that slot, and each voice changes over at
+  its next cycle. Plain C++ so it can be run against a host file.
+*/
+
+#ifndef WAVETABLECACHE_H
+#define WAVETABLECACHE_H
+
+#include <stdint.h>
+#include "hal.h"
+#include "wavetable.h"
+
+#define WT_CACHE_SLOTS 4      // mip sets held in RAM (MIP_TOTAL_SAMPLES * 2 bytes each)
+#define WT_CACHE_CHUNK 512    // bytes read from the bank per service() call
+
+struct WavetableCacheStats {
+  unsigned long hits;
+  unsigned long misses;
+  unsigned long errors;          // loads given up on a read error or end of file
+  unsigned long loads;           // misses that completed
+  uint32_t last_latency;         // request to ready, in clock units
+  uint32_t max_latency;
+  uint32_t total_latency;        // over all completed loads
+};
+
+class WavetableCache {
+  public:
+    WavetableCache();
+    void setClock(uint32_t (*now)());
+    bool open(HalFile *file, const char *name);
+    void close();
+    int getCount();
+    void getSlots(const uint16_t **slots);
+
+    // any context
+    void request(int table);
+
+    // loop() side
+    int service(uint32_t busy);
+    bool isLoading();
+    int getSlotTable(int slot);
+    void getStats(WavetableCacheStats *stats);
+
+  private:
+    int find(int table);
+    int victim(uint32_t busy);
+    void touch(int slot);
+
+    uint16_t slots[WT_CACHE_SLOTS][MIP_TOTAL_SAMPLES];
+    int slot_table[WT_CACHE_SLOTS];     // table held by each slot, -1 when empty
+    uint32_t slot_used[WT_CACHE_SLOTS]; // use order, for LRU
+    uint32_t uses;
+
+    HalFile *file;
+    uint32_t data_offset;               // file position of table 0
+    int table_count;
+
+    volatile int requested;
+    volatile uint32_t request_seq;      // bumped by every request()
+    uint32_t handled_seq;
+
+    int pending;                        // table being loaded, -1 when idle
+    int load_slot;                      // slot it is loaded into, -1 until one is free
+    uint32_t load_pos;                  // bytes loaded so far
+    uint32_t request_time;
+
+    uint32_t (*clock)();
+    WavetableCacheStats stats;
+};
+
+#endif
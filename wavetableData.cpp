@@ -0,0 +1,253 @@
+// Generated by tools/gen_wavetables.cpp - do not edit
+// Band-limited mip sets (512 down to 32 samples, up to harmonic 256 down to 1) as DAC codes
+
+#include "wavetable.h"
+
+const uint16_t builtin_wavetables[BUILTIN_WAVEFORMS][MIP_TOTAL_SAMPLES] = {
+  // sine
+  {
+    // 512 samples, harmonics 1 - 256
+    1023, 1036, 1048, 1061, 1073, 1086, 1098, 1111, 1123, 1136, 1148, 1161, 1173, 1186, 1198, 1210,
+    1223, 1235, 1247, 1259, 1272, 1284, 1296, 1308, 1320, 1332, 1344, 1356, 1368, 1380, 1391, 1403,
+    1415, 1426, 1438, 1449, 1461, 1472, 1483, 1494, 1505, 1517, 1527, 1538, 1549, 1560, 1571, 1581,
+    1592, 1602, 1612, 1623, 1633, 1643, 1653, 1663, 1672, 1682, 1692, 1701, 1710, 1720, 1729, 1738,
+    1747, 1756, 1764, 1773, 1781, 1790, 1798, 1806, 1814, 1822, 1830, 1838, 1845, 1853, 1860, 1867,
+    1874, 1881, 1888, 1894, 1901, 1907, 1914, 1920, 1926, 1931, 1937, 1943, 1948, 1954, 1959, 1964,
+    1969, 1973, 1978, 1982, 1987, 1991, 1995, 1999, 2002, 2006, 2009, 2013, 2016, 2019, 2022, 2024,
+    2027, 2029, 2031, 2034, 2035, 2037, 2039, 2040, 2042, 2043, 2044, 2045, 2045, 2046, 2046, 2046,
+    2047, 2046, 2046, 2046, 2045, 2045, 2044, 2043, 2042, 2040, 2039, 2037, 2035, 2034, 2031, 2029,
+    2027, 2024, 2022, 2019, 2016, 2013, 2009, 2006, 2002, 1999, 1995, 1991, 1987, 1982, 1978, 1973,
+    1969, 1964, 1959, 1954, 1948, 1943, 1937, 1931, 1926, 1920, 1914, 1907, 1901, 1894, 1888, 1881,
+    1874, 1867, 1860, 1853, 1845, 1838, 1830, 1822, 1814, 1806, 1798, 1790, 1781, 1773, 1764, 1756,
+    1747, 1738, 1729, 1720, 1710, 1701, 1692, 1682, 1672, 1663, 1653, 1643, 1633, 1623, 1612, 1602,
+    1592, 1581, 1571, 1560, 1549, 1538, 1527, 1517, 1505, 1494, 1483, 1472, 1461, 1449, 1438, 1426,
+    1415, 1403, 1391, 1380, 1368, 1356, 1344, 1332, 1320, 1308, 1296, 1284, 1272, 1259, 1247, 1235,
+    1223, 1210, 1198, 1186, 1173, 1161, 1148, 1136, 1123, 1111, 1098, 1086, 1073, 1061, 1048, 1036,
+    1023, 1010, 998, 985, 973, 960, 948, 935, 923, 910, 898, 885, 873, 860, 848, 836,
+    823, 811, 799, 787, 774, 762, 750, 738, 726, 714, 702, 690, 678, 666, 655, 643,
+    631, 620, 608, 597, 585, 574, 563, 552, 541, 529, 519, 508, 497, 486, 475, 465,
+    454, 444, 434, 423, 413, 403, 393, 383, 374, 364, 354, 345, 336, 326, 317, 308,
+    299, 290, 282, 273, 265, 256, 248, 240, 232, 224, 216, 208, 201, 193, 186, 179,
+    172, 165, 158, 152, 145, 139, 132, 126, 120, 115, 109, 103, 98, 92, 87, 82,
+    77, 73, 68, 64, 59, 55, 51, 47, 44, 40, 37, 33, 30, 27, 24, 22,
+    19, 17, 15, 12, 11, 9, 7, 6, 4, 3, 2, 1, 1, 0, 0, 0,
+    0, 0, 0, 0, 1, 1, 2, 3, 4, 6, 7, 9, 11, 12, 15, 17,
+    19, 22, 24, 27, 30, 33, 37, 40, 44, 47, 51, 55, 59, 64, 68, 73,
+    77, 82, 87, 92, 98, 103, 109, 115, 120, 126, 132, 139, 145, 152, 158, 165,
+    172, 179, 186, 193, 201, 208, 216, 224, 232, 240, 248, 256, 265, 273, 282, 290,
+    299, 308, 317, 326, 336, 345, 354, 364, 374, 383, 393, 403, 413, 423, 434, 444,
+    454, 465, 475, 486, 497, 508, 519, 529, 541, 552, 563, 574, 585, 597, 608, 620,
+    631, 643, 655, 666, 678, 690, 702, 714, 726, 738, 750, 762, 774, 787, 799, 811,
+    823, 836, 848, 860, 873, 885, 898, 910, 923, 935, 948, 960, 973, 985, 998, 1010,
+    // 256 samples, harmonics 1 - 128
+    1023, 1048, 1073, 1098, 1123, 1148, 1173, 1198, 1223, 1247, 1272, 1296, 1320, 1344, 1368, 1391,
+    1415, 1438, 1461, 1483, 1505, 1527, 1549, 1571, 1592, 1612, 1633, 1653, 1672, 1692, 1710, 1729,
+    1747, 1764, 1781, 1798, 1814, 1830, 1845, 1860, 1874, 1888, 1901, 1914, 1926, 1937, 1948, 1959,
+    1969, 1978, 1987, 1995, 2002, 2009, 2016, 2022, 2027, 2031, 2035, 2039, 2042, 2044, 2045, 2046,
+    2047, 2046, 2045, 2044, 2042, 2039, 2035, 2031, 2027, 2022, 2016, 2009, 2002, 1995, 1987, 1978,
+    1969, 1959, 1948, 1937, 1926, 1914, 1901, 1888, 1874, 1860, 1845, 1830, 1814, 1798, 1781, 1764,
+    1747, 1729, 1710, 1692, 1672, 1653, 1633, 1612, 1592, 1571, 1549, 1527, 1505, 1483, 1461, 1438,
+    1415, 1391, 1368, 1344, 1320, 1296, 1272, 1247, 1223, 1198, 1173, 1148, 1123, 1098, 1073, 1048,
+    1023, 998, 973, 948, 923, 898, 873, 848, 823, 799, 774, 750, 726, 702, 678, 655,
+    631, 608, 585, 563, 541, 519, 497, 475, 454, 434, 413, 393, 374, 354, 336, 317,
+    299, 282, 265, 248, 232, 216, 201, 186, 172, 158, 145, 132, 120, 109, 98, 87,
+    77, 68, 59, 51, 44, 37, 30, 24, 19, 15, 11, 7, 4, 2, 1, 0,
+    0, 0, 1, 2, 4, 7, 11, 15, 19, 24, 30, 37, 44, 51, 59, 68,
+    77, 87, 98, 109, 120, 132, 145, 158, 172, 186, 201, 216, 232, 248, 265, 282,
+    299, 317, 336, 354, 374, 393, 413, 434, 454, 475, 497, 519, 541, 563, 585, 608,
+    631, 655, 678, 702, 726, 750, 774, 799, 823, 848, 873, 898, 923, 948, 973, 998,
+    // 128 samples, harmonics 1 - 64
+    1023, 1073, 1123, 1173, 1223, 1272, 1320, 1368, 1415, 1461, 1505, 1549, 1592, 1633, 1672, 1710,
+    1747, 1781, 1814, 1845, 1874, 1901, 1926, 1948, 1969, 1987, 2002, 2016, 2027, 2035, 2042, 2045,
+    2047, 2045, 2042, 2035, 2027, 2016, 2002, 1987, 1969, 1948, 1926, 1901, 1874, 1845, 1814, 1781,
+    1747, 1710, 1672, 1633, 1592, 1549, 1505, 1461, 1415, 1368, 1320, 1272, 1223, 1173, 1123, 1073,
+    1023, 973, 923, 873, 823, 774, 726, 678, 631, 585, 541, 497, 454, 413, 374, 336,
+    299, 265, 232, 201, 172, 145, 120, 98, 77, 59, 44, 30, 19, 11, 4, 1,
+    0, 1, 4, 11, 19, 30, 44, 59, 77, 98, 120, 145, 172, 201, 232, 265,
+    299, 336, 374, 413, 454, 497, 541, 585, 631, 678, 726, 774, 823, 873, 923, 973,
+    // 64 samples, harmonics 1 - 32
+    1023, 1123, 1223, 1320, 1415, 1505, 1592, 1672, 1747, 1814, 1874, 1926, 1969, 2002, 2027, 2042,
+    2047, 2042, 2027, 2002, 1969, 1926, 1874, 1814, 1747, 1672, 1592, 1505, 1415, 1320, 1223, 1123,
+    1023, 923, 823, 726, 631, 541, 454, 374, 299, 232, 172, 120, 77, 44, 19, 4,
+    0, 4, 19, 44, 77, 120, 172, 232, 299, 374, 454, 541, 631, 726, 823, 923,
+    // 32 samples, harmonics 1 - 16
+    1023, 1223, 1415, 1592, 1747, 1874, 1969, 2027, 2047, 2027, 1969, 1874, 1747, 1592, 1415, 1223,
+    1023, 823, 631, 454, 299, 172, 77, 19, 0, 19, 77, 172, 299, 454, 631, 823,
+    // 32 samples, harmonics 1 - 8
+    1023, 1223, 1415, 1592, 1747, 1874, 1969, 2027, 2047, 2027, 1969, 1874, 1747, 1592, 1415, 1223,
+    1023, 823, 631, 454, 299, 172, 77, 19, 0, 19, 77, 172, 299, 454, 631, 823,
+    // 32 samples, harmonics 1 - 4
+    1023, 1223, 1415, 1592, 1747, 1874, 1969, 2027, 2047, 2027, 1969, 1874, 1747, 1592, 1415, 1223,
+    1023, 823, 631, 454, 299, 172, 77, 19, 0, 19, 77, 172, 299, 454, 631, 823,
+    // 32 samples, harmonics 1 - 2
+    1023, 1223, 1415, 1592, 1747, 1874, 1969, 2027, 2047, 2027, 1969, 1874, 1747, 1592, 1415, 1223,
+    1023, 823, 631, 454, 299, 172, 77, 19, 0, 19, 77, 172, 299, 454, 631, 823,
+    // 32 samples, harmonics 1 - 1
+    1023, 1223, 1415, 1592, 1747, 1874, 1969, 2027, 2047, 2027, 1969, 1874, 1747, 1592, 1415, 1223,
+    1023, 823, 631, 454, 299, 172, 77, 19, 0, 19, 77, 172, 299, 454, 631, 823
+  },
+  // square
+  {
+    // 512 samples, harmonics 1 - 256
+    1023, 2047, 1807, 1949, 1848, 1926, 1862, 1916, 1869, 1911, 1874, 1907, 1876, 1905, 1879, 1903,
+    1880, 1902, 1881, 1900, 1882, 1900, 1883, 1899, 1884, 1898, 1884, 1898, 1885, 1897, 1885, 1897,
+    1885, 1897, 1886, 1896, 1886, 1896, 1886, 1896, 1887, 1896, 1887, 1895, 1887, 1895, 1887, 1895,
+    1887, 1895, 1887, 1895, 1887, 1895, 1888, 1895, 1888, 1894, 1888, 1894, 1888, 1894, 1888, 1894,
+    1888, 1894, 1888, 1894, 1888, 1894, 1888, 1894, 1888, 1894, 1888, 1894, 1888, 1894, 1888, 1894,
+    1889, 1894, 1889, 1894, 1889, 1894, 1889, 1894, 1889, 1894, 1889, 1894, 1889, 1893, 1889, 1893,
+    1889, 1893, 1889, 1893, 1889, 1893, 1889, 1893, 1889, 1893, 1889, 1893, 1889, 1893, 1889, 1893,
+    1889, 1893, 1889, 1893, 1889, 1893, 1889, 1893, 1889, 1893, 1889, 1893, 1889, 1893, 1889, 1893,
+    1889, 1893, 1889, 1893, 1889, 1893, 1889, 1893, 1889, 1893, 1889, 1893, 1889, 1893, 1889, 1893,
+    1889, 1893, 1889, 1893, 1889, 1893, 1889, 1893, 1889, 1893, 1889, 1893, 1889, 1893, 1889, 1893,
+    1889, 1893, 1889, 1893, 1889, 1894, 1889, 1894, 1889, 1894, 1889, 1894, 1889, 1894, 1889, 1894,
+    1889, 1894, 1888, 1894, 1888, 1894, 1888, 1894, 1888, 1894, 1888, 1894, 1888, 1894, 1888, 1894,
+    1888, 1894, 1888, 1894, 1888, 1894, 1888, 1894, 1888, 1895, 1888, 1895, 1887, 1895, 1887, 1895,
+    1887, 1895, 1887, 1895, 1887, 1895, 1887, 1896, 1887, 1896, 1886, 1896, 1886, 1896, 1886, 1897,
+    1885, 1897, 1885, 1897, 1885, 1898, 1884, 1898, 1884, 1899, 1883, 1900, 1882, 1900, 1881, 1902,
+    1880, 1903, 1879, 1905, 1876, 1907, 1874, 1911, 1869, 1916, 1862, 1926, 1848, 1949, 1807, 2046,
+    1023, 0, 239, 97, 198, 120, 184, 130, 177, 135, 172, 139, 170, 141, 167, 143,
+    166, 144, 165, 146, 164, 146, 163, 147, 162, 148, 162, 148, 161, 149, 161, 149,
+    161, 149, 160, 150, 160, 150, 160, 150, 159, 150, 159, 151, 159, 151, 159, 151,
+    159, 151, 159, 151, 159, 151, 158, 151, 158, 152, 158, 152, 158, 152, 158, 152,
+    158, 152, 158, 152, 158, 152, 158, 152, 158, 152, 158, 152, 158, 152, 158, 152,
+    157, 152, 157, 152, 157, 152, 157, 152, 157, 152, 157, 152, 157, 153, 157, 153,
+    157, 153, 157, 153, 157, 153, 157, 153, 157, 153, 157, 153, 157, 153, 157, 153,
+    157, 153, 157, 153, 157, 153, 157, 153, 157, 153, 157, 153, 157, 153, 157, 153,
+    157, 153, 157, 153, 157, 153, 157, 153, 157, 153, 157, 153, 157, 153, 157, 153,
+    157, 153, 157, 153, 157, 153, 157, 153, 157, 153, 157, 153, 157, 153, 157, 153,
+    157, 153, 157, 153, 157, 152, 157, 152, 157, 152, 157, 152, 157, 152, 157, 152,
+    157, 152, 158, 152, 158, 152, 158, 152, 158, 152, 158, 152, 158, 152, 158, 152,
+    158, 152, 158, 152, 158, 152, 158, 152, 158, 151, 158, 151, 159, 151, 159, 151,
+    159, 151, 159, 151, 159, 151, 159, 150, 159, 150, 160, 150, 160, 150, 160, 149,
+    161, 149, 161, 149, 161, 148, 162, 148, 162, 147, 163, 146, 164, 146, 165, 144,
+    166, 143, 167, 141, 170, 139, 172, 135, 177, 130, 184, 120, 198, 97, 239, 0,
+    // 256 samples, harmonics 1 - 128
+    1023, 2046, 1807, 1949, 1848, 1926, 1862, 1916, 1869, 1911, 1873, 1907, 1876, 1905, 1878, 1903,
+    1880, 1902, 1881, 1901, 1882, 1900, 1883, 1899, 1883, 1899, 1884, 1898, 1884, 1898, 1885, 1897,
+    1885, 1897, 1885, 1897, 1886, 1897, 1886, 1896, 1886, 1896, 1886, 1896, 1886, 1896, 1886, 1896,
+    1886, 1896, 1887, 1896, 1887, 1896, 1887, 1896, 1887, 1895, 1887, 1895, 1887, 1895, 1887, 1895,
+    1887, 1895, 1887, 1895, 1887, 1895, 1887, 1895, 1887, 1896, 1887, 1896, 1887, 1896, 1887, 1896,
+    1886, 1896, 1886, 1896, 1886, 1896, 1886, 1896, 1886, 1896, 1886, 1897, 1886, 1897, 1885, 1897,
+    1885, 1897, 1885, 1898, 1884, 1898, 1884, 1899, 1883, 1899, 1883, 1900, 1882, 1901, 1881, 1902,
+    1880, 1903, 1878, 1905, 1876, 1907, 1873, 1911, 1869, 1916, 1862, 1926, 1848, 1949, 1807, 2047,
+    1023, 0, 239, 97, 198, 120, 184, 130, 177, 135, 173, 139, 170, 141, 168, 143,
+    166, 144, 165, 145, 164, 146, 163, 147, 163, 147, 162, 148, 162, 148, 161, 149,
+    161, 149, 161, 149, 160, 149, 160, 150, 160, 150, 160, 150, 160, 150, 160, 150,
+    160, 150, 159, 150, 159, 150, 159, 150, 159, 151, 159, 151, 159, 151, 159, 151,
+    159, 151, 159, 151, 159, 151, 159, 151, 159, 150, 159, 150, 159, 150, 159, 150,
+    160, 150, 160, 150, 160, 150, 160, 150, 160, 150, 160, 149, 160, 149, 161, 149,
+    161, 149, 161, 148, 162, 148, 162, 147, 163, 147, 163, 146, 164, 145, 165, 144,
+    166, 143, 168, 141, 170, 139, 173, 135, 177, 130, 184, 120, 198, 97, 239, 0,
+    // 128 samples, harmonics 1 - 64
+    1023, 2046, 1807, 1949, 1847, 1926, 1861, 1917, 1869, 1911, 1873, 1908, 1876, 1906, 1877, 1904,
+    1879, 1903, 1880, 1902, 1881, 1901, 1881, 1901, 1882, 1900, 1882, 1900, 1882, 1900, 1882, 1900,
+    1882, 1900, 1882, 1900, 1882, 1900, 1882, 1900, 1882, 1901, 1881, 1901, 1881, 1902, 1880, 1903,
+    1879, 1904, 1877, 1906, 1876, 1908, 1873, 1911, 1869, 1917, 1861, 1926, 1847, 1949, 1807, 2047,
+    1023, 0, 239, 97, 199, 120, 185, 129, 177, 135, 173, 138, 170, 140, 169, 142,
+    167, 143, 166, 144, 165, 145, 165, 145, 164, 146, 164, 146, 164, 146, 164, 146,
+    164, 146, 164, 146, 164, 146, 164, 146, 164, 145, 165, 145, 165, 144, 166, 143,
+    167, 142, 169, 140, 170, 138, 173, 135, 177, 129, 185, 120, 199, 97, 239, 0,
+    // 64 samples, harmonics 1 - 32
+    1023, 2046, 1806, 1949, 1846, 1927, 1860, 1918, 1867, 1913, 1870, 1910, 1872, 1909, 1873, 1908,
+    1874, 1908, 1873, 1909, 1872, 1910, 1870, 1913, 1867, 1918, 1860, 1927, 1846, 1949, 1806, 2047,
+    1023, 0, 240, 97, 200, 119, 186, 128, 179, 133, 176, 136, 174, 137, 173, 138,
+    172, 138, 173, 137, 174, 136, 176, 133, 179, 128, 186, 119, 200, 97, 240, 0,
+    // 32 samples, harmonics 1 - 16
+    1023, 2047, 1804, 1951, 1842, 1931, 1853, 1925, 1856, 1925, 1853, 1931, 1842, 1951, 1804, 2046,
+    1023, 0, 242, 95, 204, 115, 193, 121, 190, 121, 193, 115, 204, 95, 242, 0,
+    // 32 samples, harmonics 1 - 8
+    1023, 1779, 2047, 1906, 1794, 1881, 1960, 1889, 1820, 1889, 1960, 1881, 1794, 1906, 2046, 1779,
+    1023, 267, 0, 140, 252, 165, 86, 157, 226, 157, 86, 165, 252, 140, 0, 267,
+    // 32 samples, harmonics 1 - 4
+    1023, 1436, 1773, 1981, 2047, 1996, 1887, 1787, 1747, 1787, 1887, 1996, 2047, 1981, 1773, 1436,
+    1023, 610, 273, 65, 0, 50, 159, 259, 299, 259, 159, 50, 0, 65, 273, 610,
+    // 32 samples, harmonics 1 - 2
+    1023, 1223, 1415, 1592, 1747, 1874, 1969, 2027, 2047, 2027, 1969, 1874, 1747, 1592, 1415, 1223,
+    1023, 823, 631, 454, 299, 172, 77, 19, 0, 19, 77, 172, 299, 454, 631, 823,
+    // 32 samples, harmonics 1 - 1
+    1023, 1223, 1415, 1592, 1747, 1874, 1969, 2027, 2047, 2027, 1969, 1874, 1747, 1592, 1415, 1223,
+    1023, 823, 631, 454, 299, 172, 77, 19, 0, 19, 77, 172, 299, 454, 631, 823
+  },
+  // saw
+  {
+    // 512 samples, harmonics 1 - 256
+    1023, 2047, 1803, 1941, 1837, 1912, 1844, 1895, 1845, 1883, 1842, 1873, 1839, 1863, 1834, 1855,
+    1829, 1847, 1823, 1839, 1817, 1831, 1811, 1823, 1805, 1816, 1799, 1809, 1793, 1801, 1786, 1794,
+    1780, 1787, 1773, 1780, 1767, 1773, 1760, 1766, 1754, 1759, 1747, 1752, 1740, 1745, 1734, 1738,
+    1727, 1731, 1720, 1724, 1714, 1717, 1707, 1710, 1700, 1703, 1694, 1696, 1687, 1689, 1680, 1682,
+    1674, 1675, 1667, 1669, 1660, 1662, 1653, 1655, 1647, 1648, 1640, 1641, 1633, 1634, 1627, 1627,
+    1620, 1620, 1613, 1614, 1606, 1607, 1600, 1600, 1593, 1593, 1586, 1586, 1579, 1579, 1573, 1572,
+    1566, 1566, 1559, 1559, 1552, 1552, 1545, 1545, 1539, 1538, 1532, 1531, 1525, 1525, 1518, 1518,
+    1512, 1511, 1505, 1504, 1498, 1497, 1491, 1490, 1485, 1484, 1478, 1477, 1471, 1470, 1464, 1463,
+    1457, 1456, 1451, 1449, 1444, 1443, 1437, 1436, 1430, 1429, 1424, 1422, 1417, 1415, 1410, 1408,
+    1403, 1402, 1396, 1395, 1390, 1388, 1383, 1381, 1376, 1374, 1369, 1367, 1362, 1361, 1356, 1354,
+    1349, 1347, 1342, 1340, 1335, 1333, 1329, 1326, 1322, 1320, 1315, 1313, 1308, 1306, 1301, 1299,
+    1295, 1292, 1288, 1286, 1281, 1279, 1274, 1272, 1267, 1265, 1261, 1258, 1254, 1251, 1247, 1245,
+    1240, 1238, 1234, 1231, 1227, 1224, 1220, 1217, 1213, 1211, 1206, 1204, 1200, 1197, 1193, 1190,
+    1186, 1183, 1179, 1176, 1172, 1170, 1166, 1163, 1159, 1156, 1152, 1149, 1145, 1142, 1138, 1136,
+    1132, 1129, 1125, 1122, 1118, 1115, 1111, 1108, 1104, 1101, 1098, 1095, 1091, 1088, 1084, 1081,
+    1077, 1074, 1071, 1067, 1064, 1060, 1057, 1054, 1050, 1047, 1043, 1040, 1037, 1033, 1030, 1026,
+    1023, 1020, 1016, 1013, 1009, 1006, 1003, 999, 996, 992, 989, 986, 982, 979, 975, 972,
+    969, 965, 962, 958, 955, 951, 948, 945, 942, 938, 935, 931, 928, 924, 921, 917,
+    914, 910, 908, 904, 901, 897, 894, 890, 887, 883, 880, 876, 874, 870, 867, 863,
+    860, 856, 853, 849, 846, 842, 840, 835, 833, 829, 826, 822, 819, 815, 812, 808,
+    806, 801, 799, 795, 792, 788, 785, 781, 779, 774, 772, 767, 765, 760, 758, 754,
+    751, 747, 745, 740, 738, 733, 731, 726, 724, 720, 717, 713, 711, 706, 704, 699,
+    697, 692, 690, 685, 684, 679, 677, 672, 670, 665, 663, 658, 656, 651, 650, 644,
+    643, 638, 636, 631, 629, 624, 622, 617, 616, 610, 609, 603, 602, 597, 595, 590,
+    589, 583, 582, 576, 575, 569, 568, 562, 561, 556, 555, 549, 548, 542, 541, 535,
+    534, 528, 528, 521, 521, 515, 514, 508, 507, 501, 501, 494, 494, 487, 487, 480,
+    480, 474, 473, 467, 467, 460, 460, 453, 453, 446, 446, 439, 440, 432, 433, 426,
+    426, 419, 419, 412, 413, 405, 406, 398, 399, 391, 393, 384, 386, 377, 379, 371,
+    372, 364, 366, 357, 359, 350, 352, 343, 346, 336, 339, 329, 332, 322, 326, 315,
+    319, 308, 312, 301, 306, 294, 299, 287, 292, 280, 286, 273, 279, 266, 273, 259,
+    266, 252, 260, 245, 253, 237, 247, 230, 241, 223, 235, 215, 229, 207, 223, 199,
+    217, 191, 212, 183, 207, 173, 204, 163, 201, 151, 202, 134, 209, 105, 243, 0,
+    // 256 samples, harmonics 1 - 128
+    1023, 2047, 1798, 1934, 1826, 1898, 1827, 1874, 1820, 1855, 1811, 1838, 1800, 1822, 1789, 1806,
+    1777, 1791, 1764, 1776, 1752, 1762, 1739, 1747, 1726, 1733, 1713, 1719, 1700, 1705, 1686, 1691,
+    1673, 1677, 1660, 1663, 1647, 1649, 1633, 1635, 1620, 1621, 1606, 1607, 1593, 1593, 1579, 1579,
+    1566, 1566, 1552, 1552, 1539, 1538, 1525, 1524, 1512, 1510, 1498, 1497, 1485, 1483, 1471, 1469,
+    1458, 1455, 1444, 1441, 1431, 1428, 1417, 1414, 1404, 1400, 1390, 1387, 1376, 1373, 1363, 1359,
+    1349, 1345, 1336, 1332, 1322, 1318, 1309, 1304, 1295, 1290, 1281, 1277, 1268, 1263, 1254, 1249,
+    1241, 1236, 1227, 1222, 1213, 1208, 1200, 1194, 1186, 1181, 1173, 1167, 1159, 1153, 1145, 1140,
+    1132, 1126, 1118, 1112, 1105, 1098, 1091, 1085, 1077, 1071, 1064, 1057, 1050, 1044, 1037, 1030,
+    1023, 1016, 1009, 1002, 996, 989, 982, 975, 969, 961, 955, 948, 941, 934, 928, 920,
+    914, 906, 901, 893, 887, 879, 873, 865, 860, 852, 846, 838, 833, 824, 819, 810,
+    805, 797, 792, 783, 778, 769, 765, 756, 751, 742, 737, 728, 724, 714, 710, 701,
+    697, 687, 683, 673, 670, 659, 656, 646, 642, 632, 629, 618, 615, 605, 602, 591,
+    588, 577, 575, 563, 561, 549, 548, 536, 534, 522, 521, 508, 507, 494, 494, 480,
+    480, 467, 467, 453, 453, 439, 440, 425, 426, 411, 413, 397, 399, 383, 386, 369,
+    373, 355, 360, 341, 346, 327, 333, 313, 320, 299, 307, 284, 294, 270, 282, 255,
+    269, 240, 257, 224, 246, 208, 235, 191, 226, 172, 219, 148, 220, 112, 248, 0,
+    // 128 samples, harmonics 1 - 64
+    1023, 2047, 1790, 1920, 1804, 1869, 1791, 1832, 1771, 1799, 1748, 1767, 1723, 1737, 1698, 1708,
+    1672, 1679, 1646, 1650, 1620, 1622, 1593, 1594, 1566, 1565, 1539, 1537, 1513, 1509, 1486, 1481,
+    1459, 1453, 1431, 1425, 1404, 1398, 1377, 1370, 1350, 1342, 1323, 1314, 1296, 1286, 1268, 1259,
+    1241, 1231, 1214, 1203, 1187, 1175, 1159, 1148, 1132, 1120, 1105, 1092, 1078, 1065, 1050, 1037,
+    1023, 1009, 996, 981, 968, 954, 941, 926, 914, 898, 887, 871, 859, 843, 832, 815,
+    805, 787, 778, 760, 750, 732, 723, 704, 696, 676, 669, 648, 642, 621, 615, 593,
+    587, 565, 560, 537, 533, 509, 507, 481, 480, 452, 453, 424, 426, 396, 400, 367,
+    374, 338, 348, 309, 323, 279, 298, 247, 275, 214, 255, 177, 242, 126, 256, 0,
+    // 64 samples, harmonics 1 - 32
+    1023, 2047, 1773, 1890, 1759, 1811, 1719, 1744, 1671, 1683, 1620, 1623, 1567, 1565, 1514, 1507,
+    1460, 1449, 1406, 1392, 1352, 1335, 1297, 1278, 1242, 1221, 1188, 1165, 1133, 1108, 1078, 1051,
+    1023, 995, 968, 938, 913, 881, 858, 825, 804, 768, 749, 711, 694, 654, 640, 597,
+    586, 539, 532, 481, 479, 423, 426, 363, 375, 302, 327, 235, 287, 156, 273, 0,
+    // 32 samples, harmonics 1 - 16
+    1023, 2047, 1738, 1827, 1667, 1687, 1569, 1561, 1463, 1439, 1355, 1319, 1245, 1201, 1134, 1082,
+    1023, 964, 912, 845, 801, 727, 691, 607, 583, 485, 477, 359, 379, 219, 308, 0,
+    // 32 samples, harmonics 1 - 8
+    1023, 1850, 2047, 1799, 1664, 1721, 1688, 1538, 1472, 1484, 1414, 1292, 1250, 1242, 1152, 1048,
+    1023, 998, 894, 804, 796, 754, 632, 562, 574, 508, 358, 325, 382, 247, 0, 196,
+    // 32 samples, harmonics 1 - 4
+    1023, 1527, 1894, 2047, 1994, 1818, 1628, 1506, 1472, 1487, 1489, 1434, 1321, 1187, 1082, 1031,
+    1023, 1015, 964, 859, 725, 612, 557, 559, 574, 540, 418, 228, 52, 0, 152, 519,
+    // 32 samples, harmonics 1 - 2
+    1023, 1329, 1606, 1828, 1978, 2047, 2034, 1951, 1814, 1648, 1474, 1315, 1187, 1097, 1046, 1026,
+    1023, 1020, 1000, 949, 859, 731, 572, 398, 232, 95, 12, 0, 68, 218, 440, 717,
+    // 32 samples, harmonics 1 - 1
+    1023, 1223, 1415, 1592, 1747, 1874, 1969, 2027, 2047, 2027, 1969, 1874, 1747, 1592, 1415, 1223,
+    1023, 823, 631, 454, 299, 172, 77, 19, 0, 19, 77, 172, 299, 454, 631, 823
+  }
+};